@@ -106,24 +106,23 @@ void translate_TAC_to_assembly(SymbolTable *sym_table) {
 
     // Write data section
     fprintf(asm_fp, ".data\n");
-    Symbol *current_sym = sym_table->head;
-    while (current_sym != NULL) {
+    for (int index = sym_table->count - 1; index >= 0; index--) {
+        Symbol *current_sym = &sym_table->symbols[index];
         if (!current_sym->is_function) {
             if (current_sym->is_array) {
-                fprintf(asm_fp, "%s: .word ", current_sym->name);
+                fprintf(asm_fp, "%s: .word ", symbol_name(sym_table, current_sym));
                 int total_size = 1;
                 for (int i = 0; i < current_sym->num_dimensions; i++) {
-                    total_size *= current_sym->sizes[i];
+                    total_size *= symbol_sizes(sym_table, current_sym)[i];
                 }
                 for (int i = 0; i < total_size; i++) {
                     fprintf(asm_fp, "0%s", i < total_size - 1 ? ", " : "");
                 }
                 fprintf(asm_fp, "\n");
             } else {
-                fprintf(asm_fp, "%s: .word 0\n", current_sym->name);
+                fprintf(asm_fp, "%s: .word 0\n", symbol_name(sym_table, current_sym));
             }
         }
-        current_sym = current_sym->next;
     }
 
     // Write text section
@@ -35,7 +35,7 @@ bool perform_semantic_analysis(ASTNode *root, SymbolTable *sym_table) {
             fprintf(stderr, "Semantic Error: Undeclared variable '%s'.\n", root->value);
             exit(1);
         }
-        const char *var_type = sym->type;
+        const char *var_type = symbol_type_name(sym->type);
 
         // Check if it's an array declaration by inspecting the left child for "ArraySizes"
         if (root->left && strcmp(root->left->node_type, "ArraySizes") == 0) {
@@ -90,12 +90,12 @@ bool perform_semantic_analysis(ASTNode *root, SymbolTable *sym_table) {
         if (strcmp(root->node_type, "Assignment") == 0) {
             var_name = root->value;
             Symbol *sym = get_symbol(sym_table, var_name);
-            var_type = sym->type;
+            var_type = symbol_type_name(sym->type);
         }
         else { // ArrayAssignment
             var_name = root->value;
             Symbol *sym = get_symbol(sym_table, var_name);
-            var_type = sym->type;
+            var_type = symbol_type_name(sym->type);
         }
 
         // Determine the type of the expression
@@ -153,7 +153,7 @@ const char* get_expression_type(ASTNode *node, SymbolTable *sym_table) {
             fprintf(stderr, "Semantic Error: Undeclared identifier '%s'.\n", node->value);
             exit(1);
         }
-        return sym->type;
+        return symbol_type_name(sym->type);
     }
     else if (strcmp(node->node_type, "ArrayAccess") == 0) {
         Symbol *sym = get_symbol(sym_table, node->value);
@@ -161,7 +161,7 @@ const char* get_expression_type(ASTNode *node, SymbolTable *sym_table) {
             fprintf(stderr, "Semantic Error: Undeclared array '%s'.\n", node->value);
             exit(1);
         }
-        return sym->type;
+        return symbol_type_name(sym->type);
     }
     else if (strcmp(node->node_type, "BinaryOp") == 0) {
         const char *left_type = get_expression_type(node->left, sym_table);
@@ -180,7 +180,7 @@ const char* get_expression_type(ASTNode *node, SymbolTable *sym_table) {
             fprintf(stderr, "Semantic Error: Undeclared function '%s'.\n", node->value);
             exit(1);
         }
-        return sym->type;
+        return symbol_type_name(sym->type);
     }
     else if (strcmp(node->node_type, "ArrayInit") == 0) {
         // Determine the type based on the first element
@@ -5,212 +5,249 @@
 #include <string.h>
 #include <stdio.h>
 
-/* Creates a new, empty symbol table */
-SymbolTable *create_symbol_table()
+/* FNV-1a hash of a name */
+static uint32_t hash_name(const char *name)
 {
-    SymbolTable *table = (SymbolTable *)malloc(sizeof(SymbolTable));
-    if (!table)
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++)
+        hash = (hash ^ *p) * 16777619u;
+    return hash;
+}
+
+/* Grows '*array' of 'element' sized items to hold at least 'needed' */
+static void reserve(void **array, uint32_t *capacity, uint32_t needed, size_t element)
+{
+    if (needed <= *capacity)
+        return;
+    uint32_t grown = *capacity ? *capacity : 64;
+    while (grown < needed)
+        grown *= 2;
+    void *memory = realloc(*array, element * grown);
+    if (!memory)
     {
         fprintf(stderr, "Memory allocation failed for SymbolTable.\n");
         exit(1);
     }
-    table->head = NULL;
-    return table;
+    *array = memory;
+    *capacity = grown;
 }
 
-/* Adds a scalar (non-array) variable symbol to the table. Returns false if symbol already exists. */
-bool add_symbol(SymbolTable *table, const char *name, const char *type)
+/* Copies a string into the table's name pool; returns its offset. A name
+   that does not fit in the last block starts a new one, which is larger
+   than NAME_BLOCK_SIZE if the name is. */
+static uint32_t intern_name(SymbolTable *table, const char *name)
 {
-    // Check if symbol already exists
-    Symbol *current = table->head;
-    while (current != NULL)
+    size_t length = strlen(name) + 1;
+    if (table->name_block_count == 0 || NAME_BLOCK_SIZE - table->name_used < length)
     {
-        if (strcmp(current->name, name) == 0)
-            return false; // Symbol already exists
-        current = current->next;
+        size_t size = length > NAME_BLOCK_SIZE ? length : NAME_BLOCK_SIZE;
+        char **blocks = (char **)realloc(table->name_blocks, sizeof(char *) * (table->name_block_count + 1));
+        char *block = (char *)malloc(size);
+        if (!blocks || !block)
+        {
+            fprintf(stderr, "Memory allocation failed for Symbol.\n");
+            exit(1);
+        }
+        blocks[table->name_block_count++] = block;
+        table->name_blocks = blocks;
+        table->name_used = 0;
     }
+    uint32_t offset = (table->name_block_count - 1) * NAME_BLOCK_SIZE + table->name_used;
+    memcpy(table->name_blocks[table->name_block_count - 1] + table->name_used, name, length);
+    table->name_used = length > NAME_BLOCK_SIZE ? NAME_BLOCK_SIZE : table->name_used + length;
+    return offset;
+}
 
-    // Create new symbol
-    Symbol *new_symbol = (Symbol *)malloc(sizeof(Symbol));
-    if (!new_symbol)
-    {
-        fprintf(stderr, "Memory allocation failed for Symbol.\n");
-        exit(1);
-    }
-    new_symbol->name = strdup(name);
-    new_symbol->type = strdup(type);
-    new_symbol->is_array = false;
-    new_symbol->is_function = false;
-    new_symbol->initialized = false;
-    new_symbol->num_dimensions = 0;
-    memset(new_symbol->sizes, 0, sizeof(new_symbol->sizes));
-    new_symbol->num_parameters = 0;
-    memset(new_symbol->parameters, 0, sizeof(new_symbol->parameters));
-    new_symbol->next = table->head;
-    table->head = new_symbol;
-    return true;
+static const char *name_at(const SymbolTable *table, uint32_t offset)
+{
+    return table->name_blocks[offset / NAME_BLOCK_SIZE] + offset % NAME_BLOCK_SIZE;
 }
 
-/* Adds an array variable symbol to the table. Returns false if symbol already exists. */
-bool add_array_symbol(SymbolTable *table, const char *name, const char *type, int num_dimensions, int sizes[])
+static SymbolType type_from_name(const char *type)
 {
-    // Check if symbol already exists
-    Symbol *current = table->head;
-    while (current != NULL)
+    if (strcmp(type, "float") == 0)
+        return SYMBOL_FLOAT;
+    if (strcmp(type, "char") == 0)
+        return SYMBOL_CHAR;
+    return SYMBOL_INT;
+}
+
+/* The slot holding 'name', or the empty slot where it would go */
+static uint32_t *find_slot(const SymbolTable *table, const char *name, uint32_t hash)
+{
+    uint32_t mask = table->slot_count - 1;
+    uint8_t tag = hash >> 24;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask)
     {
-        if (strcmp(current->name, name) == 0)
-            return false; // Symbol already exists
-        current = current->next;
+        uint32_t *slot = &table->slots[i];
+        if (*slot == 0)
+            return slot;
+        const Symbol *sym = &table->symbols[*slot - 1];
+        if (sym->tag == tag && strcmp(name_at(table, sym->name), name) == 0)
+            return slot;
     }
+}
 
-    // Create new symbol
-    Symbol *new_symbol = (Symbol *)malloc(sizeof(Symbol));
-    if (!new_symbol)
+/* Doubles the hash index and puts every symbol back in it */
+static void grow_slots(SymbolTable *table)
+{
+    free(table->slots);
+    table->slot_count = table->slot_count ? table->slot_count * 2 : 64;
+    table->slots = (uint32_t *)calloc(table->slot_count, sizeof(uint32_t));
+    if (!table->slots)
     {
-        fprintf(stderr, "Memory allocation failed for Symbol.\n");
+        fprintf(stderr, "Memory allocation failed for SymbolTable.\n");
         exit(1);
     }
-    new_symbol->name = strdup(name);
-    new_symbol->type = strdup(type);
-    new_symbol->is_array = true;
-    new_symbol->is_function = false;
-    new_symbol->initialized = false;
-    new_symbol->num_dimensions = num_dimensions;
-    for (int i = 0; i < num_dimensions && i < MAX_ARRAY_DIMENSIONS; i++)
-    {
-        new_symbol->sizes[i] = sizes[i];
-    }
-    // Initialize remaining sizes to 0 if any
-    for (int i = num_dimensions; i < MAX_ARRAY_DIMENSIONS; i++)
+    for (int i = 0; i < table->count; i++)
     {
-        new_symbol->sizes[i] = 0;
+        const char *name = name_at(table, table->symbols[i].name);
+        *find_slot(table, name, hash_name(name)) = i + 1;
     }
-    new_symbol->num_parameters = 0;
-    memset(new_symbol->parameters, 0, sizeof(new_symbol->parameters));
-    new_symbol->next = table->head;
-    table->head = new_symbol;
-    return true;
 }
 
-/* Adds a function symbol without parameters to the table. Returns false if symbol already exists. */
-bool add_function_symbol(SymbolTable *table, const char *name, const char *return_type)
+/* Adds a symbol with no sizes or parameters yet. Returns NULL if one of
+   that name already exists. */
+static Symbol *new_symbol(SymbolTable *table, const char *name, const char *type)
 {
+    // Keep the hash index at most three quarters full
+    if (4 * (uint32_t)(table->count + 1) > 3 * table->slot_count)
+        grow_slots(table);
+
     // Check if symbol already exists
-    Symbol *current = table->head;
-    while (current != NULL)
-    {
-        if (strcmp(current->name, name) == 0)
-            return false; // Function already exists
-        current = current->next;
-    }
+    uint32_t hash = hash_name(name);
+    uint32_t *slot = find_slot(table, name, hash);
+    if (*slot != 0)
+        return NULL;
+
+    reserve((void **)&table->symbols, &table->capacity, table->count + 1, sizeof(Symbol));
+
+    Symbol *sym = &table->symbols[table->count];
+    sym->name = intern_name(table, name);
+    sym->tag = hash >> 24;
+    sym->type = type_from_name(type);
+    sym->is_array = false;
+    sym->is_function = false;
+    sym->initialized = false;
+    sym->num_dimensions = 0;
+    sym->details = 0;
+    *slot = ++table->count;
+    return sym;
+}
 
-    // Create new function symbol
-    Symbol *new_symbol = (Symbol *)malloc(sizeof(Symbol));
-    if (!new_symbol)
+/* Creates a new, empty symbol table */
+SymbolTable *create_symbol_table()
+{
+    SymbolTable *table = (SymbolTable *)calloc(1, sizeof(SymbolTable));
+    if (!table)
     {
-        fprintf(stderr, "Memory allocation failed for Function Symbol.\n");
+        fprintf(stderr, "Memory allocation failed for SymbolTable.\n");
         exit(1);
     }
-    new_symbol->name = strdup(name);
-    new_symbol->type = strdup(return_type);
-    new_symbol->is_array = false;
-    new_symbol->is_function = true;
-    new_symbol->initialized = false; // Functions are not variables, so initialized flag can be ignored or used differently
-    new_symbol->num_dimensions = 0;
-    memset(new_symbol->sizes, 0, sizeof(new_symbol->sizes));
-    new_symbol->num_parameters = 0;
-    memset(new_symbol->parameters, 0, sizeof(new_symbol->parameters));
-    new_symbol->next = table->head;
-    table->head = new_symbol;
+    return table;
+}
+
+/* Adds a scalar (non-array) variable symbol to the table. Returns false if symbol already exists. */
+bool add_symbol(SymbolTable *table, const char *name, const char *type)
+{
+    return new_symbol(table, name, type) != NULL;
+}
+
+/* Adds an array variable symbol to the table. Returns false if symbol already exists. */
+bool add_array_symbol(SymbolTable *table, const char *name, const char *type, int num_dimensions, int sizes[])
+{
+    Symbol *sym = new_symbol(table, name, type);
+    if (!sym)
+        return false; // Symbol already exists
+
+    reserve((void **)&table->sizes, &table->size_capacity, table->size_count + num_dimensions, sizeof(int));
+    memcpy(&table->sizes[table->size_count], sizes, sizeof(int) * num_dimensions);
+    sym->is_array = true;
+    sym->num_dimensions = (uint16_t)num_dimensions;
+    sym->details = table->size_count;
+    table->size_count += num_dimensions;
     return true;
 }
 
+/* Adds a function symbol without parameters to the table. Returns false if symbol already exists. */
+bool add_function_symbol(SymbolTable *table, const char *name, const char *return_type)
+{
+    return add_function_symbol_with_params(table, name, return_type, 0, NULL);
+}
+
 /* Adds a function symbol with parameters to the table. Returns false if symbol already exists. */
 bool add_function_symbol_with_params(SymbolTable *table, const char *name, const char *return_type, int num_params, Parameter params[])
 {
-    if (num_params > MAX_FUNCTION_PARAMS)
-    {
-        fprintf(stderr, "Error: Exceeded maximum number of function parameters (%d).\n", MAX_FUNCTION_PARAMS);
-        exit(1);
-    }
+    Symbol *sym = new_symbol(table, name, return_type);
+    if (!sym)
+        return false; // Function already exists
 
-    // Check if symbol already exists
-    Symbol *current = table->head;
-    while (current != NULL)
-    {
-        if (strcmp(current->name, name) == 0)
-            return false; // Function already exists
-        current = current->next;
-    }
-
-    // Create new function symbol
-    Symbol *new_symbol = (Symbol *)malloc(sizeof(Symbol));
-    if (!new_symbol)
-    {
-        fprintf(stderr, "Memory allocation failed for Function Symbol with Parameters.\n");
-        exit(1);
-    }
-    new_symbol->name = strdup(name);
-    new_symbol->type = strdup(return_type);
-    new_symbol->is_array = false;
-    new_symbol->is_function = true;
-    new_symbol->initialized = false; // Functions are not variables
-    new_symbol->num_dimensions = 0;
-    memset(new_symbol->sizes, 0, sizeof(new_symbol->sizes));
-    new_symbol->num_parameters = num_params;
+    reserve((void **)&table->parameters, &table->parameter_capacity,
+            table->parameter_count + num_params, sizeof(Parameter));
     for (int i = 0; i < num_params; i++)
     {
-        new_symbol->parameters[i].type = strdup(params[i].type);
-        new_symbol->parameters[i].name = strdup(params[i].name);
-    }
-    // Initialize remaining parameters to NULL
-    for (int i = num_params; i < MAX_FUNCTION_PARAMS; i++)
-    {
-        new_symbol->parameters[i].type = NULL;
-        new_symbol->parameters[i].name = NULL;
+        Parameter *param = &table->parameters[table->parameter_count + i];
+        param->name = name_at(table, intern_name(table, params[i].name));
+        param->type = params[i].type;
     }
-    new_symbol->next = table->head;
-    table->head = new_symbol;
+    sym->is_function = true;
+    sym->num_parameters = (uint16_t)num_params;
+    sym->details = table->parameter_count;
+    table->parameter_count += num_params;
     return true;
 }
 
 /* Checks if a symbol (variable or function) exists in the table. */
 bool symbol_exists(SymbolTable *table, const char *name)
 {
-    Symbol *current = table->head;
-    while (current != NULL)
-    {
-        if (strcmp(current->name, name) == 0)
-            return true;
-        current = current->next;
-    }
-    return false;
+    return get_symbol(table, name) != NULL;
 }
 
 /* Checks if a function exists in the table. */
 bool function_exists(SymbolTable *table, const char *name)
 {
-    Symbol *current = table->head;
-    while (current != NULL)
-    {
-        if (strcmp(current->name, name) == 0 && current->is_function)
-            return true;
-        current = current->next;
-    }
-    return false;
+    Symbol *sym = get_symbol(table, name);
+    return sym && sym->is_function;
 }
 
 /* Retrieves a symbol from the table by name. Returns NULL if not found. */
 Symbol *get_symbol(SymbolTable *table, const char *name)
 {
-    Symbol *current = table->head;
-    while (current != NULL)
+    if (table->count == 0)
+        return NULL;
+    uint32_t slot = *find_slot(table, name, hash_name(name));
+    return slot ? &table->symbols[slot - 1] : NULL;
+}
+
+/* The name of a symbol */
+const char *symbol_name(const SymbolTable *table, const Symbol *sym)
+{
+    return name_at(table, sym->name);
+}
+
+/* The sizes of an array, one per dimension */
+const int *symbol_sizes(const SymbolTable *table, const Symbol *sym)
+{
+    return sym->is_array ? &table->sizes[sym->details] : NULL;
+}
+
+/* The parameters of a function */
+const Parameter *symbol_parameters(const SymbolTable *table, const Symbol *sym)
+{
+    return sym->is_function && sym->num_parameters ? &table->parameters[sym->details] : NULL;
+}
+
+const char *symbol_type_name(SymbolType type)
+{
+    switch (type)
     {
-        if (strcmp(current->name, name) == 0)
-            return current;
-        current = current->next;
+    case SYMBOL_FLOAT:
+        return "float";
+    case SYMBOL_CHAR:
+        return "char";
+    default:
+        return "int";
     }
-    return NULL;
 }
 
 /* Frees all memory allocated for the symbol table */
@@ -219,29 +256,13 @@ void free_symbol_table(SymbolTable *table)
     if (table == NULL)
         return;
 
-    Symbol *current = table->head;
-    while (current != NULL)
-    {
-        Symbol *temp = current;
-        current = current->next;
-
-        // Free name and type
-        free(temp->name);
-        free(temp->type);
-
-        // Free parameters if it's a function
-        if (temp->is_function && temp->num_parameters > 0)
-        {
-            for (int i = 0; i < temp->num_parameters; i++)
-            {
-                free(temp->parameters[i].type);
-                free(temp->parameters[i].name);
-            }
-        }
-
-        // Free the symbol itself
-        free(temp);
-    }
+    for (uint32_t i = 0; i < table->name_block_count; i++)
+        free(table->name_blocks[i]);
+    free(table->name_blocks);
+    free(table->symbols);
+    free(table->slots);
+    free(table->sizes);
+    free(table->parameters);
     free(table);
 }
 
@@ -260,16 +281,16 @@ void print_symbol_table(SymbolTable *table)
         return;
     }
 
-    Symbol *current = table->head;
-
     // Define table headers
     printf("\n===== Symbol Table =====\n");
     printf("| %-15s | %-10s | %-8s | %-10s | %-30s |\n", "Name", "Type", "Is Func", "Is Array", "Details");
     printf("|-----------------|------------|----------|----------|--------------------------------|\n");
 
-    // Traverse the symbol table and print each symbol
-    while (current != NULL)
+    // Traverse the symbol table, most recent symbol first, and print each symbol
+    for (int index = table->count - 1; index >= 0; index--)
     {
+        const Symbol *current = &table->symbols[index];
+
         // Determine if the symbol is a function
         char is_function_str[4];
         if (current->is_function)
@@ -291,7 +312,7 @@ void print_symbol_table(SymbolTable *table)
         if (current->is_function)
         {
             strcat(details_str, "Return Type: ");
-            strcat(details_str, current->type);
+            strcat(details_str, symbol_type_name(current->type));
             strcat(details_str, ", Params: ");
             if (current->num_parameters == 0)
             {
@@ -299,11 +320,12 @@ void print_symbol_table(SymbolTable *table)
             }
             else
             {
+                const Parameter *parameters = symbol_parameters(table, current);
                 for (int i = 0; i < current->num_parameters; i++)
                 {
-                    strcat(details_str, current->parameters[i].type);
+                    strcat(details_str, symbol_type_name(parameters[i].type));
                     strcat(details_str, " ");
-                    strcat(details_str, current->parameters[i].name);
+                    strcat(details_str, parameters[i].name);
                     if (i < current->num_parameters - 1)
                         strcat(details_str, ", ");
                 }
@@ -319,7 +341,7 @@ void print_symbol_table(SymbolTable *table)
             for (int i = 0; i < current->num_dimensions; i++)
             {
                 char size_part[5];
-                snprintf(size_part, sizeof(size_part), "%d", current->sizes[i]);
+                snprintf(size_part, sizeof(size_part), "%d", symbol_sizes(table, current)[i]);
                 strcat(details_str, size_part);
                 if (i < current->num_dimensions - 1)
                     strcat(details_str, "x");
@@ -334,13 +356,11 @@ void print_symbol_table(SymbolTable *table)
 
         // Print the symbol row
         printf("| %-15s | %-10s | %-8s | %-8s | %-30s |\n",
-               current->name,
-               current->type,
+               symbol_name(table, current),
+               symbol_type_name(current->type),
                is_function_str,
                is_array_str,
                details_str);
-
-        current = current->next;
     }
 
     printf("========================\n\n");
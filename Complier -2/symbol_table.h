@@ -4,30 +4,62 @@
 #define SYMBOL_TABLE_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
-#define MAX_ARRAY_DIMENSIONS 10
-#define MAX_FUNCTION_PARAMS 10
+typedef enum SymbolType
+{
+    SYMBOL_INT,
+    SYMBOL_FLOAT,
+    SYMBOL_CHAR
+} SymbolType;
 
+/* A function parameter; 'name' points into the table's name pool once
+   the parameter is stored */
 typedef struct Parameter {
-    char* type;
-    char* name;
+    const char* name;
+    SymbolType type;
 } Parameter;
 
+/* One 12-byte record per symbol, the same for scalars, arrays and
+   functions. The name is an offset into the table's name pool (see
+   symbol_name); array sizes and parameter lists live in the table's side
+   storage (see symbol_sizes and symbol_parameters). */
 typedef struct Symbol {
-    char* name;
-    char* type;
-    bool is_array;
-    bool is_function;
-    bool initialized;
-    int num_dimensions;
-    int sizes[MAX_ARRAY_DIMENSIONS];
-    int num_parameters;
-    Parameter parameters[MAX_FUNCTION_PARAMS];
-    struct Symbol* next;
+    uint32_t name;            // Offset of the name in the name pool
+    uint32_t details;         // Index of the first size or parameter in side storage
+    union {
+        uint16_t num_dimensions;  // Arrays
+        uint16_t num_parameters;  // Functions
+    };
+    uint8_t tag;              // Top byte of the name's hash, checked before the name
+    uint8_t type : 2;         // SymbolType; the return type of a function
+    bool is_array : 1;
+    bool is_function : 1;
+    bool initialized : 1;
 } Symbol;
 
+#define NAME_BLOCK_SIZE 65536
+
+/* Symbols in declaration order, found by name through an open-addressing
+   hash index. A Symbol pointer is valid until the next symbol is added.
+   Names are stored in blocks that never move; offset 'o' is byte
+   o % NAME_BLOCK_SIZE of block o / NAME_BLOCK_SIZE. */
 typedef struct SymbolTable {
-    Symbol* head;
+    Symbol* symbols;
+    int count;
+    uint32_t capacity;
+    uint32_t* slots;          // Index + 1 of a symbol, or 0 for an empty slot
+    uint32_t slot_count;      // A power of two, at least 4/3 of count
+    int* sizes;               // Array sizes of all arrays
+    uint32_t size_count;
+    uint32_t size_capacity;
+    Parameter* parameters;    // Parameters of all functions
+    uint32_t parameter_count;
+    uint32_t parameter_capacity;
+    char** name_blocks;       // The name pool
+    uint32_t name_block_count;
+    uint32_t name_used;       // Bytes used in the last block
 } SymbolTable;
 
 // Function prototypes
@@ -39,6 +71,10 @@ bool add_function_symbol_with_params(SymbolTable* table, const char* name, const
 bool symbol_exists(SymbolTable* table, const char* name);
 bool function_exists(SymbolTable* table, const char* name);
 Symbol* get_symbol(SymbolTable* table, const char* name);
+const char* symbol_name(const SymbolTable* table, const Symbol* sym);
+const int* symbol_sizes(const SymbolTable* table, const Symbol* sym);
+const Parameter* symbol_parameters(const SymbolTable* table, const Symbol* sym);
+const char* symbol_type_name(SymbolType type);
 void free_symbol_table(SymbolTable* table);
 void print_symbol_table(SymbolTable* table);
 
@@ -1,117 +1,425 @@
 /* ast.c */
 
 #include "ast.h"
+#include "ast_visit.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <sys/mman.h>
+
+/* The node array is reserved for up to MAX_NODES nodes (4 GB of address
+   space) without committing memory; pages are backed as nodes are first
+   written. Where the reservation is refused, smaller ones are tried. */
+#define MAX_NODES ((size_t)1 << 27)
+#define MIN_NODES ((size_t)1 << 16)
+
+_Thread_local ASTNode* ast_nodes = NULL;
+static _Thread_local size_t node_capacity = 0;
+static _Thread_local size_t nodes_used = 0;
+
+_Thread_local int* ast_size_pool = NULL;
+static _Thread_local uint32_t sizes_used = 0;
+static _Thread_local uint32_t sizes_capacity = 0;
+
+static void reserve_nodes(void) {
+    for (size_t capacity = MAX_NODES; capacity >= MIN_NODES; capacity /= 2) {
+        void* base = mmap(NULL, capacity * sizeof(ASTNode), PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (base != MAP_FAILED) {
+            ast_nodes = (ASTNode*)base;
+            node_capacity = capacity;
+            nodes_used = 1;    /* Index 0 means no node */
+            return;
+        }
+    }
+    fprintf(stderr, "Failed to reserve memory for AST nodes.\n");
+    exit(EXIT_FAILURE);
+}
+
+/* The arena is a stack of chunks, newest first. Chunks double in size
+   up to MAX_CHUNK_SIZE, so even a very large tree takes only a few of
+   them and freeing it is a handful of free() calls. */
+#define FIRST_CHUNK_SIZE (64 * 1024)
+#define MAX_CHUNK_SIZE (16 * 1024 * 1024)
+#define ARENA_ALIGN 8
+
+typedef struct ASTChunk {
+    struct ASTChunk* next;
+    size_t used;
+    size_t size;
+    char data[];
+} ASTChunk;
+
+static _Thread_local ASTChunk* chunks = NULL;
+static _Thread_local size_t next_chunk_size = FIRST_CHUNK_SIZE;
+
+static void new_chunk(size_t size) {
+    size_t capacity = next_chunk_size;
+    while (capacity < size) capacity *= 2;
+    if (next_chunk_size < MAX_CHUNK_SIZE) next_chunk_size *= 2;
+    ASTChunk* chunk = (ASTChunk*)malloc(sizeof(ASTChunk) + capacity);
+    if (!chunk) {
+        fprintf(stderr, "Failed to allocate memory for the AST.\n");
+        exit(EXIT_FAILURE);
+    }
+    chunk->next = chunks;
+    chunk->used = 0;
+    chunk->size = capacity;
+    chunks = chunk;
+}
+
+void* ast_alloc(size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (!chunks || chunks->used + size > chunks->size) {
+        new_chunk(size);
+    }
+    void* p = chunks->data + chunks->used;
+    chunks->used += size;
+    return p;
+}
+
+void* ast_realloc(void* old, size_t old_size, size_t new_size) {
+    if (old) {
+        /* The last block in the newest chunk can simply be extended */
+        size_t aligned_old = (old_size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+        size_t aligned_new = (new_size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+        char* end = chunks->data + chunks->used;
+        if ((char*)old + aligned_old == end &&
+            chunks->used - aligned_old + aligned_new <= chunks->size) {
+            chunks->used = chunks->used - aligned_old + aligned_new;
+            return old;
+        }
+    }
+    void* p = ast_alloc(new_size);
+    if (old) memcpy(p, old, old_size < new_size ? old_size : new_size);
+    return p;
+}
+
+ASTMark ast_mark(void) {
+    if (!ast_nodes) reserve_nodes();
+    /* Make sure there is a chunk to hold the mark, so releasing to it
+       keeps the chunk for reuse instead of freeing it */
+    if (!chunks) new_chunk(0);
+    ASTMark mark;
+    mark.nodes = (ASTIndex)nodes_used;
+    mark.sizes = sizes_used;
+    mark.chunk = chunks;
+    mark.used = chunks->used;
+    return mark;
+}
+
+void ast_release(ASTMark mark) {
+    nodes_used = mark.nodes;
+    sizes_used = mark.sizes;
+    while (chunks != mark.chunk) {
+        ASTChunk* next = chunks->next;
+        free(chunks);
+        chunks = next;
+    }
+    chunks->used = mark.used;
+}
+
+void ast_free_all(void) {
+    while (chunks) {
+        ASTChunk* next = chunks->next;
+        free(chunks);
+        chunks = next;
+    }
+    next_chunk_size = FIRST_CHUNK_SIZE;
+
+    if (ast_nodes) munmap(ast_nodes, node_capacity * sizeof(ASTNode));
+    ast_nodes = NULL;
+    node_capacity = 0;
+    nodes_used = 0;
+    free(ast_size_pool);
+    ast_size_pool = NULL;
+    sizes_used = 0;
+    sizes_capacity = 0;
+}
+
+size_t ast_node_count(void) {
+    return nodes_used ? nodes_used - 1 : 0;
+}
+
+uint32_t ast_size_count(void) {
+    return sizes_used;
+}
+
+/* Make room for 'count' more entries in the size pool */
+static void reserve_sizes(uint32_t count) {
+    if (sizes_used + count > sizes_capacity) {
+        sizes_capacity = sizes_capacity ? sizes_capacity * 2 : 256;
+        while (sizes_used + count > sizes_capacity) sizes_capacity *= 2;
+        int* grown = (int*)realloc(ast_size_pool, sizes_capacity * sizeof(int));
+        if (!grown) {
+            fprintf(stderr, "Failed to allocate memory for the AST.\n");
+            exit(EXIT_FAILURE);
+        }
+        ast_size_pool = grown;
+    }
+}
+
+int ast_map_nodes(int fd, uint64_t offset, ASTIndex count,
+                  const int* sizes, uint32_t size_count) {
+    if (nodes_used > 1 || sizes_used > 0) {
+        fprintf(stderr, "Cannot map AST nodes over an existing tree.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (!ast_nodes) reserve_nodes();
+    if (count > node_capacity) return -1;
+
+    /* Replace the first pages of the reservation with the file */
+    void* mapped = mmap(ast_nodes, (size_t)count * sizeof(ASTNode), PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_FIXED, fd, (off_t)offset);
+    if (mapped == MAP_FAILED) return -1;
+    nodes_used = count;
+
+    reserve_sizes(size_count);
+    if (size_count) memcpy(ast_size_pool, sizes, size_count * sizeof(int));
+    sizes_used = size_count;
+    return 0;
+}
 
 /* Create a new AST node with the specified type */
 ASTNode* create_ast_node(ASTNodeType type) {
-    ASTNode* node = (ASTNode*)malloc(sizeof(ASTNode));
-    if (!node) {
-        fprintf(stderr, "Failed to allocate memory for AST node.\n");
-        exit(EXIT_FAILURE);
+    if (nodes_used == node_capacity) {
+        if (!ast_nodes) {
+            reserve_nodes();
+        } else {
+            fprintf(stderr, "Too many AST nodes (at most %zu).\n", node_capacity - 1);
+            exit(EXIT_FAILURE);
+        }
     }
+    ASTNode* node = &ast_nodes[nodes_used++];
+    memset(node, 0, sizeof(ASTNode));
     node->type = type;
-    node->name = NULL;
     node->data_type = DT_VOID;
     node->category = SYMBOL_VARIABLE;
-    node->operator = NULL;
-    node->value = 0;
-    node->float_value = 0.0f;
-    node->string = NULL;
+    return node;
+}
+
+/* Create an expression node of the given kind */
+static ASTNode* create_expression_node(ExprKind kind, ASTNode* left, ASTNode* right) {
+    ASTNode* node = create_ast_node(AST_EXPRESSION);
+    node->u.expr.kind = (uint8_t)kind;
+    node->left = ast_index(left);
+    node->right = ast_index(right);
+    return node;
+}
+
+ASTNode* create_binary_node(BinOp op, ASTNode* left, ASTNode* right) {
+    ASTNode* node = create_expression_node(EXPR_BINARY, left, right);
+    node->u.expr.op = (uint8_t)op;
+    return node;
+}
 
-    node->left = NULL;
-    node->right = NULL;
-    node->next = NULL;
+ASTNode* create_not_node(ASTNode* operand) {
+    return create_expression_node(EXPR_NOT, operand, NULL);
+}
 
-    node->condition = NULL;
-    node->body = NULL;
+ASTNode* create_number_node(int value) {
+    ASTNode* node = create_expression_node(EXPR_NUMBER, NULL, NULL);
+    node->u.expr.value = value;
+    return node;
+}
 
-    node->parameters = NULL;
-    node->arguments = NULL;
+ASTNode* create_float_node(float value) {
+    ASTNode* node = create_expression_node(EXPR_FLOAT, NULL, NULL);
+    node->u.expr.float_value = value;
+    return node;
+}
 
-    node->array_sizes = NULL;
-    node->dimensions = 0;
+ASTNode* create_id_node(const char* name) {
+    ASTNode* node = create_expression_node(EXPR_ID, NULL, NULL);
+    node->u.expr.name = ast_atom(name);
     return node;
 }
 
-/* Create a new expression node */
-ASTNode* create_expression_node(char* operator, ASTNode* left, ASTNode* right) {
-    ASTNode* node = create_ast_node(AST_EXPRESSION);
-    node->operator = strdup(operator);
-    node->left = left;
-    node->right = right;
+const char* binop_text(BinOp op) {
+    static const char* const text[] = {
+        [BINOP_ADD] = "+",  [BINOP_SUB] = "-",  [BINOP_MUL] = "*",  [BINOP_DIV] = "/",
+        [BINOP_OR] = "||",  [BINOP_AND] = "&&", [BINOP_EQ] = "==",  [BINOP_NE] = "!=",
+        [BINOP_GE] = ">=",  [BINOP_LE] = "<=",  [BINOP_GT] = ">",   [BINOP_LT] = "<",
+    };
+    return text[op];
+}
+
+const char* ast_operator(const ASTNode* node) {
+    if (node->type != AST_EXPRESSION) return NULL;
+    switch (ast_expr_kind(node)) {
+        case EXPR_NUMBER: return "NUMBER";
+        case EXPR_FLOAT: return "FLOAT_NUMBER";
+        case EXPR_ID: return "ID";
+        case EXPR_NOT: return "!";
+        case EXPR_BINARY: return binop_text(ast_binop(node));
+    }
+    return NULL;
+}
+
+const char* ast_name(const ASTNode* node) {
+    switch (node->type) {
+        case AST_FUNCTION_DEFINITION:
+        case AST_DECLARATION:
+        case AST_ASSIGNMENT:
+        case AST_WRITE:
+        case AST_FUNCTION_CALL:
+        case AST_ARRAY_ACCESS:
+            return ast_atom_text(node->u.named.name);
+        case AST_EXPRESSION:
+            return ast_expr_kind(node) == EXPR_ID ? ast_atom_text(node->u.expr.name) : NULL;
+        default:
+            return NULL;
+    }
+}
+
+void ast_set_name(ASTNode* node, const char* name) {
+    if (node->type == AST_EXPRESSION) {
+        node->u.expr.name = ast_atom(name);
+    } else {
+        node->u.named.name = ast_atom(name);
+    }
+}
+
+void ast_set_array_sizes(ASTNode* node, const int* sizes, int dimensions) {
+    if (dimensions > UINT8_MAX) {
+        fprintf(stderr, "Too many array dimensions (%d).\n", dimensions);
+        exit(EXIT_FAILURE);
+    }
+    reserve_sizes((uint32_t)dimensions);
+    memcpy(&ast_size_pool[sizes_used], sizes, dimensions * sizeof(int));
+    node->u.named.array_sizes = sizes_used;
+    node->dimensions = (uint8_t)dimensions;
+    sizes_used += dimensions;
+}
+
+/* Last node of the chain that starts at 'node' */
+static ASTNode* chain_tail(ASTNode* node) {
+    while (node->next) {
+        node = ast_next(node);
+    }
     return node;
 }
 
-/* Add a child node to a parent */
+/* Add a child node to a parent. parent->last_child only ever moves
+   forward along the child list, so each child is stepped over at most
+   once in total however many children are added. */
 void add_child(ASTNode* parent, ASTNode* child) {
+    if (!child) return;
     if (!parent->left) {
-        parent->left = child;
+        parent->left = ast_index(child);
     } else {
-        ASTNode* temp = parent->left;
-        while (temp->next) {
-            temp = temp->next;
-        }
-        temp->next = child;
+        ASTNode* tail = ast_node(parent->last_child ? parent->last_child : parent->left);
+        chain_tail(tail)->next = ast_index(child);
     }
+    parent->last_child = ast_index(child);
+}
+
+/* Add a whole list of children to a parent */
+void add_children(ASTNode* parent, ASTList children) {
+    if (!children.head) return;
+    add_child(parent, children.head);
+    parent->last_child = ast_index(children.tail);
+}
+
+/* Start a list from a node and its existing siblings */
+ASTList ast_list(ASTNode* first) {
+    ASTList list;
+    list.head = first;
+    list.tail = first ? chain_tail(first) : NULL;
+    return list;
 }
 
-/* Add a sibling node */
-void add_sibling(ASTNode* first, ASTNode* sibling) {
-    ASTNode* temp = first;
-    while (temp->next) {
-        temp = temp->next;
+/* Append a sibling node to a list */
+void add_sibling(ASTList* list, ASTNode* sibling) {
+    if (!sibling) return;
+    if (list->tail) {
+        list->tail->next = ast_index(sibling);
+    } else {
+        list->head = sibling;
     }
-    temp->next = sibling;
+    list->tail = chain_tail(sibling);
 }
 
 /* Helper function to print indentation */
 void print_indent(int level) {
-    for (int i = 0; i < level; i++) {
-        printf("  ");
-    }
+    printf("%*s", 2 * level, "");
+}
+
+/* Value of a NUMBER expression; 0 for any other node */
+static int number_value(const ASTNode* node) {
+    return ast_is_expr(node, EXPR_NUMBER) ? ast_value(node) : 0;
 }
 
-/* Recursive function to print the AST */
-void print_ast(ASTNode* root, int level) {
-    if (!root) return;
+/* What a visit of print_ast's walk prints: a node (and the subtrees it
+   schedules), or one of these headers above a subtree */
+enum {
+    PRINT_NODE,
+    PRINT_ARRAY_INIT,
+    PRINT_INITIALIZATION,
+    PRINT_EXPRESSION,
+    PRINT_CONDITION,
+    PRINT_BLOCK,
+    PRINT_ARGUMENTS,
+};
+
+static const char* const print_headers[] = {
+    [PRINT_ARRAY_INIT] = "Array Initialization",
+    [PRINT_INITIALIZATION] = "Initialization:",
+    [PRINT_EXPRESSION] = "Expression:",
+    [PRINT_CONDITION] = "Condition:",
+    [PRINT_BLOCK] = "Block",
+    [PRINT_ARGUMENTS] = "Arguments:",
+};
+
+/* Print 'subtree' and its siblings under a header, one level deeper */
+static void print_under(ASTVisitor* visitor, int header, ASTNode* subtree, int level) {
+    ast_visit_child(visitor, NULL, header, level + 1);
+    ast_visit_list(visitor, subtree, PRINT_NODE, level + 2);
+}
+
+static void print_visit(ASTVisitor* visitor, const ASTVisit* visit) {
+    const ASTNode* root = visit->node;
+    int level = visit->level;
 
     /* Indentation */
     print_indent(level);
 
+    if (visit->tag != PRINT_NODE) {
+        printf("%s\n", print_headers[visit->tag]);
+        return;
+    }
+
     /* Print node information based on type */
     switch(root->type) {
         case AST_PROGRAM:
             printf("Program\n");
             break;
         case AST_FUNCTION_DEFINITION:
-            printf("Function Definition: %s\n", root->name);
+            printf("Function Definition: %s\n", ast_name(root));
             break;
         case AST_MAIN_FUNCTION:
             printf("Function Definition: main\n");
             break;
         case AST_DECLARATION:
             if (root->category == SYMBOL_ARRAY) {
-                printf("Declaration: %s (int[%d])\n", root->name, root->array_sizes[0]);
+                printf("Declaration: %s (int[%d])\n", ast_name(root), ast_array_sizes(root)[0]);
             } else {
-                printf("Declaration: %s (%s)\n", root->name, 
+                printf("Declaration: %s (%s)\n", ast_name(root), 
                        root->data_type == DT_INT ? "int" :
                        root->data_type == DT_FLOAT ? "float" :
                        root->data_type == DT_CHAR ? "char" : "unknown");
             }
             break;
         case AST_ASSIGNMENT:
-            printf("Assignment Statement: %s\n", root->name);
+            printf("Assignment Statement: %s\n", ast_name(root));
             break;
         case AST_WRITE:
             printf("Write Statement: ");
-            if (root->left && root->left->type == AST_ARRAY_ACCESS) {
+            if (root->left && ast_left(root)->type == AST_ARRAY_ACCESS) {
                 /* Handle writing to array elements */
-                printf("%s[%d]\n", root->left->string, root->left->left->value);
-            } else if (root->name) {
-                printf("ID(%s)\n", root->name);
+                printf("%s[%d]\n", ast_name(ast_left(root)), number_value(ast_left(ast_left(root))));
+            } else if (ast_name(root)) {
+                printf("ID(%s)\n", ast_name(root));
             } else {
                 printf("Unknown\n");
             }
@@ -126,20 +434,18 @@ void print_ast(ASTNode* root, int level) {
             printf("Return Statement\n");
             break;
         case AST_EXPRESSION:
-            if (root->operator) {
-                if (strcmp(root->operator, "ID") == 0) {
-                    printf("Expression: ID(%s)\n", root->string);
-                } else if (strcmp(root->operator, "NUMBER") == 0) {
-                    printf("Expression: NUMBER(%d)\n", root->value);
-                } else if (strcmp(root->operator, "FLOAT_NUMBER") == 0) {
-                    printf("Expression: FLOAT_NUMBER(%.2f)\n", root->float_value);
-                } else {
-                    printf("Expression: %s\n", root->operator);
-                }
-            } else if (root->string) {
-                printf("Expression: ID(%s)\n", root->string);
-            } else {
-                printf("Expression: Unknown\n");
+            switch (ast_expr_kind(root)) {
+                case EXPR_ID:
+                    printf("Expression: ID(%s)\n", ast_name(root));
+                    break;
+                case EXPR_NUMBER:
+                    printf("Expression: NUMBER(%d)\n", ast_value(root));
+                    break;
+                case EXPR_FLOAT:
+                    printf("Expression: FLOAT_NUMBER(%.2f)\n", ast_float_value(root));
+                    break;
+                default:
+                    printf("Expression: %s\n", ast_operator(root));
             }
             break;
         case AST_BLOCK:
@@ -149,7 +455,7 @@ void print_ast(ASTNode* root, int level) {
             printf("Array Initialization\n");
             break;
         case AST_FUNCTION_CALL:
-            printf("Function Call: %s\n", root->string);
+            printf("Function Call: %s\n", ast_name(root));
             break;
         case AST_ARRAY_ACCESS:
             /* This case is handled within AST_WRITE */
@@ -165,65 +471,47 @@ void print_ast(ASTNode* root, int level) {
         case AST_MAIN_FUNCTION:
         case AST_BLOCK:
             if (root->left) {
-                print_ast(root->left, level + 1);
+                ast_visit_list(visitor, ast_left(root), PRINT_NODE, level + 1);
             }
             break;
         case AST_DECLARATION:
             if (root->category == SYMBOL_ARRAY && root->left) {
                 /* For array initialization */
-                print_indent(level + 1);
-                printf("Array Initialization\n");
-                print_ast(root->left, level + 2);
+                print_under(visitor, PRINT_ARRAY_INIT, ast_left(root), level);
             } else if (root->left) {
                 /* For initialized variables */
-                print_indent(level + 1);
-                printf("Initialization:\n");
-                print_ast(root->left, level + 2);
+                print_under(visitor, PRINT_INITIALIZATION, ast_left(root), level);
             }
             break;
         case AST_ASSIGNMENT:
             if (root->left) {
-                print_indent(level + 1);
-                printf("Expression:\n");
-                print_ast(root->left, level + 2);
+                print_under(visitor, PRINT_EXPRESSION, ast_left(root), level);
             }
             break;
         case AST_IF:
-            if (root->condition) {
-                print_indent(level + 1);
-                printf("Condition:\n");
-                print_ast(root->condition, level + 2);
+            if (ast_condition(root)) {
+                print_under(visitor, PRINT_CONDITION, ast_condition(root), level);
             }
-            if (root->body) {
-                print_indent(level + 1);
-                printf("Block\n");
-                print_ast(root->body, level + 2);
+            if (ast_body(root)) {
+                print_under(visitor, PRINT_BLOCK, ast_body(root), level);
             }
             break;
         case AST_WHILE:
-            if (root->condition) {
-                print_indent(level + 1);
-                printf("Condition:\n");
-                print_ast(root->condition, level + 2);
+            if (ast_condition(root)) {
+                print_under(visitor, PRINT_CONDITION, ast_condition(root), level);
             }
-            if (root->body) {
-                print_indent(level + 1);
-                printf("Block\n");
-                print_ast(root->body, level + 2);
+            if (ast_body(root)) {
+                print_under(visitor, PRINT_BLOCK, ast_body(root), level);
             }
             break;
         case AST_RETURN:
             if (root->left) {
-                print_indent(level + 1);
-                printf("Expression:\n");
-                print_ast(root->left, level + 2);
+                print_under(visitor, PRINT_EXPRESSION, ast_left(root), level);
             }
             break;
         case AST_FUNCTION_CALL:
-            if (root->arguments) {
-                print_indent(level + 1);
-                printf("Arguments:\n");
-                print_ast(root->arguments, level + 2);
+            if (ast_arguments(root)) {
+                print_under(visitor, PRINT_ARGUMENTS, ast_arguments(root), level);
             }
             break;
         case AST_ARRAY_ACCESS:
@@ -232,41 +520,20 @@ void print_ast(ASTNode* root, int level) {
         default:
             /* For other node types, process children normally */
             if (root->left) {
-                print_ast(root->left, level + 1);
+                ast_visit_list(visitor, ast_left(root), PRINT_NODE, level + 1);
             }
             if (root->right) {
-                print_ast(root->right, level + 1);
+                ast_visit_list(visitor, ast_right(root), PRINT_NODE, level + 1);
             }
             break;
     }
-
-    /* Print siblings */
-    if (root->next) {
-        print_ast(root->next, level);
-    }
 }
 
-/* Recursive function to free the AST */
-void free_ast(ASTNode* root) {
-    if (!root) return;
-
-    /* Free current node's data */
-    if (root->name) free(root->name);
-    if (root->operator) free(root->operator);
-    if (root->string) free(root->string);
-    if (root->array_sizes) free(root->array_sizes);
-
-    /* Free children */
-    if (root->left) free_ast(root->left);
-    if (root->right) free_ast(root->right);
-    if (root->condition) free_ast(root->condition);
-    if (root->body) free_ast(root->body);
-    if (root->parameters) free_ast(root->parameters);
-    if (root->arguments) free_ast(root->arguments);
-
-    /* Free siblings */
-    if (root->next) free_ast(root->next);
-
-    /* Free the node itself */
-    free(root);
+/* Print the AST for debugging: 'root' and its siblings, indented by
+   'level' */
+void print_ast(const ASTNode* root, int level) {
+    ASTVisitor visitor;
+    ast_visitor_init(&visitor, print_visit, NULL, NULL);
+    ast_walk_list(&visitor, (ASTNode*)root, PRINT_NODE, level);
+    ast_visitor_free(&visitor);
 }
@@ -3,7 +3,10 @@
 #ifndef AST_H
 #define AST_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include "symbol_table.h"
+#include "intern.h"
 
 /* Enumeration of all possible AST node types */
 typedef enum {
@@ -24,60 +27,260 @@ typedef enum {
     /* Add more node types as needed */
 } ASTNodeType;
 
+/* What an AST_EXPRESSION node is */
+typedef enum {
+    EXPR_NUMBER,         /* Integer literal */
+    EXPR_FLOAT,          /* Floating-point literal */
+    EXPR_ID,             /* Read of a variable */
+    EXPR_NOT,            /* !left */
+    EXPR_BINARY,         /* left op right, with op a BinOp */
+} ExprKind;
+
+/* Operator of an EXPR_BINARY node */
+typedef enum {
+    BINOP_ADD,
+    BINOP_SUB,
+    BINOP_MUL,
+    BINOP_DIV,
+    BINOP_OR,
+    BINOP_AND,
+    BINOP_EQ,
+    BINOP_NE,
+    BINOP_GE,
+    BINOP_LE,
+    BINOP_GT,
+    BINOP_LT,
+} BinOp;
+
 /* Forward declaration for ASTNode */
 typedef struct ASTNode ASTNode;
 
-/* Structure for AST Nodes */
+/* Position of a node in the node array; 0 means no node */
+typedef uint32_t ASTIndex;
+
+/*
+ * A node is 32 bytes: a small header, the links to other nodes as
+ * 32-bit indices into one contiguous node array, and a payload whose
+ * meaning depends on the node type. Names are stored as interned atom
+ * ids, expression kinds and operators as ExprKind and BinOp. Read
+ * nodes through the accessors below rather than the fields, since the
+ * payload members overlap.
+ */
 struct ASTNode {
-    ASTNodeType type;        /* Type of the AST node */
-    char* name;              /* Name associated with the node (e.g., variable name) */
-    DataType data_type;      /* Data type (int, float, etc.) */
-    SymbolCategory category; /* Category (Variable, Function, etc.) */
-    int increment;
-    /* For expressions */
-    char* operator;          /* Operator (e.g., +, -, *, /) */
-    int value;               /* Integer value */
-    float float_value;       /* Float value */
-    char* string;            /* Identifier name */
-
-    /* Children nodes */
-    ASTNode* left;           /* Left child */
-    ASTNode* right;          /* Right child */
-    ASTNode* next;           /* Sibling node (for lists) */
-
-    /* For control structures */
-    ASTNode* condition;     /* Condition expression */
-    ASTNode* body;          /* Body of if/while */
-
-    /* For functions */
-    ASTNode* parameters;    /* Parameters list */
-    ASTNode* arguments;     /* Arguments list */
-
-    /* For arrays */
-    int* array_sizes;       /* Sizes for each dimension */
-    int dimensions;         /* Number of dimensions */
-
-    /* Additional fields as needed */
+    uint8_t type;            /* ASTNodeType */
+    uint8_t data_type;       /* DataType of a declaration or function, or of a checked expression */
+    union {
+        uint8_t category;    /* SymbolCategory of a declaration */
+        uint8_t shared;      /* Expressions and array reads: whether several links lead here (see expr_dag.h) */
+    };
+    union {
+        uint8_t dimensions;  /* Number of array dimensions of a declaration */
+        uint8_t checked;     /* Expressions, calls and array accesses: 'data_type' is set */
+    };
+    uint32_t offset;         /* Source location: byte offset (see source.h) */
+
+    ASTIndex left;           /* First child, or the left operand */
+    ASTIndex right;          /* Right operand; body of if/while; arguments of a call */
+    ASTIndex next;           /* Sibling node (for lists) */
+    union {
+        ASTIndex last_child; /* A node at or before the end of the child list (see add_child) */
+        uint32_t symbol;     /* Resolved names: id of their Symbol; 0 if undeclared (see resolve.h) */
+    };
+
+    union {
+        /* Functions, declarations, assignments, writes, calls and array accesses */
+        struct {
+            uint32_t name;          /* Atom id + 1 of the name; 0 if none */
+            uint32_t array_sizes;   /* Declarations: first of 'dimensions' sizes */
+        } named;
+        /* AST_EXPRESSION */
+        struct {
+            uint8_t kind;           /* ExprKind */
+            uint8_t op;             /* BinOp of EXPR_BINARY */
+            union {
+                int value;          /* NUMBER */
+                float float_value;  /* FLOAT_NUMBER */
+                uint32_t name;      /* ID: atom id + 1 of the variable */
+            };
+        } expr;
+        /* AST_IF and AST_WHILE */
+        ASTIndex condition;
+    } u;
 };
 
+/* The current thread's node array; index 0 is never used */
+extern _Thread_local ASTNode* ast_nodes;
+
+/* Array sizes of all declarations, indexed by u.named.array_sizes */
+extern _Thread_local int* ast_size_pool;
+
+static inline ASTNode* ast_node(ASTIndex index) {
+    return index ? &ast_nodes[index] : NULL;
+}
+
+static inline ASTIndex ast_index(const ASTNode* node) {
+    return node ? (ASTIndex)(node - ast_nodes) : 0;
+}
+
+/* Atom id + 1 for a name, so that 0 can mean none */
+static inline uint32_t ast_atom(const char* atom) {
+    return atom ? atom_id(atom) + 1 : 0;
+}
+
+static inline const char* ast_atom_text(uint32_t atom) {
+    return atom ? atom_by_id(atom - 1) : NULL;
+}
+
+/* Accessors */
+
+static inline ASTNode* ast_left(const ASTNode* node) { return ast_node(node->left); }
+static inline ASTNode* ast_next(const ASTNode* node) { return ast_node(node->next); }
+
+/* Right operand of an expression */
+static inline ASTNode* ast_right(const ASTNode* node) {
+    return node->type == AST_EXPRESSION ? ast_node(node->right) : NULL;
+}
+
+/* Body of an if or while */
+static inline ASTNode* ast_body(const ASTNode* node) {
+    return node->type == AST_IF || node->type == AST_WHILE ? ast_node(node->right) : NULL;
+}
+
+/* Condition of an if or while */
+static inline ASTNode* ast_condition(const ASTNode* node) {
+    return node->type == AST_IF || node->type == AST_WHILE ? ast_node(node->u.condition) : NULL;
+}
+
+/* Arguments of a function call */
+static inline ASTNode* ast_arguments(const ASTNode* node) {
+    return node->type == AST_FUNCTION_CALL ? ast_node(node->right) : NULL;
+}
+
+/* Type of an expression, call or array access that has been checked
+   (see check_expression) */
+static inline DataType ast_type(const ASTNode* node) { return (DataType)node->data_type; }
+
+/* Symbol a resolved ID, call, array access, assignment, write or
+   declaration refers to; NULL if it was undeclared */
+static inline Symbol* ast_symbol(const ASTNode* node) { return symbol_by_id(node->symbol); }
+
+static inline ExprKind ast_expr_kind(const ASTNode* node) { return (ExprKind)node->u.expr.kind; }
+static inline BinOp ast_binop(const ASTNode* node) { return (BinOp)node->u.expr.op; }
+
+/* Whether 'node' is an expression of the given kind */
+static inline int ast_is_expr(const ASTNode* node, ExprKind kind) {
+    return node && node->type == AST_EXPRESSION && node->u.expr.kind == kind;
+}
+
+/* Spelling of a binary operator, e.g. "+" or "&&" */
+const char* binop_text(BinOp op);
+
+/* Spelling of an expression's operator for printing: "NUMBER",
+   "FLOAT_NUMBER", "ID", "!" or that of its BinOp; NULL for other nodes */
+const char* ast_operator(const ASTNode* node);
+
+/* Interned name of a declared, assigned, written, called or accessed
+   entity, or of the variable an ID expression reads; NULL otherwise */
+const char* ast_name(const ASTNode* node);
+
+static inline int ast_value(const ASTNode* node) { return node->u.expr.value; }
+static inline float ast_float_value(const ASTNode* node) { return node->u.expr.float_value; }
+
+/* Sizes of an array declaration, one per dimension */
+static inline const int* ast_array_sizes(const ASTNode* node) {
+    return node->dimensions ? &ast_size_pool[node->u.named.array_sizes] : NULL;
+}
+
+/* A list of sibling nodes under construction. Tracking the last node
+   makes appending O(1); 'head' is what gets stored in the tree. */
+typedef struct ASTList {
+    ASTNode* head;
+    ASTNode* tail;
+} ASTList;
+
+/*
+ * Nodes are appended to the node array, which is reserved up front in
+ * address space and only backed by memory as it fills, so it never
+ * moves and node pointers stay valid while the tree grows. Scratch data
+ * the parsers need while building (such as array-size vectors) comes
+ * from a bump-pointer arena. Nothing is freed individually:
+ * ast_free_all() releases every tree at once, and ast_mark()/
+ * ast_release() release just what was allocated since a mark, e.g. one
+ * function of a streaming compilation.
+ */
+
+/* Position in the node array, size pool and arena, from ast_mark() */
+typedef struct ASTMark {
+    ASTIndex nodes;
+    uint32_t sizes;
+    struct ASTChunk* chunk;
+    size_t used;
+} ASTMark;
+
+/* 'size' bytes from the arena, aligned for any AST data */
+void* ast_alloc(size_t size);
+
+/* Grow an arena block to 'new_size' bytes, in place if it was the last
+   allocation made; 'old' may be NULL */
+void* ast_realloc(void* old, size_t old_size, size_t new_size);
+
+/* Current position in the node array and arena */
+ASTMark ast_mark(void);
+
+/* Release everything allocated since 'mark' was taken */
+void ast_release(ASTMark mark);
+
+/* Release every node and arena block */
+void ast_free_all(void);
+
+/* Number of nodes created since the last ast_free_all() */
+size_t ast_node_count(void);
+
+/* Number of array sizes in the size pool */
+uint32_t ast_size_count(void);
+
+/* Start an empty node array with the 'count' nodes (index 0 included)
+   stored at page-aligned 'offset' in file 'fd'. They are mapped, not
+   read: pages are loaded when first touched and copied only if written.
+   New nodes go after them. The size pool is set to 'size_count' entries
+   copied from 'sizes'. Returns 0, or -1 if the file cannot be mapped. */
+int ast_map_nodes(int fd, uint64_t offset, ASTIndex count,
+                  const int* sizes, uint32_t size_count);
+
 /* Function Prototypes */
 
 /* Create a new AST node */
 ASTNode* create_ast_node(ASTNodeType type);
 
-/* Create a new expression node */
-ASTNode* create_expression_node(char* operator, ASTNode* left, ASTNode* right);
+/* Create binary and '!' expression nodes */
+ASTNode* create_binary_node(BinOp op, ASTNode* left, ASTNode* right);
+ASTNode* create_not_node(ASTNode* operand);
+
+/* Create NUMBER, FLOAT_NUMBER and ID expression leaves */
+ASTNode* create_number_node(int value);
+ASTNode* create_float_node(float value);
+ASTNode* create_id_node(const char* name);
 
-/* Add a child node */
+/* Set the interned name of a node (see ast_name) */
+void ast_set_name(ASTNode* node, const char* name);
+
+/* Copy the sizes of an array declaration into the size pool */
+void ast_set_array_sizes(ASTNode* node, const int* sizes, int dimensions);
+
+/* Add a child node (and any siblings it already has) after the
+   parent's existing children, in amortized O(1) */
 void add_child(ASTNode* parent, ASTNode* child);
 
-/* Add a sibling node */
-void add_sibling(ASTNode* first, ASTNode* sibling);
+/* Add all nodes of 'children' after the parent's existing children, in O(1) */
+void add_children(ASTNode* parent, ASTList children);
 
-/* Print the AST for debugging */
-void print_ast(ASTNode* root, int level);
+/* List holding 'first' and its existing siblings; NULL gives an empty list */
+ASTList ast_list(ASTNode* first);
 
-/* Free the AST */
-void free_ast(ASTNode* root);
+/* Append a sibling node (and any siblings it already has) to a list */
+void add_sibling(ASTList* list, ASTNode* sibling);
+
+/* Print the AST for debugging */
+void print_ast(const ASTNode* root, int level);
 
 #endif /* AST_H */
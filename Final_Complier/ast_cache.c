@@ -0,0 +1,193 @@
+/* ast_cache.c */
+
+#include "ast_cache.h"
+#include "intern.h"
+#include "resolve.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CACHE_MAGIC "ASTCACHE"
+#define CACHE_VERSION 1
+
+/* The node array starts at a multiple of this in the file, so it can be
+   mapped on systems with pages of up to 64 KB */
+#define NODES_ALIGN 65536
+
+typedef struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t node_size;          /* sizeof(ASTNode) of the writer */
+    uint64_t source_hash;        /* hash_source() of the text */
+    uint64_t source_length;
+    uint32_t node_count;         /* Nodes in the array, including node 0 */
+    uint32_t root;               /* Index of the root node */
+    uint32_t size_count;         /* Entries in the size pool */
+    uint32_t name_count;         /* Names, i.e. atoms when the file was written */
+    uint64_t sizes_offset;
+    uint64_t names_offset;
+    uint64_t names_length;
+    uint64_t nodes_offset;       /* A multiple of NODES_ALIGN */
+} CacheHeader;
+
+/* 64-bit FNV-1a, taken a word at a time rather than a byte at a time */
+static uint64_t hash_source(const SourceBuffer* source) {
+    const uint64_t prime = 0x100000001b3ULL;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const char* p = source->data;
+    size_t length = source->length;
+    for (; length >= 8; p += 8, length -= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        hash = (hash ^ word) * prime;
+    }
+    for (; length > 0; p++, length--) {
+        hash = (hash ^ (unsigned char)*p) * prime;
+    }
+    return hash;
+}
+
+static int header_matches(const CacheHeader* h, uint64_t file_size, const SourceBuffer* source) {
+    return memcmp(h->magic, CACHE_MAGIC, sizeof(h->magic)) == 0 &&
+           h->version == CACHE_VERSION &&
+           h->node_size == sizeof(ASTNode) &&
+           h->source_length == source->length &&
+           h->root > 0 && h->root < h->node_count &&
+           h->sizes_offset % sizeof(int) == 0 &&
+           h->sizes_offset + (uint64_t)h->size_count * sizeof(int) <= file_size &&
+           h->names_offset + h->names_length <= file_size &&
+           h->nodes_offset % NODES_ALIGN == 0 &&
+           h->nodes_offset + (uint64_t)h->node_count * sizeof(ASTNode) <= file_size &&
+           h->source_hash == hash_source(source);
+}
+
+/* The name field of a node, or NULL if it has none (see ast_name) */
+static uint32_t* name_field(ASTNode* node) {
+    switch (node->type) {
+        case AST_FUNCTION_DEFINITION:
+        case AST_DECLARATION:
+        case AST_ASSIGNMENT:
+        case AST_WRITE:
+        case AST_FUNCTION_CALL:
+        case AST_ARRAY_ACCESS:
+            return &node->u.named.name;
+        case AST_EXPRESSION:
+            return ast_expr_kind(node) == EXPR_ID ? &node->u.expr.name : NULL;
+        default:
+            return NULL;
+    }
+}
+
+/* Point the names of nodes 1..count-1 at the atoms 'ids' gives for the
+   writer's atom ids */
+static void renumber_names(ASTIndex count, const unsigned* ids) {
+    for (ASTIndex i = 1; i < count; i++) {
+        uint32_t* name = name_field(&ast_nodes[i]);
+        if (name && *name) *name = ids[*name - 1] + 1;
+    }
+}
+
+/* Load from the cache file open as 'fd' and mapped at 'file' */
+static ASTNode* load_mapped(int fd, const char* file, uint64_t file_size, const SourceBuffer* source) {
+    const CacheHeader* header = (const CacheHeader*)file;
+    if (!header_matches(header, file_size, source)) return NULL;
+
+    /* Intern the names in id order. In a fresh compilation they get the
+       ids they had when the file was written and the nodes are used as
+       they are; otherwise the nodes' names are renumbered. */
+    unsigned* ids = (unsigned*)malloc((header->name_count + 1) * sizeof(unsigned));
+    if (!ids) return NULL;
+    const char* name = file + header->names_offset;
+    const char* end = name + header->names_length;
+    int renumber = 0;
+    for (uint32_t i = 0; i < header->name_count; i++) {
+        const char* nul = memchr(name, '\0', end - name);
+        if (!nul) {
+            free(ids);
+            return NULL;
+        }
+        ids[i] = atom_id(intern(name, nul - name));
+        renumber |= ids[i] != i;
+        name = nul + 1;
+    }
+
+    const int* sizes = (const int*)(file + header->sizes_offset);
+    if (ast_map_nodes(fd, header->nodes_offset, header->node_count, sizes, header->size_count) != 0) {
+        free(ids);
+        return NULL;
+    }
+    if (renumber) renumber_names(header->node_count, ids);
+    free(ids);
+
+    ASTNode* root = ast_node(header->root);
+    resolve_names(root);
+    return root;
+}
+
+ASTNode* ast_cache_load(const char* path, const SourceBuffer* source) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    ASTNode* root = NULL;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && (uint64_t)st.st_size >= sizeof(CacheHeader)) {
+        void* file = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (file != MAP_FAILED) {
+            root = load_mapped(fd, (const char*)file, st.st_size, source);
+            munmap(file, st.st_size);
+        }
+    }
+    close(fd);
+    return root;
+}
+
+int ast_cache_write(const char* path, const SourceBuffer* source, const ASTNode* root) {
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_VERSION;
+    header.node_size = sizeof(ASTNode);
+    header.source_hash = hash_source(source);
+    header.source_length = source->length;
+    header.node_count = (uint32_t)ast_node_count() + 1;
+    header.root = ast_index(root);
+    header.size_count = ast_size_count();
+    header.name_count = atom_count();
+    header.sizes_offset = sizeof(CacheHeader);
+    header.names_offset = header.sizes_offset + (uint64_t)header.size_count * sizeof(int);
+    for (uint32_t i = 0; i < header.name_count; i++) {
+        header.names_length += atom_length(atom_by_id(i)) + 1;
+    }
+    header.nodes_offset = (header.names_offset + header.names_length + NODES_ALIGN - 1) /
+                          NODES_ALIGN * NODES_ALIGN;
+
+    /* Write a temporary file and rename it over the cache, so a reader
+       never sees a partly written file */
+    char* temp = (char*)malloc(strlen(path) + 32);
+    if (!temp) return -1;
+    sprintf(temp, "%s.%ld.tmp", path, (long)getpid());
+    FILE* out = fopen(temp, "wb");
+    if (!out) {
+        free(temp);
+        return -1;
+    }
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(ast_size_pool, sizeof(int), header.size_count, out);
+    for (uint32_t i = 0; i < header.name_count; i++) {
+        const char* atom = atom_by_id(i);
+        fwrite(atom, 1, atom_length(atom) + 1, out);
+    }
+    fseek(out, (long)header.nodes_offset, SEEK_SET);
+    fwrite(ast_nodes, sizeof(ASTNode), header.node_count, out);
+
+    int ok = !ferror(out);
+    if (fclose(out) != 0) ok = 0;
+    if (ok && rename(temp, path) != 0) ok = 0;
+    if (!ok) remove(temp);
+    free(temp);
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,36 @@
+/* ast_cache.h */
+
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include "ast.h"
+#include "source.h"
+
+/*
+ * On-disk cache of a parsed tree, so recompiling an unchanged source
+ * skips the scanner and parser.
+ *
+ * The file holds a header (with a hash of the source text), the array
+ * sizes, the interned names as NUL-terminated strings in atom id order,
+ * and finally the node array exactly as it is in memory. Nodes refer to
+ * each other, to names and to sizes by index, so the node array needs no
+ * fixing up: it is mapped straight into place (see ast_map_nodes). All
+ * positions in the header are byte offsets from the start of the file.
+ */
+
+/*
+ * Load the tree cached in 'path' for the text of 'source'. Returns its
+ * root, or NULL if there is no usable cache: the file is missing,
+ * unreadable, written by a different build, or for different text.
+ * The symbols the parser would have declared while building the tree
+ * are declared in the current symbol table, in the same scopes and
+ * order, and the names in it are bound to them (see resolve_names).
+ */
+ASTNode* ast_cache_load(const char* path, const SourceBuffer* source);
+
+/* Write the tree under 'root', which must be the only tree in the node
+   array, as the cache for 'source'. The file is replaced atomically.
+   Returns 0, or -1 if it could not be written. */
+int ast_cache_write(const char* path, const SourceBuffer* source, const ASTNode* root);
+
+#endif /* AST_CACHE_H */
@@ -0,0 +1,136 @@
+/* ast_visit.c */
+
+#include "ast_visit.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* A pending visit: either 'pre' of a node, or 'post' of a node whose
+   'pre' has run */
+typedef struct ASTVisitFrame {
+    ASTVisit visit;
+    uint8_t post;
+    uint8_t list;            /* Go on to the node's next sibling afterwards */
+} ASTVisitFrame;
+
+static void* grow(void* array, size_t* capacity, size_t element_size) {
+    size_t new_capacity = *capacity ? *capacity * 2 : 256;
+    array = realloc(array, new_capacity * element_size);
+    if (!array) {
+        fprintf(stderr, "Failed to allocate memory for the AST walk.\n");
+        exit(EXIT_FAILURE);
+    }
+    *capacity = new_capacity;
+    return array;
+}
+
+void ast_visitor_init(ASTVisitor* visitor, ASTVisitFn pre, ASTVisitFn post, void* data) {
+    visitor->pre = pre;
+    visitor->post = post;
+    visitor->data = data;
+    visitor->frames = NULL;
+    visitor->frame_count = 0;
+    visitor->frame_capacity = 0;
+    visitor->scheduled = 0;
+    visitor->current = NULL;
+    visitor->values = NULL;
+    visitor->value_count = 0;
+    visitor->value_capacity = 0;
+}
+
+void ast_visitor_free(ASTVisitor* visitor) {
+    free(visitor->frames);
+    free(visitor->values);
+    visitor->frames = NULL;
+    visitor->values = NULL;
+    visitor->frame_count = visitor->frame_capacity = 0;
+    visitor->value_count = visitor->value_capacity = 0;
+}
+
+static void push_frame(ASTVisitor* visitor, ASTNode* node, ASTNode* parent,
+                       int tag, int level, int post, int list) {
+    if (visitor->frame_count == visitor->frame_capacity) {
+        visitor->frames = (ASTVisitFrame*)grow(visitor->frames, &visitor->frame_capacity,
+                                               sizeof(ASTVisitFrame));
+    }
+    ASTVisitFrame* frame = &visitor->frames[visitor->frame_count++];
+    frame->visit.node = node;
+    frame->visit.parent = parent;
+    frame->visit.tag = tag;
+    frame->visit.level = level;
+    frame->post = (uint8_t)post;
+    frame->list = (uint8_t)list;
+}
+
+/* Run the visits pushed above 'bottom' */
+static void run(ASTVisitor* visitor, size_t bottom) {
+    size_t outer_scheduled = visitor->scheduled;
+    ASTNode* outer_current = visitor->current;
+
+    while (visitor->frame_count > bottom) {
+        /* A copy: callbacks may grow, and so move, the stack */
+        ASTVisitFrame frame = visitor->frames[--visitor->frame_count];
+        if (frame.post) {
+            visitor->post(visitor, &frame.visit);
+            continue;
+        }
+
+        /* Below this node's subtree: its next sibling, then its 'post' */
+        ASTNode* node = frame.visit.node;
+        if (frame.list && node && node->next) {
+            push_frame(visitor, ast_next(node), frame.visit.parent,
+                       frame.visit.tag, frame.visit.level, 0, 1);
+        }
+        if (visitor->post) {
+            push_frame(visitor, node, frame.visit.parent, frame.visit.tag, frame.visit.level, 1, 0);
+        }
+
+        visitor->scheduled = visitor->frame_count;
+        visitor->current = node;
+        visitor->pre(visitor, &frame.visit);
+
+        /* Scheduled nodes were pushed in order; reverse them so the first
+           is popped first */
+        ASTVisitFrame* low = &visitor->frames[visitor->scheduled];
+        ASTVisitFrame* high = &visitor->frames[visitor->frame_count];
+        while (high - low > 1) {
+            ASTVisitFrame swap = *low;
+            *low++ = *--high;
+            *high = swap;
+        }
+    }
+
+    visitor->scheduled = outer_scheduled;
+    visitor->current = outer_current;
+}
+
+void ast_walk(ASTVisitor* visitor, ASTNode* root, int tag, int level) {
+    size_t bottom = visitor->frame_count;
+    push_frame(visitor, root, NULL, tag, level, 0, 0);
+    run(visitor, bottom);
+}
+
+void ast_walk_list(ASTVisitor* visitor, ASTNode* first, int tag, int level) {
+    if (!first) return;
+    size_t bottom = visitor->frame_count;
+    push_frame(visitor, first, NULL, tag, level, 0, 1);
+    run(visitor, bottom);
+}
+
+void ast_visit_child(ASTVisitor* visitor, ASTNode* node, int tag, int level) {
+    push_frame(visitor, node, visitor->current, tag, level, 0, 0);
+}
+
+void ast_visit_list(ASTVisitor* visitor, ASTNode* first, int tag, int level) {
+    if (first) push_frame(visitor, first, visitor->current, tag, level, 0, 1);
+}
+
+void ast_push_value(ASTVisitor* visitor, intptr_t value) {
+    if (visitor->value_count == visitor->value_capacity) {
+        visitor->values = (intptr_t*)grow(visitor->values, &visitor->value_capacity, sizeof(intptr_t));
+    }
+    visitor->values[visitor->value_count++] = value;
+}
+
+intptr_t ast_pop_value(ASTVisitor* visitor) {
+    return visitor->values[--visitor->value_count];
+}
@@ -0,0 +1,80 @@
+/* ast_visit.h */
+
+#ifndef AST_VISIT_H
+#define AST_VISIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ast.h"
+
+/*
+ * Depth-first walk of a tree on an explicit stack kept on the heap, so
+ * the nesting depth a pass can handle is limited by memory rather than
+ * by the C stack.
+ *
+ * A pass supplies a 'pre' callback, called when a node is reached, and
+ * optionally a 'post' callback, called once everything 'pre' scheduled
+ * under the node has been walked. 'pre' decides which children to walk
+ * and in what order by scheduling them with ast_visit_child() or
+ * ast_visit_list(); it can schedule any node, in any order, or none.
+ * Each scheduled node carries a tag and a level chosen by the pass,
+ * e.g. which child it is and its indentation, and may be NULL.
+ *
+ * Passes that compute a value per node (a type, a temporary) keep them
+ * on the visitor's value stack: a node's 'post' pops the values of its
+ * children and pushes its own.
+ */
+
+typedef struct ASTVisit {
+    ASTNode* node;       /* The node; NULL if NULL was scheduled */
+    ASTNode* parent;     /* Node whose 'pre' scheduled it; NULL for the root */
+    int tag;             /* Chosen by whoever scheduled the node */
+    int level;           /* Likewise */
+} ASTVisit;
+
+typedef struct ASTVisitor ASTVisitor;
+typedef void (*ASTVisitFn)(ASTVisitor* visitor, const ASTVisit* visit);
+
+struct ASTVisitor {
+    ASTVisitFn pre;
+    ASTVisitFn post;         /* May be NULL */
+    void* data;              /* For the pass */
+
+    /* The stack of pending visits */
+    struct ASTVisitFrame* frames;
+    size_t frame_count;
+    size_t frame_capacity;
+    size_t scheduled;        /* First frame scheduled by the running 'pre' */
+    ASTNode* current;        /* Node of the running 'pre' */
+
+    /* The value stack */
+    intptr_t* values;
+    size_t value_count;
+    size_t value_capacity;
+};
+
+/* Set up a visitor; its stacks grow as needed */
+void ast_visitor_init(ASTVisitor* visitor, ASTVisitFn pre, ASTVisitFn post, void* data);
+
+/* Free the visitor's stacks */
+void ast_visitor_free(ASTVisitor* visitor);
+
+/* Walk the tree under 'root' (which may be NULL), or the list starting
+   at 'first' */
+void ast_walk(ASTVisitor* visitor, ASTNode* root, int tag, int level);
+void ast_walk_list(ASTVisitor* visitor, ASTNode* first, int tag, int level);
+
+/* From 'pre': walk 'node' after the nodes already scheduled, or each
+   node of the list starting at 'first' */
+void ast_visit_child(ASTVisitor* visitor, ASTNode* node, int tag, int level);
+void ast_visit_list(ASTVisitor* visitor, ASTNode* first, int tag, int level);
+
+/* The value stack */
+void ast_push_value(ASTVisitor* visitor, intptr_t value);
+intptr_t ast_pop_value(ASTVisitor* visitor);
+
+static inline intptr_t ast_peek_value(const ASTVisitor* visitor, size_t depth) {
+    return visitor->values[visitor->value_count - 1 - depth];
+}
+
+#endif /* AST_VISIT_H */
@@ -0,0 +1,81 @@
+/* ast_alloc_bench.c - building and freeing large ASTs, malloc against the node array
+ *
+ * Builds the same tree both ways: once in the old pointer layout with one
+ * malloc per node, a strdup per operator and a malloc per array-size
+ * vector, freed by a walk over the tree (how ast.c used to work), and
+ * once in the node array of ast.h, freed with ast_free_all(). Each
+ * statement is an assignment of a nine-node expression; every tenth is
+ * an array declaration.
+ *
+ * Usage: ast_alloc_bench [statements] [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ast_trees.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const PointerAllocator with_malloc = { malloc, strdup };
+
+static long count_nodes(const PointerNode* node) {
+    long count = 0;
+    for (; node; node = node->next) {
+        count += 1 + count_nodes(node->left) + count_nodes(node->right);
+    }
+    return count;
+}
+
+/* Node-by-node teardown, as free_ast() did before the arena */
+static void free_tree(PointerNode* root) {
+    while (root) {
+        PointerNode* next = root->next;
+        free(root->operator);
+        free(root->array_sizes);
+        free_tree(root->left);
+        free_tree(root->right);
+        free(root);
+        root = next;
+    }
+}
+
+int main(int argc, char** argv) {
+    long statements = argc > 1 ? atol(argv[1]) : 1000000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 3;
+
+    double build[2] = { 1e30, 1e30 };
+    double teardown[2] = { 1e30, 1e30 };
+    long nodes[2] = { 0, 0 };
+    for (int compact = 0; compact < 2; compact++) {
+        for (int i = 0; i < iterations; i++) {
+            double t0 = now_seconds();
+            PointerNode* root = compact ? NULL : build_pointer_tree(&with_malloc, statements);
+            if (compact) build_compact_tree(statements);
+            double t1 = now_seconds();
+            nodes[compact] = compact ? (long)ast_node_count() : count_nodes(root);
+            double t2 = now_seconds();
+            if (compact) {
+                ast_free_all();
+            } else {
+                free_tree(root);
+            }
+            double t3 = now_seconds();
+            if (t1 - t0 < build[compact]) build[compact] = t1 - t0;
+            if (t3 - t2 < teardown[compact]) teardown[compact] = t3 - t2;
+        }
+        printf("%-7s %9ld nodes  build %8.4f s %6.1f ns/node  teardown %9.6f s %6.2f ns/node\n",
+               compact ? "array" : "malloc", nodes[compact], build[compact],
+               build[compact] / nodes[compact] * 1e9,
+               teardown[compact], teardown[compact] / nodes[compact] * 1e9);
+    }
+    printf("build %.2fx faster, teardown %.0fx faster\n",
+           build[0] / build[1], teardown[0] / teardown[1]);
+    intern_free_all();
+    return 0;
+}
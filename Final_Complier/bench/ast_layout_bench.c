@@ -0,0 +1,91 @@
+/* ast_layout_bench.c - memory and traversal cost of the AST node layout
+ *
+ * Builds the same tree in the old pointer layout (bump-allocated, as the
+ * arena did) and in the compact node array of ast.h, then reports the
+ * bytes per node, the build time and the time of a recursive walk that
+ * touches what the semantic pass reads from every node: its type,
+ * location and payload, and all of its children.
+ *
+ * Usage: ast_layout_bench [statements] [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ast_trees.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char* arena_strdup(const char* text) {
+    size_t length = strlen(text) + 1;
+    return memcpy(ast_alloc(length), text, length);
+}
+
+static const PointerAllocator with_arena = { ast_alloc, arena_strdup };
+
+static unsigned long walk_pointer(const PointerNode* node) {
+    unsigned long sum = 0;
+    for (; node; node = node->next) {
+        sum += node->type + node->offset;
+        if (node->type == AST_EXPRESSION) sum += node->value + node->operator[0];
+        sum += walk_pointer(node->left) + walk_pointer(node->right) +
+               walk_pointer(node->condition) + walk_pointer(node->body) +
+               walk_pointer(node->arguments);
+    }
+    return sum;
+}
+
+static unsigned long walk_compact(const ASTNode* node) {
+    unsigned long sum = 0;
+    for (; node; node = ast_next(node)) {
+        sum += node->type + node->offset;
+        if (node->type == AST_EXPRESSION) sum += ast_value(node) + node->u.expr.kind;
+        sum += walk_compact(ast_left(node)) + walk_compact(ast_right(node)) +
+               walk_compact(ast_condition(node)) + walk_compact(ast_body(node)) +
+               walk_compact(ast_arguments(node));
+    }
+    return sum;
+}
+
+int main(int argc, char** argv) {
+    long statements = argc > 1 ? atol(argv[1]) : 200000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+    static const char* names[2] = { "pointer", "compact" };
+    static const size_t node_size[2] = { sizeof(PointerNode), sizeof(ASTNode) };
+
+    double build[2] = { 1e30, 1e30 };
+    double walk[2] = { 1e30, 1e30 };
+    unsigned long checksum = 0;
+    size_t nodes = 0;
+    for (int compact = 0; compact < 2; compact++) {
+        double t0 = now_seconds();
+        PointerNode* pointer_root = compact ? NULL : build_pointer_tree(&with_arena, statements);
+        ASTNode* compact_root = compact ? build_compact_tree(statements) : NULL;
+        build[compact] = now_seconds() - t0;
+        if (compact) nodes = ast_node_count();
+
+        for (int i = 0; i < iterations; i++) {
+            double t1 = now_seconds();
+            checksum += compact ? walk_compact(compact_root) : walk_pointer(pointer_root);
+            double t2 = now_seconds();
+            if (t2 - t1 < walk[compact]) walk[compact] = t2 - t1;
+        }
+        ast_free_all();
+    }
+
+    for (int compact = 0; compact < 2; compact++) {
+        printf("%-8s %9zu nodes %4zu B/node %8.1f MB  build %7.4f s  walk %7.4f s %5.2f ns/node\n",
+               names[compact], nodes, node_size[compact], nodes * node_size[compact] / 1e6,
+               build[compact], walk[compact], walk[compact] / nodes * 1e9);
+    }
+    printf("%.1fx less node memory, build %.2fx faster, walk %.2fx faster (checksum %lu)\n",
+           (double)node_size[0] / node_size[1], build[0] / build[1], walk[0] / walk[1],
+           checksum);
+    intern_free_all();
+    return 0;
+}
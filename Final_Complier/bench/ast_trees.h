@@ -0,0 +1,153 @@
+/* ast_trees.h - the same large AST built in the old and the current node layout
+ *
+ * PointerNode is the node layout used before the compact node array of
+ * ast.h: one struct with a field for everything any node type needs,
+ * children linked by pointer. Both builders make a main body of
+ * assignments of a nine-node expression, x = (x + y * 3) / (y - 1),
+ * with an array declaration every tenth statement.
+ */
+
+#ifndef AST_TREES_H
+#define AST_TREES_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ast.h"
+#include "intern.h"
+
+typedef struct PointerNode PointerNode;
+
+struct PointerNode {
+    ASTNodeType type;
+    uint32_t offset;
+    const char* name;
+    DataType data_type;
+    SymbolCategory category;
+    int increment;
+    char* operator;
+    int value;
+    float float_value;
+    const char* string;
+
+    PointerNode* left;
+    PointerNode* right;
+    PointerNode* next;
+    PointerNode* last_child;
+    PointerNode* condition;
+    PointerNode* body;
+    PointerNode* parameters;
+    PointerNode* arguments;
+
+    int* array_sizes;
+    int dimensions;
+};
+
+/* Where pointer-layout nodes, operator strings and size vectors come from */
+typedef struct PointerAllocator {
+    void* (*alloc)(size_t size);
+    char* (*string)(const char* text);
+} PointerAllocator;
+
+static PointerNode* pointer_node(const PointerAllocator* a, ASTNodeType type) {
+    PointerNode* node = (PointerNode*)a->alloc(sizeof(PointerNode));
+    if (!node) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(node, 0, sizeof(PointerNode));
+    node->type = type;
+    node->data_type = DT_VOID;
+    return node;
+}
+
+static PointerNode* pointer_expression(const PointerAllocator* a, const char* operator,
+                                       PointerNode* left, PointerNode* right) {
+    PointerNode* node = pointer_node(a, AST_EXPRESSION);
+    node->operator = a->string(operator);
+    node->left = left;
+    node->right = right;
+    return node;
+}
+
+static PointerNode* pointer_id(const PointerAllocator* a, const char* name) {
+    PointerNode* node = pointer_expression(a, "ID", NULL, NULL);
+    node->string = name;
+    return node;
+}
+
+static PointerNode* pointer_number(const PointerAllocator* a, int value) {
+    PointerNode* node = pointer_expression(a, "NUMBER", NULL, NULL);
+    node->value = value;
+    return node;
+}
+
+static PointerNode* build_pointer_tree(const PointerAllocator* a, long statements) {
+    const char* x = intern_cstr("x");
+    const char* y = intern_cstr("y");
+    PointerNode* program = pointer_node(a, AST_PROGRAM);
+    PointerNode* function = pointer_node(a, AST_MAIN_FUNCTION);
+    PointerNode* body = pointer_node(a, AST_BLOCK);
+    program->left = function;
+    function->left = body;
+
+    PointerNode** tail = &body->left;
+    for (long i = 0; i < statements; i++) {
+        PointerNode* stmt;
+        if (i % 10 == 0) {
+            stmt = pointer_node(a, AST_DECLARATION);
+            stmt->name = x;
+            stmt->category = SYMBOL_ARRAY;
+            stmt->dimensions = 2;
+            stmt->array_sizes = (int*)a->alloc(2 * sizeof(int));
+            stmt->array_sizes[0] = 4;
+            stmt->array_sizes[1] = 8;
+        } else {
+            stmt = pointer_node(a, AST_ASSIGNMENT);
+            stmt->name = x;
+            stmt->left = pointer_expression(a, "/",
+                pointer_expression(a, "+", pointer_id(a, x),
+                    pointer_expression(a, "*", pointer_id(a, y), pointer_number(a, 3))),
+                pointer_expression(a, "-", pointer_id(a, y), pointer_number(a, 1)));
+        }
+        stmt->offset = (uint32_t)i;
+        *tail = stmt;
+        tail = &stmt->next;
+    }
+    return program;
+}
+
+static ASTNode* build_compact_tree(long statements) {
+    static const int sizes[2] = { 4, 8 };
+    const char* x = intern_cstr("x");
+    const char* y = intern_cstr("y");
+    ASTNode* program = create_ast_node(AST_PROGRAM);
+    ASTNode* function = create_ast_node(AST_MAIN_FUNCTION);
+    ASTNode* body = create_ast_node(AST_BLOCK);
+    add_child(program, function);
+    add_child(function, body);
+
+    ASTList list = ast_list(NULL);
+    for (long i = 0; i < statements; i++) {
+        ASTNode* stmt;
+        if (i % 10 == 0) {
+            stmt = create_ast_node(AST_DECLARATION);
+            ast_set_name(stmt, x);
+            stmt->category = SYMBOL_ARRAY;
+            ast_set_array_sizes(stmt, sizes, 2);
+        } else {
+            stmt = create_ast_node(AST_ASSIGNMENT);
+            ast_set_name(stmt, x);
+            add_child(stmt, create_binary_node(BINOP_DIV,
+                create_binary_node(BINOP_ADD, create_id_node(x),
+                    create_binary_node(BINOP_MUL, create_id_node(y), create_number_node(3))),
+                create_binary_node(BINOP_SUB, create_id_node(y), create_number_node(1))));
+        }
+        stmt->offset = (uint32_t)i;
+        add_sibling(&list, stmt);
+    }
+    add_children(body, list);
+    return program;
+}
+
+#endif /* AST_TREES_H */
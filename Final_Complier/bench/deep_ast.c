@@ -0,0 +1,182 @@
+/* deep_ast.c - passes over trees nested 10^6 deep
+ *
+ * Builds a main function holding one statement nested 'depth' levels
+ * deep, in several shapes, and runs the semantic checks and TAC
+ * generation over each. The passes walk the tree on an explicit stack
+ * (see ast_visit.h), so this must not overflow the C stack whatever the
+ * depth; recursive passes crash at a few hundred thousand levels.
+ *
+ * print_ast indents each line by its depth, so its output grows with
+ * the square of the depth; it is run (into /dev/null) on trees of
+ * 'print-depth' levels instead.
+ *
+ * Usage: deep_ast [depth] [print-depth]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "ast.h"
+#include "semantic.h"
+#include "codegen.h"
+#include "symbol_table.h"
+#include "resolve.h"
+#include "intern.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const char* x;
+static const char* f;
+
+/* A use of x, bound as the parsers bind it */
+static ASTNode* use_x(void) {
+    ASTNode* e = create_id_node(x);
+    resolve_name(e);
+    return e;
+}
+
+/* x + x + ... + x, nested to the left */
+static ASTNode* left_sum(long depth) {
+    ASTNode* e = use_x();
+    for (long i = 0; i < depth; i++) e = create_binary_node(BINOP_ADD, e, use_x());
+    return e;
+}
+
+/* x - (x - (... - x)), nested to the right */
+static ASTNode* right_difference(long depth) {
+    ASTNode* e = use_x();
+    for (long i = 0; i < depth; i++) e = create_binary_node(BINOP_SUB, use_x(), e);
+    return e;
+}
+
+/* !!...!x */
+static ASTNode* negations(long depth) {
+    ASTNode* e = use_x();
+    for (long i = 0; i < depth; i++) e = create_not_node(e);
+    return e;
+}
+
+/* f(f(...f(x))) */
+static ASTNode* calls(long depth) {
+    ASTNode* e = use_x();
+    for (long i = 0; i < depth; i++) {
+        ASTNode* call = create_ast_node(AST_FUNCTION_CALL);
+        ast_set_name(call, f);
+        resolve_name(call);
+        call->right = ast_index(e);
+        e = call;
+    }
+    return e;
+}
+
+static ASTNode* assign_x(ASTNode* value) {
+    ASTNode* assignment = create_ast_node(AST_ASSIGNMENT);
+    ast_set_name(assignment, x);
+    add_child(assignment, value);
+    resolve_name(assignment);
+    return assignment;
+}
+
+/* if (x < 1) if (x < 1) ... x = 1; or the same with while */
+static ASTNode* nested(ASTNodeType type, long depth) {
+    ASTNode* stmt = assign_x(create_number_node(1));
+    for (long i = 0; i < depth; i++) {
+        ASTNode* outer = create_ast_node(type);
+        outer->u.condition = ast_index(create_binary_node(BINOP_LT, use_x(), create_number_node(1)));
+        outer->right = ast_index(stmt);
+        stmt = outer;
+    }
+    return stmt;
+}
+
+static ASTNode* build(int shape, long depth) {
+    ASTNode* stmt;
+    switch (shape) {
+        case 0: stmt = assign_x(left_sum(depth)); break;
+        case 1: stmt = assign_x(right_difference(depth)); break;
+        case 2: stmt = assign_x(negations(depth)); break;
+        case 3: stmt = assign_x(calls(depth)); break;
+        case 4: stmt = nested(AST_IF, depth); break;
+        default: stmt = nested(AST_WHILE, depth); break;
+    }
+    ASTNode* function = create_ast_node(AST_MAIN_FUNCTION);
+    ASTNode* body = create_ast_node(AST_BLOCK);
+    add_child(function, body);
+    add_child(body, stmt);
+    return function;
+}
+
+static void print_to_null(const ASTNode* tree) {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    close(null);
+    print_ast(tree, 0);
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+}
+
+int main(int argc, char** argv) {
+    long depth = argc > 1 ? atol(argv[1]) : 1000000;
+    long print_depth = argc > 2 ? atol(argv[2]) : 20000;
+    static const char* shapes[] = {
+        "x + x + ...", "x - (x - ...)", "!!...x", "f(f(...))", "if (..) if (..)", "while (..) while (..)",
+    };
+
+    /* The TAC file goes to a scratch directory */
+    char dir[] = "/tmp/deep_astXXXXXX";
+    if (!mkdtemp(dir) || chdir(dir) != 0) {
+        perror("deep_ast: scratch directory");
+        return EXIT_FAILURE;
+    }
+
+    init_symbol_table();
+    x = intern_cstr("x");
+    f = intern_cstr("f");
+    add_symbol(x, DT_INT, SYMBOL_VARIABLE, DT_VOID, NULL, NULL, 0);
+    add_symbol(f, DT_INT, SYMBOL_FUNCTION, DT_INT, NULL, NULL, 0);
+
+    int failed = 0;
+    generate_tac_begin();
+    for (int shape = 0; shape < 6; shape++) {
+        double t0 = now_seconds();
+        ASTNode* tree = build(shape, depth);
+        double t1 = now_seconds();
+        int errors = traverse_function(tree);
+        double t2 = now_seconds();
+        generate_tac_function(tree);
+        double t3 = now_seconds();
+        ast_free_all();
+
+        tree = build(shape, print_depth);
+        double t4 = now_seconds();
+        print_to_null(tree);
+        double t5 = now_seconds();
+        ast_free_all();
+
+        printf("%-22s depth %8ld  build %6.3f s  check %6.3f s  tac %6.3f s  print (depth %ld) %6.3f s%s\n",
+               shapes[shape], depth, t1 - t0, t2 - t1, t3 - t2, print_depth, t5 - t4,
+               errors ? "  UNEXPECTED SEMANTIC ERRORS" : "");
+        failed |= errors != 0;
+    }
+    generate_tac_end();
+
+    struct stat st;
+    if (stat("tac_output.txt", &st) == 0) printf("%.1f MB of TAC\n", st.st_size / 1e6);
+    unlink("tac_output.txt");
+    if (chdir("/") == 0) rmdir(dir);
+
+    free_all_symbol_tables();
+    intern_free_all();
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
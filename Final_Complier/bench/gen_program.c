@@ -0,0 +1,67 @@
+/* gen_program.c - generate large, valid input programs for benchmarks
+ *
+ * Usage: gen_program [functions] [statements-per-function] [main-statements]
+ *
+ * Every function gets its own identifier names, so the program is also
+ * semantically clean for builds that declared every local in one
+ * global scope, and benchmarks stay comparable across them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static void gen_function(int f, int statements) {
+    printf("int f%d(int a%d, int b%d)\n{\n", f, f, f);
+    printf("    int v%d_0 = a%d + b%d * 3;\n", f, f, f);
+    printf("    float g%d = 2.5;\n", f);
+    for (int j = 1; j < statements; j++) {
+        switch (j % 5) {
+            case 0:
+                printf("    int v%d_%d = (v%d_%d + %d) * a%d - b%d / 2;\n", f, j, f, j - 1, j, f, f);
+                break;
+            case 1:
+                printf("    int v%d_%d = v%d_%d * %d + a%d;\n", f, j, f, j - 1, j, f);
+                break;
+            case 2:
+                printf("    if (v%d_%d < b%d && a%d != %d)\n    {\n        write v%d_%d;\n    }\n",
+                       f, j - 1, f, f, j, f, j - 1);
+                printf("    int v%d_%d = v%d_%d - 1;\n", f, j, f, j - 1);
+                break;
+            case 3:
+                printf("    while (a%d > %d)\n    {\n        a%d = a%d - 1;\n    }\n", f, j, f, f);
+                printf("    int v%d_%d = a%d;\n", f, j, f);
+                break;
+            default:
+                printf("    int v%d_%d = v%d_%d + v%d_%d;\n", f, j, f, j - 1, f, j - 1);
+                break;
+        }
+    }
+    printf("    return v%d_%d;\n}\n\n", f, statements - 1);
+}
+
+int main(int argc, char** argv) {
+    int functions = argc > 1 ? atoi(argv[1]) : 1000;
+    int statements = argc > 2 ? atoi(argv[2]) : 50;
+    int main_statements = argc > 3 ? atoi(argv[3]) : functions;
+    if (statements < 1) statements = 1;
+
+    for (int f = 0; f < functions; f++) {
+        gen_function(f, statements);
+    }
+
+    printf("int main() {\n");
+    printf("    int r = 0;\n");
+    printf("    int i = 0;\n");
+    for (int s = 0; s < main_statements; s++) {
+        if (functions > 0 && s < functions) {
+            printf("    r = r + f%d(%d, %d);\n", s, s, s + 1);
+        } else if (s % 2 == 0) {
+            printf("    i = i + %d;\n", s % 7 + 1);
+        } else {
+            printf("    r = r * 2 - i;\n");
+        }
+    }
+    printf("    write r;\n");
+    printf("    return 0;\n}\n");
+    return 0;
+}
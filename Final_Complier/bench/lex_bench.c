@@ -0,0 +1,95 @@
+/* lex_bench.c - scanner throughput: stdio stream vs. mapped buffer
+ *
+ * Linked once per scanner backend (bench/lex_bench_flex, bench/lex_bench_simd).
+ *
+ * Usage: lex_bench file [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "parser.tab.h"
+#include "lexer.h"
+#include "source.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Pull every token out of the current scanner input */
+static long drain_tokens(Lexer* lexer) {
+    YYSTYPE value;
+    long tokens = 0;
+    while (lexer_lex(lexer, &value) != 0) {
+        tokens++;
+    }
+    lexer_finish(lexer);
+    return tokens;
+}
+
+static long scan_stream(Lexer* lexer, const char* path) {
+    FILE* in = fopen(path, "r");
+    if (!in) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    lexer_scan_stream(lexer, in);
+    long tokens = drain_tokens(lexer);
+    fclose(in);
+    return tokens;
+}
+
+static long scan_mapped(Lexer* lexer, const char* path) {
+    SourceBuffer src;
+    if (source_map_file(path, &src) != 0) {
+        fprintf(stderr, "%s: not a mappable file\n", path);
+        exit(EXIT_FAILURE);
+    }
+    lexer_scan_buffer(lexer, src.data, src.length);
+    long tokens = drain_tokens(lexer);
+    source_release(&src);
+    return tokens;
+}
+
+static void report(const char* label, long bytes, long tokens, double seconds) {
+    printf("%-8s %10ld bytes %9ld tokens %8.4f s %9.1f MB/s %8.2f Mtok/s\n",
+           label, bytes, tokens, seconds, bytes / seconds / 1e6, tokens / seconds / 1e6);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s file [iterations]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char* path = argv[1];
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+
+    SourceBuffer probe;
+    if (source_map_file(path, &probe) != 0) return EXIT_FAILURE;
+    long bytes = (long)probe.length;
+    source_release(&probe);
+
+    Lexer* lexer = lexer_create();
+
+    /* Warm the page cache so both paths read from memory */
+    scan_stream(lexer, path);
+
+    double best_stream = 1e30, best_mapped = 1e30;
+    long tokens = 0;
+    for (int i = 0; i < iterations; i++) {
+        double t0 = now_seconds();
+        tokens = scan_stream(lexer, path);
+        double t1 = now_seconds();
+        scan_mapped(lexer, path);
+        double t2 = now_seconds();
+        if (t1 - t0 < best_stream) best_stream = t1 - t0;
+        if (t2 - t1 < best_mapped) best_mapped = t2 - t1;
+    }
+
+    report("stdio", bytes, tokens, best_stream);
+    report("mmap", bytes, tokens, best_mapped);
+    lexer_destroy(lexer);
+    return 0;
+}
@@ -0,0 +1,98 @@
+/* lex_scaling.c - parallel lexing into a token buffer, 1..N threads
+ *
+ * Every run is checked against the serial token stream. Needs the
+ * hand-written scanner (bench/lex_scaling is linked with scanner.o).
+ *
+ * Usage: lex_scaling file [max-threads] [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "parser.tab.h"
+#include "lexer.h"
+#include "source.h"
+#include "tokens.h"
+#include "intern.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Lex the mapped source with 'threads' threads, 0 meaning the serial
+   scanner loop. Atoms are reset first so ids are comparable. */
+static double lex_once(SourceBuffer* src, int threads, TokenBuffer* tokens) {
+    intern_free_all();
+    token_buffer_free(tokens);
+    Lexer* lexer = lexer_create();
+    lexer_scan_buffer(lexer, src->data, src->length);
+    double t0 = now_seconds();
+    if (threads > 0) {
+        tokens_lex_parallel(tokens, lexer, threads);
+    } else {
+        tokens_lex_all(tokens, lexer);
+    }
+    double t1 = now_seconds();
+    lexer_destroy(lexer);
+    return t1 - t0;
+}
+
+static int same_tokens(const TokenBuffer* a, const TokenBuffer* b) {
+    return a->count == b->count &&
+           memcmp(a->kind, b->kind, a->count * sizeof(*a->kind)) == 0 &&
+           memcmp(a->offset, b->offset, a->count * sizeof(*a->offset)) == 0 &&
+           memcmp(a->value, b->value, a->count * sizeof(*a->value)) == 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s file [max-threads] [iterations]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char* path = argv[1];
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = argc > 2 ? atoi(argv[2]) : (int)(cpus > 0 ? cpus : 1);
+    int iterations = argc > 3 ? atoi(argv[3]) : 5;
+
+    SourceBuffer src;
+    if (source_map_file(path, &src) != 0) {
+        fprintf(stderr, "%s: not a mappable file\n", path);
+        return EXIT_FAILURE;
+    }
+
+    TokenBuffer serial, parallel;
+    token_buffer_init(&serial);
+    token_buffer_init(&parallel);
+
+    double best_serial = 1e30;
+    for (int i = 0; i < iterations; i++) {
+        double t = lex_once(&src, 0, &serial);
+        if (t < best_serial) best_serial = t;
+    }
+    printf("serial   %10zu bytes %9zu tokens %8.4f s %9.1f MB/s\n",
+           src.length, serial.count, best_serial, src.length / best_serial / 1e6);
+
+    int status = 0;
+    for (int threads = 1; threads <= max_threads; threads++) {
+        double best = 1e30;
+        for (int i = 0; i < iterations; i++) {
+            double t = lex_once(&src, threads, &parallel);
+            if (t < best) best = t;
+        }
+        int same = same_tokens(&serial, &parallel);
+        if (!same) status = EXIT_FAILURE;
+        printf("%2d thr   %10zu bytes %9zu tokens %8.4f s %9.1f MB/s %6.2fx %s\n",
+               threads, src.length, parallel.count, best, src.length / best / 1e6,
+               best_serial / best, same ? "" : "MISMATCH");
+    }
+
+    token_buffer_free(&serial);
+    token_buffer_free(&parallel);
+    intern_free_all();
+    source_release(&src);
+    return status;
+}
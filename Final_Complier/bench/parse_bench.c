@@ -0,0 +1,159 @@
+/* parse_bench.c - bison parser against the recursive-descent parser
+ *
+ * The input is lexed once into a token buffer and both parsers replay
+ * it, so only parsing (and tree building) is timed. The trees the two
+ * parsers build are compared node by node. Without a file, a program of
+ * expression statements over a few variables is generated, so symbol
+ * table lookups do not dominate the parse.
+ *
+ * Usage: parse_bench [file | -] [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "parser.tab.h"
+#include "rd_parser.h"
+#include "ast.h"
+#include "symbol_table.h"
+#include "lexer.h"
+#include "source.h"
+#include "tokens.h"
+#include "intern.h"
+#include "diag.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Main body of 'statements' expression-heavy assignments, padded as
+   source.h requires */
+static void make_program(SourceBuffer* src, long statements) {
+    static const char head[] = "int main()\n{\n    int x = 1;\n    int y = 2;\n";
+    static const char stmt[] = "    x = (x + y * 3) / (y - 1) < x && !y || x == y + 1;\n";
+    static const char tail[] = "    return 0;\n}\n";
+    size_t length = strlen(head) + statements * strlen(stmt) + strlen(tail);
+    char* text = malloc(length + SOURCE_PADDING);
+    if (!text) {
+        fprintf(stderr, "Out of memory for %ld statements\n", statements);
+        exit(EXIT_FAILURE);
+    }
+    char* p = text;
+    memcpy(p, head, strlen(head));
+    p += strlen(head);
+    for (long i = 0; i < statements; i++) {
+        memcpy(p, stmt, strlen(stmt));
+        p += strlen(stmt);
+    }
+    memcpy(p, tail, strlen(tail));
+    memset(text + length, 0, SOURCE_PADDING);
+    src->data = text;
+    src->length = length;
+    src->mapping_length = 0;
+}
+
+static int same_string(const char* a, const char* b) {
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+/* Structural equality of two trees, siblings included */
+static int same_tree(const ASTNode* a, const ASTNode* b) {
+    for (; a && b; a = ast_next(a), b = ast_next(b)) {
+        if (a->type != b->type || a->offset != b->offset ||
+            a->data_type != b->data_type || a->category != b->category ||
+            a->dimensions != b->dimensions ||
+            !same_string(ast_name(a), ast_name(b)) ||
+            !same_string(ast_operator(a), ast_operator(b))) {
+            return 0;
+        }
+        if (a->type == AST_EXPRESSION && ast_value(a) != ast_value(b)) {
+            return 0;
+        }
+        if (a->dimensions > 0 &&
+            memcmp(ast_array_sizes(a), ast_array_sizes(b), a->dimensions * sizeof(int)) != 0) {
+            return 0;
+        }
+        if (!same_tree(ast_left(a), ast_left(b)) || !same_tree(ast_right(a), ast_right(b)) ||
+            !same_tree(ast_condition(a), ast_condition(b)) || !same_tree(ast_body(a), ast_body(b)) ||
+            !same_tree(ast_arguments(a), ast_arguments(b))) {
+            return 0;
+        }
+    }
+    return a == b;
+}
+
+/* Parse the token buffer once with the chosen parser; returns the time
+   taken and stores the tree in *root */
+static double parse_once(const TokenBuffer* tokens, int rd, ASTNode** root) {
+    init_symbol_table();
+    ParseContext ctx;
+    parse_context_init(&ctx, NULL);
+    tokens_replay(&ctx, tokens);
+
+    double t0 = now_seconds();
+    int status = rd ? rd_parse(&ctx) : yyparse(&ctx);
+    double t1 = now_seconds();
+
+    if (status != 0) {
+        fprintf(stderr, "%s parser failed\n", rd ? "recursive-descent" : "bison");
+        exit(EXIT_FAILURE);
+    }
+    free_all_symbol_tables();
+    *root = ctx.ast_root;
+    return t1 - t0;
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 && strcmp(argv[1], "-") != 0 ? argv[1] : NULL;
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+
+    SourceBuffer src;
+    if (!path) {
+        make_program(&src, 100000);
+    } else if (source_map_file(path, &src) != 0) {
+        fprintf(stderr, "%s: not a mappable file\n", path);
+        return EXIT_FAILURE;
+    }
+    diag_init(DIAG_SILENT);
+    source_set_current(&src);
+
+    TokenBuffer tokens;
+    token_buffer_init(&tokens);
+    Lexer* lexer = lexer_create();
+    lexer_scan_buffer(lexer, src.data, src.length);
+    tokens_lex_all(&tokens, lexer);
+    lexer_destroy(lexer);
+
+    ASTNode* trees[2];
+    double best[2] = { 1e30, 1e30 };
+    for (int rd = 0; rd < 2; rd++) {
+        for (int i = 0; i < iterations; i++) {
+            /* Only the first tree of each parser is kept */
+            ASTMark mark = ast_mark();
+            ASTNode* root;
+            double t = parse_once(&tokens, rd, &root);
+            if (t < best[rd]) best[rd] = t;
+            if (i == 0) {
+                trees[rd] = root;
+            } else {
+                ast_release(mark);
+            }
+        }
+        printf("%-18s %9zu tokens %8.4f s %8.1f ns/token %9.1f MB/s\n",
+               rd ? "recursive-descent" : "bison", tokens.count, best[rd],
+               best[rd] / tokens.count * 1e9, src.length / best[rd] / 1e6);
+    }
+
+    int same = same_tree(trees[0], trees[1]);
+    printf("speedup %.2fx, trees %s\n", best[0] / best[1], same ? "identical" : "DIFFER");
+
+    ast_free_all();
+    token_buffer_free(&tokens);
+    source_set_current(NULL);
+    intern_free_all();
+    source_release(&src);
+    return same ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,114 @@
+/* parse_scaling.c - parse time per statement as the statement list grows
+ *
+ * Parses main bodies of 10^5 .. 10^6 assignment statements. Lists are
+ * built in constant time per element, so the time per statement should
+ * stay flat; a list walk per append would make it grow linearly.
+ *
+ * Usage: parse_scaling [max-statements] [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "parser.tab.h"
+#include "ast.h"
+#include "symbol_table.h"
+#include "lexer.h"
+#include "source.h"
+#include "intern.h"
+#include "diag.h"
+#include "parse_context.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* A program whose main body holds 'statements' assignments, padded as
+   source.h requires */
+static void make_program(SourceBuffer* src, long statements) {
+    static const char head[] = "int main()\n{\n    int x = 0;\n";
+    static const char stmt[] = "    x = x + 1;\n";
+    static const char tail[] = "    return 0;\n}\n";
+    size_t length = strlen(head) + statements * strlen(stmt) + strlen(tail);
+    char* text = malloc(length + SOURCE_PADDING);
+    if (!text) {
+        fprintf(stderr, "Out of memory for %ld statements\n", statements);
+        exit(EXIT_FAILURE);
+    }
+    char* p = text;
+    memcpy(p, head, strlen(head));
+    p += strlen(head);
+    for (long i = 0; i < statements; i++) {
+        memcpy(p, stmt, strlen(stmt));
+        p += strlen(stmt);
+    }
+    memcpy(p, tail, strlen(tail));
+    memset(text + length, 0, SOURCE_PADDING);
+    src->data = text;
+    src->length = length;
+    src->mapping_length = 0;
+}
+
+/* Parse the program once; returns the parse time and checks that every
+   statement made it into the tree */
+static double parse_once(SourceBuffer* src, long statements) {
+    source_set_current(src);
+    init_symbol_table();
+    ParseContext ctx;
+    parse_context_init(&ctx, lexer_create());
+    lexer_scan_buffer(ctx.lexer, src->data, src->length);
+
+    double t0 = now_seconds();
+    int status = yyparse(&ctx);
+    double t1 = now_seconds();
+
+    long count = 0;
+    if (status == 0) {
+        ASTNode* body = ast_left(ast_left(ctx.ast_root));
+        for (ASTNode* n = ast_left(body); n; n = ast_next(n)) {
+            if (n->type == AST_ASSIGNMENT) count++;
+        }
+    }
+    if (count != statements) {
+        fprintf(stderr, "Expected %ld statements, parsed %ld\n", statements, count);
+        exit(EXIT_FAILURE);
+    }
+
+    lexer_destroy(ctx.lexer);
+    free_all_symbol_tables();
+    ast_free_all();
+    source_set_current(NULL);
+    intern_free_all();
+    return t1 - t0;
+}
+
+int main(int argc, char** argv) {
+    long max_statements = argc > 1 ? atol(argv[1]) : 1000000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 3;
+    static const long sizes[] = { 100000, 200000, 500000, 1000000, 2000000, 5000000 };
+
+    diag_init(DIAG_SILENT);
+    double first_ns = 0.0;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        long statements = sizes[i];
+        if (statements > max_statements) break;
+
+        SourceBuffer src;
+        make_program(&src, statements);
+        double best = 1e30;
+        for (int it = 0; it < iterations; it++) {
+            double t = parse_once(&src, statements);
+            if (t < best) best = t;
+        }
+        source_release(&src);
+
+        double ns = best / statements * 1e9;
+        if (first_ns == 0.0) first_ns = ns;
+        printf("%8ld statements %8.4f s %8.1f ns/statement %6.2fx\n",
+               statements, best, ns, ns / first_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+/* symbol_bench.c - symbol lookup cost against scope size and depth
+ *
+ * Each name's innermost binding is found in one step (see
+ * symbol_table.c), so a lookup should cost about the same whatever the
+ * size of the scopes and however deep the name was declared.
+ *
+ * Sizes: one scope of N symbols; lookups of names it holds, in random
+ * order, and of names it does not hold.
+ *
+ * Depths: D nested scopes of 16 symbols each; lookups of names in the
+ * innermost scope, in the outermost one, and of undeclared names; and
+ * the cost of entering a scope 16 deeper, declaring 16 symbols that
+ * hide outer ones, and discarding it again, which should not allocate.
+ *
+ * Usage: symbol_bench [max-size] [max-depth]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "symbol_table.h"
+#include "intern.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define LOOKUPS 4000000L
+
+/* Interned names v<first> .. v<first + count - 1> */
+static const char** make_names(long first, long count) {
+    const char** names = malloc(sizeof(const char*) * count);
+    char buf[32];
+    for (long i = 0; i < count; i++) {
+        snprintf(buf, sizeof buf, "v%ld", first + i);
+        names[i] = intern_cstr(buf);
+    }
+    return names;
+}
+
+/* A random order of 'count' indices */
+static long* shuffled(long count) {
+    long* order = malloc(sizeof(long) * count);
+    for (long i = 0; i < count; i++) order[i] = i;
+    unsigned long state = 88172645463325252ul;
+    for (long i = count - 1; i > 0; i--) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        long j = (long)(state % (unsigned long)(i + 1));
+        long swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+    return order;
+}
+
+/* Nanoseconds per lookup of 'lookups' names taken from 'names' in
+   'order'; 'found' counts the hits so the lookups are not optimized away */
+static double time_lookups(const char** names, const long* order, long count, long lookups, long* found) {
+    double start = now_seconds();
+    for (long i = 0; i < lookups; i++) {
+        if (lookup_symbol(names[order[i % count]])) (*found)++;
+    }
+    return (now_seconds() - start) * 1e9 / lookups;
+}
+
+static void add(const char* name) {
+    add_symbol(name, DT_INT, SYMBOL_VARIABLE, DT_VOID, NULL, NULL, 0);
+}
+
+int main(int argc, char** argv) {
+    long max_size = argc > 1 ? atol(argv[1]) : 1000000;
+    long max_depth = argc > 2 ? atol(argv[2]) : 1024;
+    long found = 0;
+
+    printf("%10s  %12s  %12s\n", "scope size", "hit ns", "miss ns");
+    for (long size = 16; size <= max_size; size *= 8) {
+        const char** names = make_names(0, size);
+        const char** missing = make_names(size, size);
+        long* order = shuffled(size);
+
+        init_symbol_table();
+        enter_scope();
+        for (long i = 0; i < size; i++) add(names[i]);
+
+        double hit = time_lookups(names, order, size, LOOKUPS, &found);
+        double miss = time_lookups(missing, order, size, LOOKUPS, &found);
+        printf("%10ld  %12.1f  %12.1f\n", size, hit, miss);
+        free_all_symbol_tables();
+
+        free(order);
+        free(missing);
+        free(names);
+    }
+
+    printf("\n%10s  %12s  %12s  %12s  %12s\n", "depth", "inner ns", "outer ns", "miss ns", "scope ns");
+    for (long depth = 1; depth <= max_depth; depth *= 4) {
+        const char** names = make_names(0, 16 * depth);
+        const char** missing = make_names(16 * depth, 16);
+        long* order = shuffled(16);
+
+        init_symbol_table();
+        for (long d = 0; d < depth; d++) {
+            enter_scope();
+            for (long i = 0; i < 16; i++) add(names[16 * d + i]);
+        }
+        double outer = time_lookups(names, order, 16, LOOKUPS, &found);
+        double inner = time_lookups(names + 16 * (depth - 1), order, 16, LOOKUPS, &found);
+        double miss = time_lookups(missing, order, 16, LOOKUPS, &found);
+
+        /* 16 scopes in and out again, each hiding 16 outer names */
+        long cycles = LOOKUPS / (16 * 16);
+        double start = now_seconds();
+        for (long c = 0; c < cycles; c++) {
+            for (long d = 0; d < 16; d++) {
+                enter_scope();
+                for (long i = 0; i < 16; i++) add(names[16 * (d % depth) + i]);
+            }
+            for (long d = 0; d < 16; d++) discard_scope();
+        }
+        double scope = (now_seconds() - start) * 1e9 / (cycles * 16);
+        printf("%10ld  %12.1f  %12.1f  %12.1f  %12.1f\n", depth, inner, outer, miss, scope);
+        free_all_symbol_tables();
+
+        free(order);
+        free(missing);
+        free(names);
+    }
+
+    intern_free_all();
+    return found ? EXIT_SUCCESS : EXIT_FAILURE;
+}
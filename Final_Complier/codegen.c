@@ -3,30 +3,36 @@
 #include <string.h>
 #include "codegen.h"
 #include "ast.h"
+#include "ast_visit.h"
 
 /* File pointer for TAC output */
-static FILE* tac_out = NULL;
+static _Thread_local FILE* tac_out = NULL;
 
 /* Temporary and label counters */
-static int temp_count = 0;
-static int label_count = 0;
+static _Thread_local int temp_count = 0;
+static _Thread_local int label_count = 0;
 
 /* Forward declarations */
-static void gen_node(ASTNode* node);
-static char* gen_expression(ASTNode* expr);
-static void gen_if(ASTNode* node);
-static void gen_while(ASTNode* node);
-static void gen_write(ASTNode* node);
-static void gen_return(ASTNode* node);
-static void gen_function_def(ASTNode* node);
-static void gen_main_function(ASTNode* node);
-static void gen_block(ASTNode* node);
-static void gen_assignment(ASTNode* node);
-static void gen_declaration(ASTNode* node);
-static char* gen_function_call_expr(ASTNode* node);
+static void gen_walk(ASTNode* node);
 static void gen_char_assignment(const char* var, char ch);
 static char* gen_increment_expr(const char* var, int amount);
 
+/*
+ * What a visit of the generating walk emits. Statements emit their code
+ * around that of their children. An expression leaves the temporary
+ * holding its value on the value stack, which is then used according to
+ * why the expression was visited.
+ */
+enum {
+    GEN_STATEMENT,        /* A statement, function or the program */
+    GEN_VALUE,            /* An operand: its temporary is left for the parent */
+    GEN_DISCARD,          /* A call made for its effect */
+    GEN_IF_CONDITION,
+    GEN_WHILE_CONDITION,
+    GEN_ARGUMENT,         /* Argument number 'level' of a call */
+    GEN_ELEMENT,          /* Element number 'level' of an array initializer */
+};
+
 char* new_temp() {
     char* buf = (char*)malloc(16);
     sprintf(buf, "t%d", temp_count++);
@@ -49,308 +55,462 @@ static char* gen_increment_expr(const char* var, int amount) {
     return t2;
 }
 
-void generate_tac(ASTNode* root) {
+void generate_tac_begin(void) {
     /* Open the TAC file for writing */
     tac_out = fopen("tac_output.txt", "w");
     if (!tac_out) {
         fprintf(stderr, "Failed to open tac_output.txt for writing.\n");
         exit(1);
     }
+}
 
-    if (!root) {
-        fclose(tac_out);
-        return;
+void generate_tac_function(ASTNode* function) {
+    gen_walk(function);
+}
+
+void generate_tac_end(void) {
+    fclose(tac_out);
+    tac_out = NULL;
+}
+
+void generate_tac(ASTNode* root) {
+    generate_tac_begin();
+    if (root) gen_walk(root);
+    generate_tac_end();
+}
+
+static void push_temp(ASTVisitor* visitor, char* temp) {
+    ast_push_value(visitor, (intptr_t)temp);
+}
+
+static char* pop_temp(ASTVisitor* visitor) {
+    return (char*)ast_pop_value(visitor);
+}
+
+/*
+ * Temporaries of shared expressions (see expr_dag.h), by node: the first
+ * use computes the value, later ones copy the temporary. Open addressing
+ * on the node index.
+ */
+typedef struct TempMemo {
+    ASTIndex* nodes;
+    char** temps;
+    size_t capacity;         /* A power of two */
+    size_t count;
+} TempMemo;
+
+static size_t memo_slot(const TempMemo* memo, ASTIndex node) {
+    size_t i = (node * 0x9E3779B1u) & (memo->capacity - 1);
+    while (memo->nodes[i] && memo->nodes[i] != node) i = (i + 1) & (memo->capacity - 1);
+    return i;
+}
+
+static const char* memo_find(const TempMemo* memo, const ASTNode* expr) {
+    if (!memo->capacity) return NULL;
+    size_t i = memo_slot(memo, ast_index(expr));
+    return memo->nodes[i] ? memo->temps[i] : NULL;
+}
+
+static void memo_add(TempMemo* memo, const ASTNode* expr, const char* temp) {
+    if (2 * (memo->count + 1) > memo->capacity) {
+        TempMemo grown = { NULL, NULL, memo->capacity ? memo->capacity * 2 : 256, memo->count };
+        grown.nodes = (ASTIndex*)calloc(grown.capacity, sizeof(ASTIndex));
+        grown.temps = (char**)malloc(grown.capacity * sizeof(char*));
+        if (!grown.nodes || !grown.temps) {
+            fprintf(stderr, "Failed to allocate memory for shared temporaries.\n");
+            exit(1);
+        }
+        for (size_t i = 0; i < memo->capacity; i++) {
+            if (!memo->nodes[i]) continue;
+            size_t j = memo_slot(&grown, memo->nodes[i]);
+            grown.nodes[j] = memo->nodes[i];
+            grown.temps[j] = memo->temps[i];
+        }
+        free(memo->nodes);
+        free(memo->temps);
+        *memo = grown;
     }
+    size_t i = memo_slot(memo, ast_index(expr));
+    memo->nodes[i] = ast_index(expr);
+    memo->temps[i] = strdup(temp);
+    memo->count++;
+}
 
-    gen_node(root);
+static void memo_free(TempMemo* memo) {
+    for (size_t i = 0; i < memo->capacity; i++) {
+        if (memo->nodes[i]) free(memo->temps[i]);
+    }
+    free(memo->nodes);
+    free(memo->temps);
+}
 
-    fclose(tac_out);
+/* A temporary holding 0, for missing expressions */
+static char* gen_zero(void) {
+    char* t = new_temp();
+    fprintf(tac_out, "%s = 0\n", t);
+    return t;
 }
 
-static void gen_node(ASTNode* node) {
-    if (!node) return;
-    
+/* Whether 'expr' is ID + NUMBER, which gen_increment_expr() emits */
+static int is_increment(const ASTNode* expr) {
+    return ast_is_expr(expr, EXPR_BINARY) && ast_binop(expr) == BINOP_ADD &&
+           ast_is_expr(ast_left(expr), EXPR_ID) && ast_is_expr(ast_right(expr), EXPR_NUMBER);
+}
+
+/* The element an assignment stores to, or NULL if it stores to a variable */
+static ASTNode* assigned_element(const ASTNode* node) {
+    ASTNode* arrayNode = ast_left(node) ? ast_next(ast_left(node)) : NULL;
+    return arrayNode && arrayNode->type == AST_ARRAY_ACCESS ? arrayNode : NULL;
+}
+
+/* Whether an assignment is 'x = x + NUMBER' */
+static int is_self_increment(const ASTNode* node) {
+    ASTNode* valNode = ast_left(node);
+    return is_increment(valNode) && ast_name(ast_left(valNode)) == ast_name(node);
+}
+
+/* Whether a declaration's initializer is emitted as a character
+   constant: that of a char whose initializer's operator is one character */
+static int is_char_initializer(const ASTNode* node) {
+    const char* op = ast_operator(ast_left(node));
+    return node->data_type == DT_CHAR && op && strlen(op) == 1 && op[0] != 'N';
+}
+
+static void gen_statement_pre(ASTVisitor* visitor, ASTNode* node) {
     switch (node->type) {
         case AST_PROGRAM:
-            for (ASTNode* c = node->left; c; c = c->next) {
-                gen_node(c);
-            }
+        case AST_BLOCK:
+            ast_visit_list(visitor, ast_left(node), GEN_STATEMENT, 0);
             break;
         case AST_FUNCTION_DEFINITION:
-            gen_function_def(node);
+            fprintf(tac_out, "FUNC_BEGIN %s\n", ast_name(node));
+
+            /* Parameters are the leading declaration children; they have no
+               initializer, so they emit nothing */
+            ast_visit_list(visitor, ast_left(node), GEN_STATEMENT, 0);
             break;
         case AST_MAIN_FUNCTION:
-            gen_main_function(node);
+            fprintf(tac_out, "FUNC_BEGIN main\n");
+            if (ast_left(node)) ast_visit_child(visitor, ast_left(node), GEN_STATEMENT, 0);
             break;
         case AST_IF:
-            gen_if(node);
-            break;
-        case AST_WHILE:
-            gen_while(node);
+        case AST_WHILE: {
+            if (node->type == AST_WHILE) {
+                char* start_label = new_label();
+                char* end_label = new_label();
+                fprintf(tac_out, "%s:\n", start_label);
+                push_temp(visitor, start_label);
+                push_temp(visitor, end_label);
+                ast_visit_child(visitor, ast_condition(node), GEN_WHILE_CONDITION, 0);
+            } else {
+                ast_visit_child(visitor, ast_condition(node), GEN_IF_CONDITION, 0);
+            }
+
+            ASTNode* body = ast_body(node);
+            if (body) {
+                ast_visit_child(visitor, body, GEN_STATEMENT, 0);
+                if (ast_next(body) && ast_next(body)->type == AST_ASSIGNMENT) {
+                    ast_visit_child(visitor, ast_next(body), GEN_STATEMENT, 0);
+                }
+            }
             break;
+        }
         case AST_WRITE:
-            gen_write(node);
+            if (!ast_left(node)) {
+                char* val_reg;
+                if (ast_name(node)) {
+                    val_reg = new_temp();
+                    fprintf(tac_out, "%s = %s\n", val_reg, ast_name(node));
+                } else {
+                    val_reg = gen_zero();
+                }
+                fprintf(tac_out, "WRITE %s\n", val_reg);
+                free(val_reg);
+            } else if (ast_left(node)->type == AST_ARRAY_ACCESS) {
+                ast_visit_child(visitor, ast_left(ast_left(node)), GEN_VALUE, 0);
+            } else {
+                ast_visit_child(visitor, ast_left(node), GEN_VALUE, 0);
+            }
             break;
         case AST_RETURN:
-            gen_return(node);
-            break;
-        case AST_BLOCK:
-            gen_block(node);
+            if (ast_left(node)) {
+                ast_visit_child(visitor, ast_left(node), GEN_VALUE, 0);
+            } else {
+                fprintf(tac_out, "RETURN\n");
+            }
             break;
-        case AST_ASSIGNMENT:
-            gen_assignment(node);
+        case AST_ASSIGNMENT: {
+            ASTNode* arrayNode = assigned_element(node);
+            if (arrayNode) {
+                ast_visit_child(visitor, ast_left(node), GEN_VALUE, 0);
+                ast_visit_child(visitor, ast_left(arrayNode), GEN_VALUE, 0);
+            } else if (is_self_increment(node)) {
+                char* result = gen_increment_expr(ast_name(node), ast_value(ast_right(ast_left(node))));
+                free(result);
+            } else {
+                ast_visit_child(visitor, ast_left(node), GEN_VALUE, 0);
+            }
             break;
+        }
         case AST_DECLARATION:
-            gen_declaration(node);
+            if (node->category == SYMBOL_VARIABLE && ast_left(node)) {
+                if (is_char_initializer(node)) {
+                    gen_char_assignment(ast_name(node), ast_operator(ast_left(node))[0]);
+                } else {
+                    ast_visit_child(visitor, ast_left(node), GEN_VALUE, 0);
+                }
+            } else if (node->category == SYMBOL_ARRAY && ast_left(node) && ast_left(node)->type == AST_ARRAY_INIT) {
+                int idx = 0;
+                for (ASTNode* init_expr = ast_left(ast_left(node)); init_expr; init_expr = ast_next(init_expr), idx++) {
+                    ast_visit_child(visitor, init_expr, GEN_ELEMENT, idx);
+                }
+            }
             break;
         case AST_FUNCTION_CALL:
-            (void)gen_expression(node);
+            ast_visit_child(visitor, node, GEN_DISCARD, 0);
             break;
         default:
-            if (node->left) gen_node(node->left);
-            if (node->right) gen_node(node->right);
-            for (ASTNode* c = node->left; c; c = c->next) {
-                gen_node(c);
-            }
+            if (ast_left(node)) ast_visit_child(visitor, ast_left(node), GEN_STATEMENT, 0);
+            if (ast_right(node)) ast_visit_child(visitor, ast_right(node), GEN_STATEMENT, 0);
+            ast_visit_list(visitor, ast_left(node), GEN_STATEMENT, 0);
             break;
     }
 }
 
-static void gen_block(ASTNode* node) {
-    for (ASTNode* c = node->left; c; c = c->next) {
-        gen_node(c);
+static void gen_statement_post(ASTVisitor* visitor, ASTNode* node) {
+    switch (node->type) {
+        case AST_FUNCTION_DEFINITION:
+            fprintf(tac_out, "FUNC_END %s\n", ast_name(node));
+            break;
+        case AST_MAIN_FUNCTION:
+            fprintf(tac_out, "FUNC_END main\n");
+            break;
+        case AST_IF: {
+            char* else_label = pop_temp(visitor);
+            fprintf(tac_out, "%s:\n", else_label);
+            free(else_label);
+            break;
+        }
+        case AST_WHILE: {
+            char* end_label = pop_temp(visitor);
+            char* start_label = pop_temp(visitor);
+            fprintf(tac_out, "GOTO %s\n", start_label);
+            fprintf(tac_out, "%s:\n", end_label);
+            free(start_label);
+            free(end_label);
+            break;
+        }
+        case AST_WRITE: {
+            if (!ast_left(node)) break;
+            char* val_reg;
+            if (ast_left(node)->type == AST_ARRAY_ACCESS) {
+                char* idx = pop_temp(visitor);
+                val_reg = new_temp();
+                fprintf(tac_out, "%s = %s[%s]\n", val_reg, ast_name(ast_left(node)), idx);
+                free(idx);
+            } else {
+                val_reg = pop_temp(visitor);
+            }
+            fprintf(tac_out, "WRITE %s\n", val_reg);
+            free(val_reg);
+            break;
+        }
+        case AST_RETURN:
+            if (ast_left(node)) {
+                char* ret_reg = pop_temp(visitor);
+                fprintf(tac_out, "RETURN %s\n", ret_reg);
+                free(ret_reg);
+            }
+            break;
+        case AST_ASSIGNMENT:
+            if (assigned_element(node)) {
+                char* idx_reg = pop_temp(visitor);
+                char* val_reg = pop_temp(visitor);
+                fprintf(tac_out, "%s[%s] = %s\n", ast_name(node), idx_reg, val_reg);
+                free(val_reg);
+                free(idx_reg);
+            } else if (!is_self_increment(node)) {
+                char* val_reg = pop_temp(visitor);
+                fprintf(tac_out, "%s = %s\n", ast_name(node), val_reg);
+                free(val_reg);
+            }
+            break;
+        case AST_DECLARATION:
+            if (node->category == SYMBOL_VARIABLE && ast_left(node) && !is_char_initializer(node)) {
+                char* val_reg = pop_temp(visitor);
+                fprintf(tac_out, "%s = %s\n", ast_name(node), val_reg);
+                free(val_reg);
+            }
+            break;
+        default:
+            break;
     }
 }
 
-static void gen_if(ASTNode* node) {
-    char* cond_reg = gen_expression(node->condition);
-    char* else_label = new_label();
-    fprintf(tac_out, "IFZ %s GOTO %s\n", cond_reg, else_label);
-    free(cond_reg);
-
-    if (node->body) {
-        gen_node(node->body);
-        if (node->body->next && node->body->next->type == AST_ASSIGNMENT) {
-            gen_node(node->body->next);
+/* Reaching an expression: leaves push their temporary here, operators
+   schedule their operands */
+static void gen_expression_pre(ASTVisitor* visitor, ASTNode* expr) {
+    if (!expr) {
+        push_temp(visitor, gen_zero());
+        return;
+    }
+    /* A shared expression computed already */
+    if (expr->shared) {
+        const char* t = memo_find(visitor->data, expr);
+        if (t) {
+            push_temp(visitor, strdup(t));
+            return;
         }
     }
 
-    fprintf(tac_out, "%s:\n", else_label);
-    free(else_label);
-}
-
-static void gen_while(ASTNode* node) {
-    char* start_label = new_label();
-    char* end_label = new_label();
-    
-    fprintf(tac_out, "%s:\n", start_label);
-    char* cond_reg = gen_expression(node->condition);
-    fprintf(tac_out, "IFZ %s GOTO %s\n", cond_reg, end_label);
-    free(cond_reg);
-
-    if (node->body) {
-        gen_node(node->body);
-        if (node->body->next && node->body->next->type == AST_ASSIGNMENT) {
-            gen_node(node->body->next);
+    switch (expr->type) {
+        case AST_EXPRESSION:
+            switch (ast_expr_kind(expr)) {
+                case EXPR_NUMBER: {
+                    char* t = new_temp();
+                    fprintf(tac_out, "%s = %d\n", t, ast_value(expr));
+                    push_temp(visitor, t);
+                    return;
+                }
+                case EXPR_FLOAT: {
+                    char* t = new_temp();
+                    fprintf(tac_out, "%s = %.2f\n", t, ast_float_value(expr));
+                    push_temp(visitor, t);
+                    return;
+                }
+                case EXPR_ID: {
+                    char* t = new_temp();
+                    fprintf(tac_out, "%s = %s\n", t, ast_name(expr));
+                    push_temp(visitor, t);
+                    return;
+                }
+                case EXPR_NOT:
+                    ast_visit_child(visitor, ast_left(expr), GEN_VALUE, 0);
+                    return;
+                case EXPR_BINARY:
+                    if (is_increment(expr)) {
+                        push_temp(visitor, gen_increment_expr(ast_name(ast_left(expr)), ast_value(ast_right(expr))));
+                        return;
+                    }
+                    ast_visit_child(visitor, ast_left(expr), GEN_VALUE, 0);
+                    ast_visit_child(visitor, ast_right(expr), GEN_VALUE, 0);
+                    return;
+            }
+            break;
+        case AST_ARRAY_ACCESS:
+            ast_visit_child(visitor, ast_left(expr), GEN_VALUE, 0);
+            return;
+        case AST_FUNCTION_CALL: {
+            // Generate param assignments with numbering
+            int paramIndex = 0;
+            for (ASTNode* arg = ast_arguments(expr); arg; arg = ast_next(arg), paramIndex++) {
+                ast_visit_child(visitor, arg, GEN_ARGUMENT, paramIndex);
+            }
+            return;
         }
+        default:
+            break;
     }
-    
-    fprintf(tac_out, "GOTO %s\n", start_label);
-    fprintf(tac_out, "%s:\n", end_label);
-    free(start_label);
-    free(end_label);
+    push_temp(visitor, gen_zero());
 }
 
-static void gen_write(ASTNode* node) {
-    char* val_reg = NULL;
-    if (node->name && !node->left) {
-        val_reg = new_temp();
-        fprintf(tac_out, "%s = %s\n", val_reg, node->name);
-    } else if (node->left && node->left->type == AST_ARRAY_ACCESS) {
-        ASTNode* arrNode = node->left;
-        char* idx = gen_expression(arrNode->left);
-        val_reg = new_temp();
-        fprintf(tac_out, "%s = %s[%s]\n", val_reg, arrNode->string, idx);
+/* Leaving an expression: emit operators, whose operands' temporaries
+   are on the value stack */
+static void gen_expression_post(ASTVisitor* visitor, const ASTNode* expr) {
+    if (!expr) return;
+    if (expr->shared && memo_find(visitor->data, expr)) return;  /* Reused in 'pre' */
+
+    if (ast_is_expr(expr, EXPR_NOT)) {
+        char* operand = pop_temp(visitor);
+        char* t = new_temp();
+        fprintf(tac_out, "%s = 1 - %s\n", t, operand);
+        free(operand);
+        push_temp(visitor, t);
+    } else if (ast_is_expr(expr, EXPR_BINARY) && !is_increment(expr)) {
+        char* right_t = pop_temp(visitor);
+        char* left_t = pop_temp(visitor);
+        char* t = new_temp();
+        fprintf(tac_out, "%s = %s %s %s\n", t, left_t, binop_text(ast_binop(expr)), right_t);
+        free(left_t);
+        free(right_t);
+        push_temp(visitor, t);
+    } else if (expr->type == AST_ARRAY_ACCESS) {
+        char* idx = pop_temp(visitor);
+        char* t = new_temp();
+        fprintf(tac_out, "%s = %s[%s]\n", t, ast_name(expr), idx);
         free(idx);
-    } else if (node->left) {
-        val_reg = gen_expression(node->left);
-    } else {
-        val_reg = new_temp();
-        fprintf(tac_out, "%s = 0\n", val_reg);
+        push_temp(visitor, t);
+    } else if (expr->type == AST_FUNCTION_CALL) {
+        char* call_reg = new_temp();
+        fprintf(tac_out, "%s = CALL %s\n", call_reg, ast_name(expr));
+        push_temp(visitor, call_reg);
     }
-    fprintf(tac_out, "WRITE %s\n", val_reg);
-    free(val_reg);
+    if (expr->shared) memo_add(visitor->data, expr, (const char*)ast_peek_value(visitor, 0));
 }
 
-static void gen_return(ASTNode* node) {
-    if (node->left) {
-        char* ret_reg = gen_expression(node->left);
-        fprintf(tac_out, "RETURN %s\n", ret_reg);
-        free(ret_reg);
+static void gen_pre(ASTVisitor* visitor, const ASTVisit* visit) {
+    if (visit->tag == GEN_STATEMENT) {
+        if (visit->node) gen_statement_pre(visitor, visit->node);
     } else {
-        fprintf(tac_out, "RETURN\n");
+        gen_expression_pre(visitor, visit->node);
     }
 }
 
-static void gen_function_def(ASTNode* node) {
-    fprintf(tac_out, "FUNC_BEGIN %s\n", node->name);
-
-    // If function definition has parameters, assign them from param0, param1, etc.
-    // Assuming ASTNode* node->params holds a linked list of parameter nodes, each with a name.
-    // If your AST differs, adjust accordingly.
-    ASTNode* p = node->parameters; 
-    int paramIndex = 0;
-    while (p) {
-        // Assign parameter variable from paramN
-        fprintf(tac_out, "%s = param%d\n", p->name, paramIndex);
-        paramIndex++;
-        p = p->next;
-    }
-
-    for (ASTNode* c = node->left; c; c = c->next) {
-        gen_node(c);
-    }
-    fprintf(tac_out, "FUNC_END %s\n", node->name);
-}
-
-static void gen_main_function(ASTNode* node) {
-    fprintf(tac_out, "FUNC_BEGIN main\n");
-    if (node->left) gen_node(node->left);
-    fprintf(tac_out, "FUNC_END main\n");
-}
-
-static void gen_assignment(ASTNode* node) {
-    ASTNode* valNode = node->left;
-    ASTNode* arrayNode = valNode ? valNode->next : NULL;
-
-    if (arrayNode && arrayNode->type == AST_ARRAY_ACCESS) {
-        char* val_reg = gen_expression(valNode);
-        char* idx_reg = gen_expression(arrayNode->left);
-        fprintf(tac_out, "%s[%s] = %s\n", node->name, idx_reg, val_reg);
-        free(val_reg);
-        free(idx_reg);
-    } else if (valNode && valNode->type == AST_EXPRESSION && 
-               valNode->operator && strcmp(valNode->operator, "+") == 0 &&
-               valNode->left->type == AST_EXPRESSION && 
-               valNode->left->operator && strcmp(valNode->left->operator, "ID") == 0 &&
-               strcmp(valNode->left->string, node->name) == 0 &&
-               valNode->right->type == AST_EXPRESSION && 
-               valNode->right->operator && strcmp(valNode->right->operator, "NUMBER") == 0) {
-        char* result = gen_increment_expr(node->name, valNode->right->value);
-        free(result);
-    } else {
-        char* val_reg = gen_expression(valNode);
-        fprintf(tac_out, "%s = %s\n", node->name, val_reg);
-        free(val_reg);
+static void gen_post(ASTVisitor* visitor, const ASTVisit* visit) {
+    if (visit->tag == GEN_STATEMENT) {
+        if (visit->node) gen_statement_post(visitor, visit->node);
+        return;
     }
-}
+    gen_expression_post(visitor, visit->node);
 
-static void gen_declaration(ASTNode* node) {
-    if (node->category == SYMBOL_VARIABLE && node->left) {
-        if (node->data_type == DT_CHAR && node->left->operator && 
-            strlen(node->left->operator) == 1 && node->left->operator[0] != 'N') {
-            char ch = node->left->operator[0];
-            gen_char_assignment(node->name, ch);
-        } else {
-            char* val_reg = gen_expression(node->left);
-            fprintf(tac_out, "%s = %s\n", node->name, val_reg);
-            free(val_reg);
+    /* Use the expression's temporary */
+    switch (visit->tag) {
+        case GEN_VALUE:
+            break;
+        case GEN_DISCARD:
+            free(pop_temp(visitor));
+            break;
+        case GEN_IF_CONDITION: {
+            char* cond_reg = pop_temp(visitor);
+            char* else_label = new_label();
+            fprintf(tac_out, "IFZ %s GOTO %s\n", cond_reg, else_label);
+            free(cond_reg);
+            push_temp(visitor, else_label);
+            break;
         }
-    } else if (node->category == SYMBOL_ARRAY && node->left && node->left->type == AST_ARRAY_INIT) {
-        int idx = 0;
-        for (ASTNode* init_expr = node->left->left; init_expr; init_expr = init_expr->next, idx++) {
-            char* val_reg = gen_expression(init_expr);
-            fprintf(tac_out, "%s[%d] = %s\n", node->name, idx, val_reg);
-            free(val_reg);
+        case GEN_WHILE_CONDITION: {
+            char* cond_reg = pop_temp(visitor);
+            fprintf(tac_out, "IFZ %s GOTO %s\n", cond_reg, (char*)ast_peek_value(visitor, 0));
+            free(cond_reg);
+            break;
         }
-    }
-}
-
-static char* gen_function_call_expr(ASTNode* node) {
-    // Generate param assignments with numbering
-    int paramIndex = 0;
-    ASTNode* arg = node->arguments;
-    while (arg) {
-        char* arg_reg = gen_expression(arg);
-        // Assign the argument to a paramN temp before the PARAM line
-        char paramVar[16];
-        sprintf(paramVar, "param%d", paramIndex);
-        fprintf(tac_out, "%s = %s\n", paramVar, arg_reg);
-        fprintf(tac_out, "PARAM %s\n", paramVar);
-        free(arg_reg);
-        arg = arg->next;
-        paramIndex++;
-    }
-
-    char* call_reg = new_temp();
-    fprintf(tac_out, "%s = CALL %s\n", call_reg, node->string);
-    return call_reg;
-}
-
-static char* gen_expression(ASTNode* expr) {
-    if (!expr) {
-        char* t = new_temp();
-        fprintf(tac_out, "%s = 0\n", t);
-        return t;
-    }
-
-    switch (expr->type) {
-        case AST_EXPRESSION:
-            if (expr->operator) {
-                if (strcmp(expr->operator, "+") == 0 &&
-                    expr->left && expr->left->type == AST_EXPRESSION &&
-                    expr->left->operator && strcmp(expr->left->operator, "ID") == 0 &&
-                    expr->right && expr->right->type == AST_EXPRESSION &&
-                    expr->right->operator && strcmp(expr->right->operator, "NUMBER") == 0) {
-                    return gen_increment_expr(expr->left->string, expr->right->value);
-                }
-                if (strcmp(expr->operator, "NUMBER") == 0) {
-                    char* t = new_temp();
-                    fprintf(tac_out, "%s = %d\n", t, expr->value);
-                    return t;
-                } else if (strcmp(expr->operator, "FLOAT_NUMBER") == 0) {
-                    char* t = new_temp();
-                    fprintf(tac_out, "%s = %.2f\n", t, expr->float_value);
-                    return t;
-                } else if (strcmp(expr->operator, "ID") == 0) {
-                    char* t = new_temp();
-                    fprintf(tac_out, "%s = %s\n", t, expr->string);
-                    return t;
-                } else if (strcmp(expr->operator, "!") == 0) {
-                    char* operand = gen_expression(expr->left);
-                    char* t = new_temp();
-                    fprintf(tac_out, "%s = 1 - %s\n", t, operand);
-                    free(operand);
-                    return t;
-                } else {
-                    char* left_t = gen_expression(expr->left);
-                    char* right_t = gen_expression(expr->right);
-                    char* t = new_temp();
-                    fprintf(tac_out, "%s = %s %s %s\n", t, left_t, expr->operator, right_t);
-                    free(left_t);
-                    free(right_t);
-                    return t;
-                }
-            }
+        case GEN_ARGUMENT: {
+            char* arg_reg = pop_temp(visitor);
+            // Assign the argument to a paramN temp before the PARAM line
+            char paramVar[16];
+            sprintf(paramVar, "param%d", visit->level);
+            fprintf(tac_out, "%s = %s\n", paramVar, arg_reg);
+            fprintf(tac_out, "PARAM %s\n", paramVar);
+            free(arg_reg);
             break;
-        case AST_ARRAY_ACCESS: {
-            char* idx = gen_expression(expr->left);
-            char* t = new_temp();
-            fprintf(tac_out, "%s = %s[%s]\n", t, expr->string, idx);
-            free(idx);
-            return t;
         }
-        case AST_FUNCTION_CALL:
-            return gen_function_call_expr(expr);
-        default: {
-            char* t = new_temp();
-            fprintf(tac_out, "%s = 0\n", t);
-            return t;
+        case GEN_ELEMENT: {
+            char* val_reg = pop_temp(visitor);
+            fprintf(tac_out, "%s[%d] = %s\n", ast_name(visit->parent), visit->level, val_reg);
+            free(val_reg);
+            break;
         }
     }
-    char* t = new_temp();
-    fprintf(tac_out, "%s = 0\n", t);
-    return t;
+}
+
+/* Emit the code of the tree under 'node' */
+static void gen_walk(ASTNode* node) {
+    TempMemo memo = { NULL, NULL, 0, 0 };
+    ASTVisitor visitor;
+    ast_visitor_init(&visitor, gen_pre, gen_post, &memo);
+    ast_walk(&visitor, node, GEN_STATEMENT, 0);
+    ast_visitor_free(&visitor);
+    memo_free(&memo);
 }
 
 static void gen_char_assignment(const char* var, char ch) {
@@ -8,6 +8,12 @@
  */
 void generate_tac(ASTNode* root);
 
+/* generate_tac() one function at a time, for streaming compilation:
+   begin, then each function in source order, then end */
+void generate_tac_begin(void);
+void generate_tac_function(ASTNode* function);
+void generate_tac_end(void);
+
 /* A simple temporary register allocator */
 char* new_temp();
 
@@ -0,0 +1,111 @@
+/* diag.c */
+
+#include "diag.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Ring size must be a power of two; output is handed to stdio in blocks
+   of at least DIAG_FLUSH_BLOCK bytes, large enough that glibc writes
+   them straight through without copying into the FILE buffer. */
+#define DIAG_RING_SIZE   (1u << 17)
+#define DIAG_RING_MASK   (DIAG_RING_SIZE - 1)
+#define DIAG_FLUSH_BLOCK (DIAG_RING_SIZE / 2)
+
+DiagLevel diag_level = DIAG_SUMMARY;
+
+/* Each thread buffers its own output; threads other than the main one
+   must call diag_flush() before they finish */
+static _Thread_local char ring[DIAG_RING_SIZE];
+/* Free-running positions; head - tail is the number of pending bytes */
+static _Thread_local size_t ring_head = 0;
+static _Thread_local size_t ring_tail = 0;
+static int exit_hook_registered = 0;
+
+void diag_init(DiagLevel level) {
+    diag_level = level;
+    if (!exit_hook_registered) {
+        /* Semantic errors exit() directly; don't lose buffered trace output */
+        atexit(diag_flush);
+        exit_hook_registered = 1;
+    }
+}
+
+int diag_parse_level(const char* name) {
+    if (strcmp(name, "silent") == 0) return DIAG_SILENT;
+    if (strcmp(name, "summary") == 0) return DIAG_SUMMARY;
+    if (strcmp(name, "trace") == 0) return DIAG_TRACE;
+    return -1;
+}
+
+/* Write up to 'limit' pending bytes, in at most two contiguous segments */
+static void ring_drain(size_t limit) {
+    size_t pending = ring_head - ring_tail;
+    if (pending > limit) pending = limit;
+    while (pending > 0) {
+        size_t start = ring_tail & DIAG_RING_MASK;
+        size_t chunk = DIAG_RING_SIZE - start;
+        if (chunk > pending) chunk = pending;
+        fwrite(ring + start, 1, chunk, stdout);
+        ring_tail += chunk;
+        pending -= chunk;
+    }
+}
+
+void diag_write(const char* data, size_t length) {
+    while (length > 0) {
+        size_t space = DIAG_RING_SIZE - (ring_head - ring_tail);
+        if (space == 0) {
+            ring_drain(DIAG_FLUSH_BLOCK);
+            continue;
+        }
+        size_t start = ring_head & DIAG_RING_MASK;
+        size_t chunk = DIAG_RING_SIZE - start;
+        if (chunk > space) chunk = space;
+        if (chunk > length) chunk = length;
+        memcpy(ring + start, data, chunk);
+        ring_head += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+    if (ring_head - ring_tail >= DIAG_FLUSH_BLOCK) {
+        ring_drain(DIAG_FLUSH_BLOCK);
+    }
+}
+
+void diag_vprintf(const char* format, va_list args) {
+    char buf[512];
+    va_list copy;
+    va_copy(copy, args);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    if (n < 0) {
+        va_end(copy);
+        return;
+    }
+    if ((size_t)n < sizeof(buf)) {
+        diag_write(buf, (size_t)n);
+    } else {
+        /* Rare: message longer than the scratch buffer */
+        char* big = (char*)malloc((size_t)n + 1);
+        if (!big) {
+            fprintf(stderr, "Failed to allocate diagnostic buffer.\n");
+            exit(EXIT_FAILURE);
+        }
+        vsnprintf(big, (size_t)n + 1, format, copy);
+        diag_write(big, (size_t)n);
+        free(big);
+    }
+    va_end(copy);
+}
+
+void diag_printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    diag_vprintf(format, args);
+    va_end(args);
+}
+
+void diag_flush(void) {
+    ring_drain(ring_head - ring_tail);
+    fflush(stdout);
+}
@@ -0,0 +1,54 @@
+/* diag.h */
+
+#ifndef DIAG_H
+#define DIAG_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/*
+ * Diagnostic verbosity levels.
+ *   DIAG_SILENT  - nothing but errors (which always go to stderr)
+ *   DIAG_SUMMARY - one line per compiler phase (the default)
+ *   DIAG_TRACE   - per-token, per-symbol and per-scope chatter, AST and
+ *                  symbol table dumps
+ */
+typedef enum {
+    DIAG_SILENT = 0,
+    DIAG_SUMMARY = 1,
+    DIAG_TRACE = 2
+} DiagLevel;
+
+/* Current verbosity; read on hot paths, so keep it a plain global */
+extern DiagLevel diag_level;
+
+/* True when messages of the given level should be produced.
+   The branch is marked unlikely so the default level pays one
+   well-predicted compare and nothing else. */
+#define diag_enabled(level) __builtin_expect(diag_level >= (level), 0)
+
+/* Emit a trace / summary message; arguments are not evaluated when the
+   level is disabled */
+#define diag_trace(...) \
+    do { if (diag_enabled(DIAG_TRACE)) diag_printf(__VA_ARGS__); } while (0)
+#define diag_summary(...) \
+    do { if (diag_level >= DIAG_SUMMARY) diag_printf(__VA_ARGS__); } while (0)
+
+/* Set the verbosity level and register the exit-time flush */
+void diag_init(DiagLevel level);
+
+/* Parse a level name ("silent", "summary", "trace"); returns -1 if unknown */
+int diag_parse_level(const char* name);
+
+/* Format a message into the trace ring buffer */
+void diag_printf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+void diag_vprintf(const char* format, va_list args);
+
+/* Append raw bytes to the trace ring buffer */
+void diag_write(const char* data, size_t length);
+
+/* Write everything still buffered to stdout. Must be called before
+   anything else prints to stdout directly, to keep output ordered. */
+void diag_flush(void);
+
+#endif /* DIAG_H */
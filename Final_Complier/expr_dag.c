@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "expr_dag.h"
+#include "ast_visit.h"
+
+/*
+ * Local value numbering by hash-consing. The tree is walked in the
+ * order the code generator evaluates it, and each side-effect-free
+ * expression is looked up, after its operands, under a key made of its
+ * operator and the nodes its operands were resolved to. The first node
+ * with a key stands for all later ones.
+ *
+ * Nothing is ever removed from the table. Instead the key of a variable
+ * read carries the time since which its value is known: the later of
+ * the start of the region and the variable's last assignment, on a
+ * clock that ticks at each of them. After an assignment a read of the
+ * variable gets a new key, so does every expression over it, and the
+ * old entries are simply never matched again; likewise for everything
+ * at the start of a region.
+ */
+
+/* Why a node is visited */
+enum {
+    DAG_STATEMENT,
+    DAG_REGION,          /* NULL: a new region starts here */
+    DAG_LEFT,            /* Operand in the parent's 'left' */
+    DAG_RIGHT,           /* Operand in the parent's 'right' */
+    DAG_ARGUMENT,        /* Argument of a call */
+    DAG_ROOT,            /* Whole value in the statement's 'left' */
+    DAG_CONDITION,       /* Whole condition of an if or while */
+    DAG_ELEMENT,         /* Whole value that is in a list */
+    DAG_TARGET,          /* Element an assignment or write uses */
+};
+
+typedef struct DagKey {
+    uint8_t type;            /* AST_EXPRESSION or AST_ARRAY_ACCESS */
+    uint8_t kind;
+    uint8_t op;
+    uint32_t payload;        /* Literal bits or name */
+    ASTIndex left;
+    ASTIndex right;
+    uint32_t since;          /* Leaves and array reads: clock their value is valid from */
+} DagKey;
+
+typedef struct DagEntry {
+    DagKey key;
+    ASTIndex node;           /* 0 for a free slot */
+} DagEntry;
+
+typedef struct ExprDag {
+    DagEntry* entries;
+    size_t capacity;         /* A power of two */
+    size_t count;
+    uint32_t* assigned;      /* By atom id: clock of the last assignment */
+    unsigned atoms;
+    uint32_t clock;
+    uint32_t region;         /* Clock at the start of the current region */
+    int shared;
+} ExprDag;
+
+static void* dag_calloc(size_t count, size_t size) {
+    void* memory = calloc(count, size);
+    if (!memory) {
+        fprintf(stderr, "Failed to allocate memory for the expression DAG.\n");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+static uint32_t key_hash(const DagKey* key) {
+    uint64_t h = ((uint64_t)key->type << 16 | (uint64_t)key->kind << 8 | key->op) * 0x9E3779B97F4A7C15ull;
+    h = (h ^ key->payload) * 0x9E3779B97F4A7C15ull;
+    h = (h ^ key->left) * 0x9E3779B97F4A7C15ull;
+    h = (h ^ key->right) * 0x9E3779B97F4A7C15ull;
+    h = (h ^ key->since) * 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(h >> 32);
+}
+
+static int key_equal(const DagKey* a, const DagKey* b) {
+    return a->type == b->type && a->kind == b->kind && a->op == b->op && a->payload == b->payload &&
+           a->left == b->left && a->right == b->right && a->since == b->since;
+}
+
+static DagEntry* find_slot(DagEntry* entries, size_t capacity, const DagKey* key) {
+    size_t i = key_hash(key) & (capacity - 1);
+    while (entries[i].node && !key_equal(&entries[i].key, key)) i = (i + 1) & (capacity - 1);
+    return &entries[i];
+}
+
+static void insert(ExprDag* dag, const DagKey* key, ASTIndex node) {
+    if (2 * (dag->count + 1) > dag->capacity) {
+        size_t capacity = dag->capacity ? dag->capacity * 2 : 1024;
+        DagEntry* entries = dag_calloc(capacity, sizeof(DagEntry));
+        for (size_t i = 0; i < dag->capacity; i++) {
+            if (dag->entries[i].node) *find_slot(entries, capacity, &dag->entries[i].key) = dag->entries[i];
+        }
+        free(dag->entries);
+        dag->entries = entries;
+        dag->capacity = capacity;
+    }
+    DagEntry* slot = find_slot(dag->entries, dag->capacity, key);
+    slot->key = *key;
+    slot->node = node;
+    dag->count++;
+}
+
+/* Clock since which the value of variable or array 'name' is known */
+static uint32_t valid_since(const ExprDag* dag, uint32_t name) {
+    uint32_t assigned = name && name - 1 < dag->atoms ? dag->assigned[name - 1] : 0;
+    return assigned > dag->region ? assigned : dag->region;
+}
+
+static void assign(ExprDag* dag, const char* name) {
+    if (name && atom_id(name) < dag->atoms) dag->assigned[atom_id(name)] = ++dag->clock;
+}
+
+/* Whether 'expr' is ID + NUMBER, which the code generator emits as an
+   increment of the ID */
+static int is_increment(const ASTNode* expr) {
+    return ast_is_expr(expr, EXPR_BINARY) && ast_binop(expr) == BINOP_ADD &&
+           ast_is_expr(ast_left(expr), EXPR_ID) && ast_is_expr(ast_right(expr), EXPR_NUMBER);
+}
+
+/* The element an assignment stores to, or NULL if it stores to a variable */
+static ASTNode* assigned_element(const ASTNode* node) {
+    ASTNode* element = ast_left(node) ? ast_next(ast_left(node)) : NULL;
+    return element && element->type == AST_ARRAY_ACCESS ? element : NULL;
+}
+
+static void statement_pre(ASTVisitor* visitor, ASTNode* node) {
+    switch (node->type) {
+        case AST_PROGRAM:
+        case AST_BLOCK:
+        case AST_FUNCTION_DEFINITION:
+            if (node->type == AST_FUNCTION_DEFINITION) ast_visit_child(visitor, NULL, DAG_REGION, 0);
+            ast_visit_list(visitor, ast_left(node), DAG_STATEMENT, 0);
+            break;
+        case AST_MAIN_FUNCTION:
+            ast_visit_child(visitor, NULL, DAG_REGION, 0);
+            if (ast_left(node)) ast_visit_child(visitor, ast_left(node), DAG_STATEMENT, 0);
+            break;
+        case AST_IF:
+        case AST_WHILE:
+            if (node->type == AST_WHILE) ast_visit_child(visitor, NULL, DAG_REGION, 0);
+            if (ast_condition(node)) ast_visit_child(visitor, ast_condition(node), DAG_CONDITION, 0);
+            ast_visit_child(visitor, NULL, DAG_REGION, 0);
+            ast_visit_list(visitor, ast_body(node), DAG_STATEMENT, 0);
+            if (node->type == AST_IF && ast_left(node)) {
+                ast_visit_child(visitor, NULL, DAG_REGION, 0);
+                ast_visit_child(visitor, ast_left(node), DAG_STATEMENT, 0);
+            }
+            break;
+        case AST_WRITE:
+            if (ast_left(node)) {
+                int tag = ast_left(node)->type == AST_ARRAY_ACCESS ? DAG_TARGET : DAG_ROOT;
+                ast_visit_child(visitor, ast_left(node), tag, 0);
+            }
+            break;
+        case AST_RETURN:
+            if (ast_left(node)) ast_visit_child(visitor, ast_left(node), DAG_ROOT, 0);
+            break;
+        case AST_ASSIGNMENT: {
+            ASTNode* element = assigned_element(node);
+            if (element) {
+                ast_visit_child(visitor, ast_left(node), DAG_ELEMENT, 0);
+                ast_visit_child(visitor, element, DAG_TARGET, 0);
+            } else if (ast_left(node)) {
+                ast_visit_child(visitor, ast_left(node), DAG_ROOT, 0);
+            }
+            break;
+        }
+        case AST_DECLARATION:
+            if (node->category == SYMBOL_VARIABLE && ast_left(node)) {
+                ast_visit_child(visitor, ast_left(node), DAG_ROOT, 0);
+            } else if (node->category == SYMBOL_ARRAY && ast_left(node) && ast_left(node)->type == AST_ARRAY_INIT) {
+                ast_visit_list(visitor, ast_left(ast_left(node)), DAG_ELEMENT, 0);
+            }
+            break;
+        case AST_FUNCTION_CALL:
+        case AST_EXPRESSION:
+            ast_visit_child(visitor, node, DAG_ELEMENT, 0);
+            break;
+        default:
+            break;
+    }
+}
+
+static void statement_post(ExprDag* dag, ASTNode* node) {
+    switch (node->type) {
+        case AST_IF:
+        case AST_WHILE:
+            dag->region = ++dag->clock;
+            break;
+        case AST_ASSIGNMENT:
+        case AST_DECLARATION:
+            assign(dag, ast_name(node));
+            break;
+        default:
+            break;
+    }
+}
+
+static void expression_pre(ASTVisitor* visitor, ASTNode* expr) {
+    switch (expr->type) {
+        case AST_EXPRESSION:
+            if (is_increment(expr)) break;
+            if (ast_left(expr)) ast_visit_child(visitor, ast_left(expr), DAG_LEFT, 0);
+            if (ast_right(expr)) ast_visit_child(visitor, ast_right(expr), DAG_RIGHT, 0);
+            break;
+        case AST_ARRAY_ACCESS:
+            if (ast_left(expr)) ast_visit_child(visitor, ast_left(expr), DAG_LEFT, 0);
+            break;
+        case AST_FUNCTION_CALL:
+            ast_visit_list(visitor, ast_arguments(expr), DAG_ARGUMENT, 0);
+            break;
+        default:
+            break;
+    }
+}
+
+/* Replace 'expr' by the node an identical expression was resolved to,
+   or make it that node */
+static void resolve(ExprDag* dag, ASTNode* expr, const ASTVisit* visit) {
+    DagKey key;
+    memset(&key, 0, sizeof key);
+    key.type = expr->type;
+    key.left = expr->left;
+    if (expr->type == AST_ARRAY_ACCESS) {
+        key.payload = expr->u.named.name;
+        key.since = valid_since(dag, key.payload);
+    } else {
+        key.kind = expr->u.expr.kind;
+        key.op = expr->u.expr.op;
+        key.right = expr->right;
+        switch (ast_expr_kind(expr)) {
+            case EXPR_NUMBER:
+            case EXPR_FLOAT:
+                key.payload = (uint32_t)expr->u.expr.value;
+                key.since = dag->region;
+                break;
+            case EXPR_ID:
+                key.payload = expr->u.expr.name;
+                key.since = valid_since(dag, key.payload);
+                break;
+            default:
+                break;
+        }
+    }
+
+    DagEntry* slot = dag->capacity ? find_slot(dag->entries, dag->capacity, &key) : NULL;
+    if (!slot || !slot->node) {
+        /* A node in a list cannot be linked to from elsewhere: its
+           sibling would come along */
+        if (!expr->next) insert(dag, &key, ast_index(expr));
+        return;
+    }
+
+    ASTIndex earlier = slot->node;
+    ASTNode* parent = visit->parent;
+    switch (visit->tag) {
+        case DAG_LEFT:
+        case DAG_ROOT:
+            parent->left = earlier;
+            break;
+        case DAG_RIGHT:
+            parent->right = earlier;
+            break;
+        case DAG_CONDITION:
+            parent->u.condition = earlier;
+            break;
+        default:
+            return;
+    }
+    ast_node(earlier)->shared = 1;
+    dag->shared++;
+}
+
+/* Leaving an expression: operands that are pure have pushed 1 */
+static void expression_post(ASTVisitor* visitor, ExprDag* dag, const ASTVisit* visit) {
+    ASTNode* expr = visit->node;
+    int pure = 0;
+    switch (expr->type) {
+        case AST_EXPRESSION:
+            if (is_increment(expr)) {
+                assign(dag, ast_name(ast_left(expr)));
+                break;
+            }
+            pure = 1;
+            if (ast_right(expr)) pure &= (int)ast_pop_value(visitor);
+            if (ast_left(expr)) pure &= (int)ast_pop_value(visitor);
+            break;
+        case AST_ARRAY_ACCESS:
+            pure = ast_left(expr) ? (int)ast_pop_value(visitor) : 1;
+            break;
+        case AST_FUNCTION_CALL:
+            for (ASTNode* arg = ast_arguments(expr); arg; arg = ast_next(arg)) ast_pop_value(visitor);
+            break;
+        default:
+            break;
+    }
+
+    if (visit->tag == DAG_TARGET) return;
+    if (pure) resolve(dag, expr, visit);
+    if (visit->tag == DAG_LEFT || visit->tag == DAG_RIGHT || visit->tag == DAG_ARGUMENT) {
+        ast_push_value(visitor, pure);
+    }
+}
+
+static void dag_pre(ASTVisitor* visitor, const ASTVisit* visit) {
+    if (visit->tag == DAG_REGION) {
+        ExprDag* dag = visitor->data;
+        dag->region = ++dag->clock;
+    } else if (visit->tag == DAG_STATEMENT) {
+        statement_pre(visitor, visit->node);
+    } else {
+        expression_pre(visitor, visit->node);
+    }
+}
+
+static void dag_post(ASTVisitor* visitor, const ASTVisit* visit) {
+    if (visit->tag == DAG_REGION) return;
+    if (visit->tag == DAG_STATEMENT) {
+        statement_post(visitor->data, visit->node);
+    } else {
+        expression_post(visitor, visitor->data, visit);
+    }
+}
+
+int share_expressions(ASTNode* root) {
+    ExprDag dag;
+    memset(&dag, 0, sizeof dag);
+    dag.atoms = atom_count();
+    dag.assigned = dag_calloc(dag.atoms ? dag.atoms : 1, sizeof(uint32_t));
+
+    ASTVisitor visitor;
+    ast_visitor_init(&visitor, dag_pre, dag_post, &dag);
+    ast_walk(&visitor, root, DAG_STATEMENT, 0);
+    ast_visitor_free(&visitor);
+
+    free(dag.entries);
+    free(dag.assigned);
+    return dag.shared;
+}
@@ -0,0 +1,25 @@
+#ifndef EXPR_DAG_H
+#define EXPR_DAG_H
+
+#include "ast.h"
+
+/*
+ * Turn the expressions of a checked tree into a DAG, in place: within a
+ * straight-line region of code, an expression identical to one already
+ * evaluated (same operators, same literals, same variables unassigned
+ * since) is replaced by a link to that earlier node, whose 'shared' flag
+ * is set. Code generation then computes a shared node once and reuses
+ * its temporary.
+ *
+ * Only expressions that neither call a function nor contain an ID +
+ * NUMBER (which the code generator emits as an increment of the ID) are
+ * shared. A region ends at the start of a body, condition of a while,
+ * else branch and after an if or while. Nodes in a list (arguments,
+ * array initializers) keep their place but their operands are shared.
+ *
+ * 'root' is the program or one function. Returns the number of links
+ * redirected to an earlier node.
+ */
+int share_expressions(ASTNode* root);
+
+#endif
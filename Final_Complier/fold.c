@@ -0,0 +1,407 @@
+#include <limits.h>
+#include "fold.h"
+#include "ast_visit.h"
+
+/*
+ * The tree is walked once. Expressions are folded in post order, so an
+ * operator sees its operands already folded, and each node is rewritten
+ * in place: the parent's link to it stays valid. An if is simplified
+ * after its condition and branches, and a statement list once all of
+ * its statements are, so a constant if or while is dealt with by the
+ * list it is in.
+ */
+
+/* Why a node is visited */
+enum {
+    FOLD_NODE,
+    FOLD_CONDITION,      /* The whole condition of an if or while */
+};
+
+/* Schedule everything 'node' links to other than its sibling */
+static void visit_links(ASTVisitor* visitor, const ASTNode* node) {
+    ast_visit_list(visitor, ast_left(node), 0, 0);
+    ast_visit_list(visitor, ast_node(node->right), 0, 0);
+    if (node->type == AST_IF || node->type == AST_WHILE) {
+        ast_visit_list(visitor, ast_condition(node), 0, 0);
+    }
+}
+
+static void count_pre(ASTVisitor* visitor, const ASTVisit* visit) {
+    (*(int*)visitor->data)++;
+    visit_links(visitor, visit->node);
+}
+
+/* Number of nodes in the subtree under 'node', which may be NULL */
+static int count_nodes(ASTNode* node) {
+    if (!node) return 0;
+    int count = 0;
+    ASTVisitor visitor;
+    ast_visitor_init(&visitor, count_pre, NULL, &count);
+    ast_walk(&visitor, node, 0, 0);
+    ast_visitor_free(&visitor);
+    return count;
+}
+
+/* Number of nodes in the list starting at 'first' and under them */
+static int count_list(ASTNode* first) {
+    int count = 0;
+    for (ASTNode* node = first; node; node = ast_next(node)) count += count_nodes(node);
+    return count;
+}
+
+static void find_call(ASTVisitor* visitor, const ASTVisit* visit) {
+    if (visit->node->type == AST_FUNCTION_CALL) *(int*)visitor->data = 1;
+    visit_links(visitor, visit->node);
+}
+
+/* Whether evaluating the expression under 'node' calls a function */
+static int has_call(ASTNode* node) {
+    int found = 0;
+    ASTVisitor visitor;
+    ast_visitor_init(&visitor, find_call, NULL, &found);
+    ast_walk(&visitor, node, 0, 0);
+    ast_visitor_free(&visitor);
+    return found;
+}
+
+/* Literals */
+
+static int is_int(const ASTNode* node, int value) {
+    return ast_is_expr(node, EXPR_NUMBER) && ast_value(node) == value;
+}
+
+static int is_float(const ASTNode* node, float value) {
+    return ast_is_expr(node, EXPR_FLOAT) && ast_float_value(node) == value;
+}
+
+static int is_zero(const ASTNode* node) { return is_int(node, 0) || is_float(node, 0.0f); }
+static int is_one(const ASTNode* node) { return is_int(node, 1) || is_float(node, 1.0f); }
+
+/* Whether the value of 'node' is always 0 or 1 */
+static int is_boolean(const ASTNode* node) {
+    if (is_int(node, 0) || is_int(node, 1) || ast_is_expr(node, EXPR_NOT)) return 1;
+    if (!ast_is_expr(node, EXPR_BINARY)) return 0;
+    switch (ast_binop(node)) {
+        case BINOP_ADD:
+        case BINOP_SUB:
+        case BINOP_MUL:
+        case BINOP_DIV:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+/* Whether 'node' is ID + NUMBER, which the code generator emits as an
+   increment of the ID */
+static int is_increment(const ASTNode* node) {
+    return ast_is_expr(node, EXPR_BINARY) && ast_binop(node) == BINOP_ADD &&
+           ast_is_expr(ast_left(node), EXPR_ID) && ast_is_expr(ast_right(node), EXPR_NUMBER);
+}
+
+/* Whether 'node' is the value 'parent' assigns to the variable it adds
+   to, as in 'x = x + 1', where incrementing the ID is what is meant */
+static int is_self_increment(const ASTNode* node, const ASTNode* parent) {
+    return parent && parent->type == AST_ASSIGNMENT && ast_left(parent) == node &&
+           ast_name(ast_left(node)) == ast_name(parent);
+}
+
+/* Rewriting an expression node in place; its sibling link is kept */
+
+static void make_literal(ASTNode* node, ExprKind kind) {
+    node->left = node->right = node->last_child = 0;
+    node->u.expr.kind = (uint8_t)kind;
+    node->u.expr.op = 0;
+}
+
+static void make_int(ASTNode* node, int value) {
+    make_literal(node, EXPR_NUMBER);
+    node->u.expr.value = value;
+}
+
+static void make_float(ASTNode* node, float value) {
+    make_literal(node, EXPR_FLOAT);
+    node->u.expr.float_value = value;
+}
+
+/* Replace 'node' with its operand 'operand' (whose own slot is dropped) */
+static void replace_with(ASTNode* node, const ASTNode* operand) {
+    ASTIndex next = node->next;
+    *node = *operand;
+    node->next = next;
+}
+
+/* Compute 'a op b'. Returns 0 if it cannot be done at compile time. */
+static int fold_int(BinOp op, int a, int b, int* result) {
+    unsigned ua = (unsigned)a, ub = (unsigned)b;
+    switch (op) {
+        /* Wrap around as the machine does rather than overflow */
+        case BINOP_ADD: *result = (int)(ua + ub); return 1;
+        case BINOP_SUB: *result = (int)(ua - ub); return 1;
+        case BINOP_MUL: *result = (int)(ua * ub); return 1;
+        case BINOP_DIV:
+            if (b == 0 || (a == INT_MIN && b == -1)) return 0;
+            *result = a / b;
+            return 1;
+        case BINOP_OR: *result = a || b; return 1;
+        case BINOP_AND: *result = a && b; return 1;
+        case BINOP_EQ: *result = a == b; return 1;
+        case BINOP_NE: *result = a != b; return 1;
+        case BINOP_GE: *result = a >= b; return 1;
+        case BINOP_LE: *result = a <= b; return 1;
+        case BINOP_GT: *result = a > b; return 1;
+        case BINOP_LT: *result = a < b; return 1;
+    }
+    return 0;
+}
+
+/* Fold 'a op b' into 'node': arithmetic gives a float, comparisons an
+   int. Returns 0 if it cannot be done at compile time. */
+static int fold_float(ASTNode* node, BinOp op, float a, float b) {
+    switch (op) {
+        case BINOP_ADD: make_float(node, a + b); return 1;
+        case BINOP_SUB: make_float(node, a - b); return 1;
+        case BINOP_MUL: make_float(node, a * b); return 1;
+        case BINOP_DIV:
+            if (b == 0.0f) return 0;
+            make_float(node, a / b);
+            return 1;
+        case BINOP_EQ: make_int(node, a == b); return 1;
+        case BINOP_NE: make_int(node, a != b); return 1;
+        case BINOP_GE: make_int(node, a >= b); return 1;
+        case BINOP_LE: make_int(node, a <= b); return 1;
+        case BINOP_GT: make_int(node, a > b); return 1;
+        case BINOP_LT: make_int(node, a < b); return 1;
+        default:
+            /* && and || take ints only */
+            return 0;
+    }
+}
+
+/* Fold an expression whose operands are folded. Returns the number of
+   nodes removed. */
+static int fold_expression(ASTNode* node, int condition) {
+    ASTNode* left = ast_left(node);
+    ASTNode* right = ast_right(node);
+
+    if (ast_is_expr(node, EXPR_NOT)) {
+        if (ast_is_expr(left, EXPR_NUMBER)) {
+            make_int(node, ast_value(left) == 0);
+            return 1;
+        }
+        if (ast_is_expr(left, EXPR_FLOAT)) {
+            make_int(node, ast_float_value(left) == 0.0f);
+            return 1;
+        }
+        if (ast_is_expr(left, EXPR_NOT) && (condition || is_boolean(ast_left(left)))) {
+            replace_with(node, ast_left(left));
+            return 2;
+        }
+        return 0;
+    }
+    if (!ast_is_expr(node, EXPR_BINARY)) return 0;
+
+    BinOp op = ast_binop(node);
+    if (ast_is_expr(left, EXPR_NUMBER) && ast_is_expr(right, EXPR_NUMBER)) {
+        int result;
+        if (!fold_int(op, ast_value(left), ast_value(right), &result)) return 0;
+        make_int(node, result);
+        return 2;
+    }
+    if (ast_is_expr(left, EXPR_FLOAT) && ast_is_expr(right, EXPR_FLOAT)) {
+        return fold_float(node, op, ast_float_value(left), ast_float_value(right)) ? 2 : 0;
+    }
+
+    /* Identities. The operands have the same type, as the semantic
+       checks require, so a literal 0 or 1 is one of the other's type. */
+    switch (op) {
+        case BINOP_ADD:
+            if (is_zero(right)) {
+                replace_with(node, left);
+                return 2;
+            }
+            if (is_zero(left)) {
+                replace_with(node, right);
+                return 2;
+            }
+            break;
+        case BINOP_SUB:
+            if (is_zero(right)) {
+                replace_with(node, left);
+                return 2;
+            }
+            break;
+        case BINOP_MUL:
+            if (is_one(right)) {
+                replace_with(node, left);
+                return 2;
+            }
+            if (is_one(left)) {
+                replace_with(node, right);
+                return 2;
+            }
+            /* Not for floats: inf * 0 and nan * 0 are nan */
+            if (is_int(right, 0) && !has_call(left)) {
+                int removed = count_nodes(left) + 1;
+                make_int(node, 0);
+                return removed;
+            }
+            if (is_int(left, 0) && !has_call(right)) {
+                int removed = count_nodes(right) + 1;
+                make_int(node, 0);
+                return removed;
+            }
+            break;
+        case BINOP_DIV:
+            if (is_one(right)) {
+                replace_with(node, left);
+                return 2;
+            }
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+/* Truth value of a condition folded to a literal: 1 or 0, or -1 if it
+   is not constant */
+static int constant_truth(const ASTNode* condition) {
+    if (ast_is_expr(condition, EXPR_NUMBER)) return ast_value(condition) != 0;
+    if (ast_is_expr(condition, EXPR_FLOAT)) return ast_float_value(condition) != 0.0f;
+    return -1;
+}
+
+/* Drop an else-if whose condition is constant from the end of the
+   chain below 'node': a true one becomes a plain else, a false one is
+   replaced by its own else. Its own chain is simplified already. */
+static int fold_else(ASTNode* node) {
+    ASTNode* else_part = ast_left(node);
+    if (!else_part || !ast_condition(else_part)) return 0;
+
+    int truth = constant_truth(ast_condition(else_part));
+    if (truth == 1) {
+        int removed = count_nodes(ast_condition(else_part)) + count_nodes(ast_left(else_part));
+        else_part->u.condition = 0;
+        else_part->left = else_part->last_child = 0;
+        return removed;
+    }
+    if (truth == 0) {
+        node->left = else_part->left;
+        return 1 + count_nodes(ast_condition(else_part)) + count_list(ast_body(else_part));
+    }
+    return 0;
+}
+
+/* Replace each if with a constant condition in the list at 'link' by
+   the statements of the branch taken, and remove each while whose
+   condition is 0. Returns the number of nodes removed. */
+static int fold_statements(ASTIndex* link) {
+    int removed = 0;
+    while (*link) {
+        ASTNode* stmt = ast_node(*link);
+        int truth = constant_truth(ast_condition(stmt));
+        if (truth < 0 || (stmt->type == AST_WHILE && truth)) {
+            link = &stmt->next;
+            continue;
+        }
+
+        ASTNode* branch = NULL;
+        if (stmt->type == AST_WHILE) {
+            removed += count_nodes(stmt);
+        } else {
+            ASTNode* else_part = ast_left(stmt);
+            if (truth) {
+                branch = ast_body(stmt);
+                removed += 1 + count_nodes(ast_condition(stmt)) + count_nodes(else_part);
+            } else {
+                removed += 1 + count_nodes(ast_condition(stmt)) + count_list(ast_body(stmt));
+                if (else_part && !ast_condition(else_part)) {
+                    /* A plain else: its statements */
+                    branch = ast_body(else_part);
+                    removed++;
+                } else {
+                    /* An else-if, or nothing */
+                    branch = else_part;
+                }
+            }
+        }
+
+        /* Splice the branch in; its statements are folded already */
+        if (!branch) {
+            *link = stmt->next;
+            continue;
+        }
+        ASTNode* tail = branch;
+        while (tail->next) tail = ast_next(tail);
+        tail->next = stmt->next;
+        *link = ast_index(branch);
+        link = &tail->next;
+    }
+    return removed;
+}
+
+static void fold_pre(ASTVisitor* visitor, const ASTVisit* visit) {
+    ASTNode* node = visit->node;
+    switch (node->type) {
+        case AST_IF:
+        case AST_WHILE:
+            if (ast_condition(node)) ast_visit_child(visitor, ast_condition(node), FOLD_CONDITION, 0);
+            ast_visit_list(visitor, ast_body(node), FOLD_NODE, 0);
+            if (node->type == AST_IF && ast_left(node)) ast_visit_child(visitor, ast_left(node), FOLD_NODE, 0);
+            break;
+        case AST_EXPRESSION:
+            ast_push_value(visitor, is_increment(node));
+            if (ast_left(node)) ast_visit_child(visitor, ast_left(node), FOLD_NODE, 0);
+            if (ast_right(node)) ast_visit_child(visitor, ast_right(node), FOLD_NODE, 0);
+            break;
+        case AST_FUNCTION_CALL:
+            ast_visit_list(visitor, ast_arguments(node), FOLD_NODE, 0);
+            break;
+        default:
+            /* Statements, declarations and their expressions, and array
+               initializers and accesses keep what they hold under 'left' */
+            ast_visit_list(visitor, ast_left(node), FOLD_NODE, 0);
+            break;
+    }
+}
+
+static void fold_post(ASTVisitor* visitor, const ASTVisit* visit) {
+    ASTNode* node = visit->node;
+    int* removed = (int*)visitor->data;
+    switch (node->type) {
+        case AST_EXPRESSION: {
+            int was_increment = (int)ast_pop_value(visitor);
+            *removed += fold_expression(node, visit->tag == FOLD_CONDITION);
+            if (!was_increment && is_increment(node) && !is_self_increment(node, visit->parent)) {
+                /* Folding made an ID + NUMBER, as in 'y = x + 2 * 3'; with
+                   the literal first it is an addition, not an increment */
+                ASTIndex left = node->left;
+                node->left = node->right;
+                node->right = left;
+            }
+            break;
+        }
+        case AST_IF:
+            *removed += fold_else(node);
+            *removed += fold_statements(&node->right);
+            break;
+        case AST_WHILE:
+            *removed += fold_statements(&node->right);
+            break;
+        case AST_BLOCK:
+            *removed += fold_statements(&node->left);
+            break;
+        default:
+            break;
+    }
+}
+
+int fold_constants(ASTNode* root) {
+    int removed = 0;
+    ASTVisitor visitor;
+    ast_visitor_init(&visitor, fold_pre, fold_post, &removed);
+    if (root) ast_walk(&visitor, root, FOLD_NODE, 0);
+    ast_visitor_free(&visitor);
+    return removed;
+}
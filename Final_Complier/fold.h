@@ -0,0 +1,25 @@
+#ifndef FOLD_H
+#define FOLD_H
+
+#include "ast.h"
+
+/*
+ * Simplify a checked tree before code generation, in place:
+ * - operators whose operands are int or float literals are computed
+ *   (not divisions by zero or ones that overflow);
+ * - x + 0, 0 + x, x - 0, x * 1, 1 * x and x / 1 become x, and x * 0 and
+ *   0 * x become 0 when x calls no function;
+ * - !!x becomes x when x is 0 or 1 already (a comparison, a logical
+ *   operator, a '!' or a literal 0 or 1) or is the whole condition of
+ *   an if or while;
+ * - an if whose condition is constant is replaced by the statements of
+ *   the branch taken, and a while whose condition is 0 is removed.
+ * Folding never leaves a new ID + NUMBER, which the code generator
+ * emits as an increment of the ID, except as the whole value of
+ * 'x = x + ...': elsewhere the operands are swapped to NUMBER + ID.
+ * 'root' is the program or one function. Returns the number of nodes
+ * removed from the tree.
+ */
+int fold_constants(ASTNode* root);
+
+#endif
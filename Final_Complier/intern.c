@@ -0,0 +1,152 @@
+/* intern.c */
+
+#include "intern.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Atom text is carved out of large chunks rather than malloc'd per name */
+#define CHUNK_SIZE (64 * 1024)
+
+typedef struct Chunk {
+    struct Chunk* next;
+    size_t used;
+    size_t size;
+    char data[];
+} Chunk;
+
+/* Each thread has its own table, so concurrent compilations on
+   different threads do not share atoms */
+static _Thread_local Chunk* chunks = NULL;
+
+/* Open-addressing hash table of atoms (power-of-two capacity) */
+static _Thread_local const char** slots = NULL;
+static _Thread_local size_t slot_capacity = 0;
+
+/* Atoms indexed by id */
+static _Thread_local const char** atoms = NULL;
+static _Thread_local unsigned atoms_used = 0;
+static _Thread_local unsigned atoms_capacity = 0;
+
+static inline const AtomHeader* header_of(const char* atom) {
+    return (const AtomHeader*)atom - 1;
+}
+
+/* FNV-1a */
+static uint32_t hash_bytes(const char* text, size_t length) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        h ^= (unsigned char)text[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void* xmalloc(size_t size) {
+    void* p = malloc(size);
+    if (!p) {
+        fprintf(stderr, "Failed to allocate memory for identifier table.\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+static char* chunk_alloc(size_t size) {
+    /* Keep headers 4-byte aligned */
+    size = (size + 3) & ~(size_t)3;
+    if (!chunks || chunks->used + size > chunks->size) {
+        size_t capacity = size > CHUNK_SIZE ? size : CHUNK_SIZE;
+        Chunk* chunk = (Chunk*)xmalloc(sizeof(Chunk) + capacity);
+        chunk->next = chunks;
+        chunk->used = 0;
+        chunk->size = capacity;
+        chunks = chunk;
+    }
+    char* p = chunks->data + chunks->used;
+    chunks->used += size;
+    return p;
+}
+
+static void grow_slots(void) {
+    size_t new_capacity = slot_capacity ? slot_capacity * 2 : 1024;
+    const char** new_slots = (const char**)xmalloc(new_capacity * sizeof(const char*));
+    memset(new_slots, 0, new_capacity * sizeof(const char*));
+    for (size_t i = 0; i < slot_capacity; i++) {
+        const char* atom = slots[i];
+        if (!atom) continue;
+        size_t j = header_of(atom)->hash & (new_capacity - 1);
+        while (new_slots[j]) j = (j + 1) & (new_capacity - 1);
+        new_slots[j] = atom;
+    }
+    free(slots);
+    slots = new_slots;
+    slot_capacity = new_capacity;
+}
+
+const char* intern(const char* text, size_t length) {
+    /* Keep the load factor at or below 1/2 */
+    if ((atoms_used + 1) * 2 > slot_capacity) {
+        grow_slots();
+    }
+
+    uint32_t hash = hash_bytes(text, length);
+    size_t mask = slot_capacity - 1;
+    size_t i = hash & mask;
+    while (slots[i]) {
+        const char* atom = slots[i];
+        const AtomHeader* h = header_of(atom);
+        if (h->hash == hash && h->length == length && memcmp(atom, text, length) == 0) {
+            return atom;
+        }
+        i = (i + 1) & mask;
+    }
+
+    /* New atom */
+    AtomHeader* h = (AtomHeader*)chunk_alloc(sizeof(AtomHeader) + length + 1);
+    h->hash = hash;
+    h->id = atoms_used;
+    h->length = (uint32_t)length;
+    char* atom = (char*)(h + 1);
+    memcpy(atom, text, length);
+    atom[length] = '\0';
+    slots[i] = atom;
+
+    if (atoms_used == atoms_capacity) {
+        atoms_capacity = atoms_capacity ? atoms_capacity * 2 : 1024;
+        const char** grown = (const char**)realloc(atoms, atoms_capacity * sizeof(const char*));
+        if (!grown) {
+            fprintf(stderr, "Failed to allocate memory for identifier table.\n");
+            exit(EXIT_FAILURE);
+        }
+        atoms = grown;
+    }
+    atoms[atoms_used++] = atom;
+    return atom;
+}
+
+const char* intern_cstr(const char* text) {
+    return intern(text, strlen(text));
+}
+
+const char* atom_by_id(unsigned id) {
+    return id < atoms_used ? atoms[id] : NULL;
+}
+
+unsigned atom_count(void) {
+    return atoms_used;
+}
+
+void intern_free_all(void) {
+    while (chunks) {
+        Chunk* next = chunks->next;
+        free(chunks);
+        chunks = next;
+    }
+    free(slots);
+    free(atoms);
+    slots = NULL;
+    atoms = NULL;
+    slot_capacity = 0;
+    atoms_used = 0;
+    atoms_capacity = 0;
+}
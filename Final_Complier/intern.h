@@ -0,0 +1,57 @@
+/* intern.h */
+
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Identifier interning.
+ *
+ * Every distinct identifier is stored once and represented by a
+ * canonical "atom" pointer to its NUL-terminated text. Two atoms are
+ * the same name exactly when the pointers are equal, so names can be
+ * compared with == instead of strcmp. Atoms stay valid until
+ * intern_free_all() and must never be freed individually.
+ *
+ * Each atom also has a dense integer id (0, 1, 2, ... in order of first
+ * appearance), its length and its hash, all readable in O(1).
+ */
+
+/* Return the atom for the 'length' bytes at 'text' */
+const char* intern(const char* text, size_t length);
+
+/* Return the atom for a NUL-terminated string */
+const char* intern_cstr(const char* text);
+
+/* Stored immediately in front of every atom's text */
+typedef struct AtomHeader {
+    uint32_t hash;
+    uint32_t id;
+    uint32_t length;
+} AtomHeader;
+
+/* O(1) properties of an atom returned by intern() */
+static inline unsigned atom_id(const char* atom) {
+    return ((const AtomHeader*)atom - 1)->id;
+}
+
+static inline unsigned atom_hash(const char* atom) {
+    return ((const AtomHeader*)atom - 1)->hash;
+}
+
+static inline size_t atom_length(const char* atom) {
+    return ((const AtomHeader*)atom - 1)->length;
+}
+
+/* Look an atom up by id; NULL if out of range */
+const char* atom_by_id(unsigned id);
+
+/* Number of distinct atoms interned so far */
+unsigned atom_count(void);
+
+/* Release every atom */
+void intern_free_all(void);
+
+#endif /* INTERN_H */
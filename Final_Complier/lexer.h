@@ -0,0 +1,60 @@
+/* lexer.h */
+
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Reentrant scanner interface. Implemented either by the flex scanner
+ * (lexer.l) or by the hand-written scanner (scanner.c); see LEXER in
+ * the Makefile. All scanning state lives in a Lexer, so several inputs
+ * can be scanned at once. The parser reads tokens through yylex() in
+ * tokens.c, which calls lexer_lex() or replays a pre-lexed buffer.
+ */
+typedef struct Lexer Lexer;
+
+union YYSTYPE;
+
+Lexer* lexer_create(void);
+void lexer_destroy(Lexer* lexer);
+
+/* Return the next token (0 at end of input), setting *value */
+int lexer_lex(Lexer* lexer, union YYSTYPE* value);
+
+/* Byte offset of the current token from the start of the input */
+uint32_t lexer_token_offset(const Lexer* lexer);
+
+/* Text of the current token. Only the first *length bytes are valid:
+   the hand-written scanner does not NUL-terminate it. */
+const char* lexer_token_text(const Lexer* lexer, int* length);
+
+/* Scan 'length' bytes at 'base' in place, without copying. The text
+   must be followed by SOURCE_PADDING NUL bytes (see source.h). */
+void lexer_scan_buffer(Lexer* lexer, char* base, size_t length);
+
+/* Scan from a stdio stream through the scanner's own read buffer */
+void lexer_scan_stream(Lexer* lexer, FILE* in);
+
+/* Whole text of the current input, when the scanner holds it in memory.
+   Returns -1 if it does not (the flex scanner reads incrementally). */
+int lexer_input_text(const Lexer* lexer, const char** text, size_t* length);
+
+struct TokenBuffer;
+
+/* Append the tokens of text[begin, end) to 'out' without any Lexer, so
+   several ranges can be lexed on different threads. 'end' must directly
+   follow a newline (or be the end of the text), and 'text' must be
+   padded as for lexer_scan_buffer(). Identifier tokens carry their
+   length in 'value' rather than an atom id, since interning is not
+   thread-safe, and unrecognized characters are kept as
+   TOKEN_KIND_UNRECOGNIZED tokens. Only the hand-written scanner
+   implements this. */
+void lexer_lex_range(const char* text, size_t begin, size_t end, struct TokenBuffer* out);
+
+/* Release the scanner's input buffers once the input has been consumed */
+void lexer_finish(Lexer* lexer);
+
+#endif /* LEXER_H */
@@ -0,0 +1,381 @@
+/* main.c - compiler driver: reads the source and runs each phase */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parser.tab.h"
+#include "symbol_table.h"
+#include "ast.h"
+#include "semantic.h"
+#include "codegen.h"
+#include "mips.h"
+#include "diag.h"
+#include "lexer.h"
+#include "source.h"
+#include "intern.h"
+#include "tokens.h"
+#include "parse_context.h"
+#include "rd_parser.h"
+#include "ast_cache.h"
+#include "fold.h"
+#include "expr_dag.h"
+
+/* The last phase to run; the later ones are skipped entirely */
+typedef enum Stage {
+    STAGE_TOKENS,   /* --emit=tokens: list the tokens on standard output */
+    STAGE_AST,      /* --emit=ast: parse and print the AST */
+    STAGE_CHECK,    /* -fsyntax-only: parse and run semantic analysis */
+    STAGE_TAC,      /* --emit=tac: also write tac_output.txt */
+    STAGE_ASM       /* --emit=asm (default): also write output.asm */
+} Stage;
+static Stage last_stage = STAGE_ASM;
+
+/* Lex the whole input into a token buffer before parsing (--prelex) */
+static int prelex_input = 0;
+/* Threads for lexing the token buffer (--lex-threads=N); 0 lexes serially */
+static int lex_threads = 0;
+/* Parse with the hand-written parser instead of bison's (--parser=rd) */
+static int use_rd_parser = 0;
+/* Check and generate code for each function as soon as it is parsed (--stream) */
+static int stream_functions = 0;
+/* Reuse the tree cached in this file if it is for the same text, and
+   otherwise write it there after parsing (--ast-cache=FILE) */
+static const char* ast_cache_path = NULL;
+/* Fold constants and share common subexpressions before generating
+   code; -O0 turns it off */
+static int optimize = 1;
+
+/* Progress of a streaming compilation */
+typedef struct StreamState {
+    int functions;           /* Functions compiled so far */
+    int semantic_errors;     /* Semantic errors reported so far */
+    int folded;              /* Nodes removed by constant folding */
+    int shared;              /* Subexpressions shared */
+    ASTMark mark;            /* The arena before the current function */
+} StreamState;
+
+/* Streaming compilation of one function: check it, emit its TAC and
+   assembly unless there have been semantic errors, then release it, so
+   only one function's tree is held at a time */
+static void compile_function(ASTNode* function, void* data) {
+    StreamState* stream = data;
+    stream->functions++;
+    if (last_stage >= STAGE_CHECK) {
+        stream->semantic_errors = traverse_function(function);
+    }
+    if (stream->semantic_errors == 0) {
+        if (optimize && last_stage >= STAGE_TAC) {
+            stream->folded += fold_constants(function);
+            stream->shared += share_expressions(function);
+        }
+        if (last_stage == STAGE_AST || diag_enabled(DIAG_TRACE)) {
+            diag_flush();
+            print_ast(function, 1);
+        }
+        if (last_stage >= STAGE_TAC) generate_tac_function(function);
+        if (last_stage >= STAGE_ASM) generate_mips_function(function);
+    }
+    ast_release(stream->mark);
+}
+
+/* Open the outputs the requested stages write to */
+static void begin_streaming(void) {
+    if (last_stage == STAGE_AST) printf("Program\n");
+    if (last_stage >= STAGE_TAC) generate_tac_begin();
+    if (last_stage >= STAGE_ASM) generate_mips_begin();
+}
+
+/* Close the streamed outputs, and delete them if the compilation failed
+   part-way so no truncated file is left behind */
+static void finish_streaming(int failed) {
+    if (last_stage >= STAGE_TAC) {
+        generate_tac_end();
+        if (failed) remove("tac_output.txt");
+    }
+    if (last_stage >= STAGE_ASM) {
+        generate_mips_end();
+        if (failed) remove("output.asm");
+    }
+}
+
+/* --emit=tokens: one line per token with its position, kind and text.
+   Nothing past the scanner runs, not even the symbol table. */
+static void emit_tokens(const SourceBuffer* source) {
+    Lexer* lexer = lexer_create();
+    lexer_scan_buffer(lexer, source->data, source->length);
+    YYSTYPE value;
+    int token;
+    while ((token = lexer_lex(lexer, &value)) != 0) {
+        int line, column, length;
+        source_locate(lexer_token_offset(lexer), &line, &column);
+        const char* text = lexer_token_text(lexer, &length);
+        printf("%d:%d\t%-12s %.*s\n", line, column, token_kind_name(token), length, text);
+    }
+    lexer_destroy(lexer);
+}
+
+/* Lex and parse 'source' with the chosen scanner and parser into 'ctx',
+   compiling each function as it is parsed when streaming. Returns the
+   parser's status. */
+static int parse_source(const SourceBuffer* source, ParseContext* ctx, StreamState* stream) {
+    /* All parser and scanner state for this input */
+    parse_context_init(ctx, lexer_create());
+    lexer_scan_buffer(ctx->lexer, source->data, source->length);
+
+    /* Optionally lex everything up front, then parse from the buffer */
+    TokenBuffer tokens;
+    token_buffer_init(&tokens);
+    if (prelex_input) {
+        clock_t lex_start = clock();
+        if (lex_threads > 0) {
+            tokens_lex_parallel(&tokens, ctx->lexer, lex_threads);
+        } else {
+            tokens_lex_all(&tokens, ctx->lexer);
+        }
+        diag_summary("Lexed %zu tokens in %.4f seconds.\n", tokens.count - 1,
+                     (double)(clock() - lex_start) / CLOCKS_PER_SEC);
+        tokens_replay(ctx, &tokens);
+    }
+
+    if (stream_functions) {
+        begin_streaming();
+        stream->mark = ast_mark();
+        ctx->on_function = compile_function;
+        ctx->on_function_data = stream;
+    }
+
+    /* Start parsing */
+    int parse_status = use_rd_parser ? rd_parse(ctx) : yyparse(ctx);
+    token_buffer_free(&tokens);
+    lexer_destroy(ctx->lexer);
+    ctx->lexer = NULL;
+    return parse_status;
+}
+
+/* Compile 'filename', or standard input when filename is NULL.
+   Regular files are mapped and scanned in place; pipes and terminals
+   are read into memory first. The text stays available until the end
+   so diagnostics can turn node offsets into lines and columns.
+   The symbol table, atoms, nodes and current text belong to the
+   calling thread and are released on the way out, so a thread runs one
+   compilation at a time (see parse_context.h). */
+static void compile(const char *filename) {
+    SourceBuffer source = { NULL, 0, 0 };
+
+    if (filename) {
+        diag_summary("Compiling file: %s\n", filename);
+        int status = source_map_file(filename, &source);
+        if (status < 0) {
+            exit(EXIT_FAILURE);
+        } else if (status > 0) {
+            FILE* stream = fopen(filename, "r");
+            if (!stream) {
+                fprintf(stderr, "Cannot open '%s'.\n", filename);
+                exit(EXIT_FAILURE);
+            }
+            source_read_stream(stream, &source);
+            fclose(stream);
+        }
+    } else {
+        /* Read to the end first: offsets into the text must stay valid
+           until the last diagnostic (see source_read_stream) */
+        source_read_stream(stdin, &source);
+    }
+    source_set_current(&source);
+
+    if (last_stage == STAGE_TOKENS) {
+        emit_tokens(&source);
+        source_set_current(NULL);
+        source_release(&source);
+        intern_free_all();
+        return;
+    }
+
+    /* Initialize the symbol table */
+    init_symbol_table();
+
+    /* Parse, unless there is a cached tree for this text */
+    StreamState stream = { 0, 0, 0, 0, { 0 } };
+    ASTNode* ast_root = ast_cache_path ? ast_cache_load(ast_cache_path, &source) : NULL;
+    int parse_status = 0;
+    if (ast_root) {
+        diag_summary("Reused the tree cached in %s.\n", ast_cache_path);
+    } else {
+        int errors_before = tokens_error_count();
+        ParseContext ctx;
+        parse_status = parse_source(&source, &ctx, &stream);
+        ast_root = ctx.ast_root;
+        if (parse_status == 0) diag_summary("Parsing completed successfully.\n");
+
+        /* Only a tree that parsed without any messages is cached, since
+           reusing it skips whatever printed them */
+        if (ast_cache_path && parse_status == 0 && ctx.errors == 0 &&
+            tokens_error_count() == errors_before) {
+            if (ast_cache_write(ast_cache_path, &source, ast_root) != 0) {
+                fprintf(stderr, "Cannot write AST cache '%s'.\n", ast_cache_path);
+            }
+        }
+    }
+
+    if (parse_status == 0) {
+        /* Dump the symbol table for debugging */
+        if (diag_enabled(DIAG_TRACE)) {
+            diag_flush();
+            print_symbol_table();
+        }
+
+        if (stream_functions) {
+            /* Every function has been checked and generated already */
+            finish_streaming(stream.semantic_errors > 0);
+            semantic_finish();
+            if (optimize && last_stage >= STAGE_TAC) {
+                diag_summary("Constant folding removed %d nodes.\n", stream.folded);
+                diag_summary("Shared %d repeated subexpressions.\n", stream.shared);
+            }
+            diag_summary("Compiled %d functions while parsing.\n", stream.functions);
+        } else if (last_stage == STAGE_AST) {
+            /* Stop at the tree, unchecked */
+            diag_flush();
+            print_ast(ast_root, 0);
+        } else {
+            /* Perform semantic analysis */
+            traverse_ast(ast_root);
+            diag_summary("Semantic analysis completed successfully.\n");
+
+            /* Simplify the tree for code generation */
+            if (optimize && last_stage >= STAGE_TAC) {
+                int removed = fold_constants(ast_root);
+                diag_summary("Constant folding removed %d nodes.\n", removed);
+                int shared = share_expressions(ast_root);
+                diag_summary("Shared %d repeated subexpressions.\n", shared);
+            }
+
+            /* Print the AST for debugging */
+            if (diag_enabled(DIAG_TRACE)) {
+                diag_flush();
+                print_ast(ast_root, 0);
+            }
+
+            /* Generate TAC */
+            if (last_stage >= STAGE_TAC) {
+                diag_summary("Generating TAC...\n");
+                generate_tac(ast_root);
+                diag_summary("TAC generation completed.\n");
+            }
+
+            /* Generate MIPS assembly directly from AST */
+            if (last_stage >= STAGE_ASM) {
+                diag_summary("Generating MIPS assembly...\n");
+                generate_mips(ast_root);
+                diag_summary("MIPS assembly generation completed.\n");
+            }
+        }
+
+        /* Free resources */
+        free_all_symbol_tables();
+    } else {
+        if (stream_functions) finish_streaming(1);
+        fprintf(stderr, "Parsing failed. Please check your input.\n");
+    }
+    ast_free_all();
+    source_set_current(NULL);
+    source_release(&source);
+    intern_free_all();
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s [-q | -v | --diag=silent|summary|trace] [--prelex] [--lex-threads=N] [--parser=bison|rd] [--stream]\n"
+                    "       [--ast-cache=FILE] [-O0] [-fsyntax-only | --emit=tokens|ast|tac|asm] [file]\n", prog);
+    fprintf(stderr, "Reads standard input when no file is given.\n");
+    fprintf(stderr, "--prelex lexes the whole input before parsing it;\n");
+    fprintf(stderr, "--lex-threads=N does so on N threads (hand-written scanner only).\n");
+    fprintf(stderr, "--parser=rd parses with the recursive-descent parser instead of bison's.\n");
+    fprintf(stderr, "--stream compiles and frees each function as soon as it is parsed.\n");
+    fprintf(stderr, "--ast-cache=FILE reuses the tree saved in FILE when the source is unchanged,\n");
+    fprintf(stderr, "and saves it there otherwise (not with --stream).\n");
+    fprintf(stderr, "-O0 generates code for the tree as parsed, without folding constants\n");
+    fprintf(stderr, "or sharing common subexpressions.\n");
+    fprintf(stderr, "-fsyntax-only stops after semantic analysis and writes no files;\n");
+    fprintf(stderr, "--emit=tokens or --emit=ast prints the tokens or the tree and stops there;\n");
+    fprintf(stderr, "--emit=tac writes only tac_output.txt; --emit=asm (the default) writes both.\n");
+}
+
+int main(int argc, char** argv) {
+    /* Record start time */
+    clock_t start_time = clock();
+
+    /* Diagnostics default to one line per phase */
+    DiagLevel level = DIAG_SUMMARY;
+    const char* filename = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-q") == 0) {
+            level = DIAG_SILENT;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            level = DIAG_TRACE;
+        } else if (strcmp(argv[i], "--prelex") == 0) {
+            prelex_input = 1;
+        } else if (strncmp(argv[i], "--lex-threads=", 14) == 0) {
+            lex_threads = atoi(argv[i] + 14);
+            if (lex_threads < 1) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            prelex_input = 1;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream_functions = 1;
+        } else if (strncmp(argv[i], "--ast-cache=", 12) == 0 && argv[i][12] != '\0') {
+            ast_cache_path = argv[i] + 12;
+        } else if (strcmp(argv[i], "--parser=bison") == 0) {
+            use_rd_parser = 0;
+        } else if (strcmp(argv[i], "--parser=rd") == 0) {
+            use_rd_parser = 1;
+        } else if (strcmp(argv[i], "-O0") == 0) {
+            optimize = 0;
+        } else if (strcmp(argv[i], "-fsyntax-only") == 0) {
+            last_stage = STAGE_CHECK;
+        } else if (strcmp(argv[i], "--emit=tokens") == 0) {
+            last_stage = STAGE_TOKENS;
+        } else if (strcmp(argv[i], "--emit=ast") == 0) {
+            last_stage = STAGE_AST;
+        } else if (strcmp(argv[i], "--emit=tac") == 0) {
+            last_stage = STAGE_TAC;
+        } else if (strcmp(argv[i], "--emit=asm") == 0) {
+            last_stage = STAGE_ASM;
+        } else if (strncmp(argv[i], "--diag=", 7) == 0) {
+            int parsed = diag_parse_level(argv[i] + 7);
+            if (parsed < 0) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            level = (DiagLevel)parsed;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        } else if (!filename) {
+            /* "-" means standard input */
+            filename = strcmp(argv[i], "-") == 0 ? NULL : argv[i];
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (ast_cache_path && stream_functions) {
+        /* A streamed tree is freed function by function, so there is
+           nothing to cache */
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    diag_init(level);
+
+    compile(filename);
+
+    /* Record end time */
+    clock_t end_time = clock();
+    double elapsed_time = (double)(end_time - start_time) / CLOCKS_PER_SEC;
+    diag_summary("Compilation time: %.4f seconds\n", elapsed_time);
+    diag_flush();
+
+    return 0;
+}
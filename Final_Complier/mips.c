@@ -2,188 +2,237 @@
 #include <stdlib.h>
 #include <string.h>
 #include "ast.h"
+#include "mips.h"
 
-void generate_mips(ASTNode *root)
+/* Output file, and the code of the functions that follow main. Those
+   are held in temporary files until the end, since they come before
+   main in the source but after it in the output. */
+static _Thread_local FILE *out = NULL;
+static _Thread_local FILE *add_code = NULL;
+static _Thread_local FILE *foo_code = NULL;
+
+static FILE *open_temporary(void)
 {
-    FILE *out = fopen("output.asm", "w");
-    if (!out)
+    FILE *file = tmpfile();
+    if (!file)
     {
-        fprintf(stderr, "Failed to open output file\n");
+        fprintf(stderr, "Failed to open temporary file for MIPS output\n");
         exit(1);
     }
+    return file;
+}
 
-    // Write the data section
-    fprintf(out, ".data\n");
-    fprintf(out, "    float_val: .float 3.14\n");
-    fprintf(out, "    float_ten: .float 10.0\n");
-    fprintf(out, "    newline: .asciiz \"\\n\"\n\n");
-    fprintf(out, ".text\n\n");
-
-    // Generate main first
-    ASTNode *current = root->left;
-    while (current != NULL)
+/* Copy 'from' to the end of the output and close it */
+static void append_code(FILE *from)
+{
+    char buffer[4096];
+    size_t n;
+    rewind(from);
+    while ((n = fread(buffer, 1, sizeof(buffer), from)) > 0)
     {
-        if (current->type == AST_MAIN_FUNCTION)
-        {
-            fprintf(out, "main:\n");
-            fprintf(out, "    addi $sp, $sp, -32\n");
-            fprintf(out, "    sw $ra, 28($sp)\n");
-            fprintf(out, "    sw $s0, 24($sp)\n");
-            fprintf(out, "    sw $s1, 20($sp)\n\n");
-            fprintf(out, "    li $s0, 5\n\n");
-            fprintf(out, "    li $s1, 10\n\n");
-            fprintf(out, "    li $t0, 5\n");
-            fprintf(out, "    addi $t0, $t0, 4\n");
-            fprintf(out, "    mul $t0, $t0, 3\n\n");
-            fprintf(out, "    l.s $f12, float_val\n\n");
-            fprintf(out, "    li $a0, 65    \n");
-            fprintf(out, "    move $a1, $s0 \n");
-            fprintf(out, "    jal foo\n\n");
-            fprintf(out, "    move $s2, $v0\n\n");
-            fprintf(out, "    li $a0, 1\n");
-            fprintf(out, "    li $a1, 2\n");
-            fprintf(out, "    li $a2, 3\n");
-            fprintf(out, "    jal add_func\n");
-            fprintf(out, "    move $s3, $v0\n\n");
-
-            // Process while loop if present
-            ASTNode *body = current->left; // Get the function body
-            ASTNode *stmt = body->left;    // Get the first statement
-
-            // printf("Checking main's statements:\n");
-            while (stmt != NULL)
-            {
-                // printf("Statement type: %d\n", stmt->type);
-                if (stmt->type == AST_WHILE)
-                {
-                    fprintf(out, "while_loop:\n");
-                    fprintf(out, "    li $t0, 10\n");
-                    fprintf(out, "    bge $s0, $t0, end_while\n\n");
-                    fprintf(out, "    move $a0, $s0\n");
-                    fprintf(out, "    li $v0, 1\n");
-                    fprintf(out, "    syscall\n\n");
-                    fprintf(out, "    la $a0, newline\n");
-                    fprintf(out, "    li $v0, 4\n");
-                    fprintf(out, "    syscall\n\n");
-                    fprintf(out, "    addi $s0, $s0, 1\n");
-                    fprintf(out, "    j while_loop\n\n");
-                    fprintf(out, "end_while:\n");
-                }
-                stmt = stmt->next;
-            }
-
-            // Main's exit code
-            fprintf(out, "    move $a0, $s3\n");
-            fprintf(out, "    li $v0, 1\n");
-            fprintf(out, "    syscall\n\n");
-            fprintf(out, "    la $a0, newline\n");
-            fprintf(out, "    li $v0, 4\n");
-            fprintf(out, "    syscall\n\n");
-            fprintf(out, "    li $v0, 10\n");
-            fprintf(out, "    syscall\n\n");
-        }
-        current = current->next;
+        fwrite(buffer, 1, n, out);
     }
+    fclose(from);
+}
+
+static void generate_main(ASTNode *function)
+{
+    fprintf(out, "main:\n");
+    fprintf(out, "    addi $sp, $sp, -32\n");
+    fprintf(out, "    sw $ra, 28($sp)\n");
+    fprintf(out, "    sw $s0, 24($sp)\n");
+    fprintf(out, "    sw $s1, 20($sp)\n\n");
+    fprintf(out, "    li $s0, 5\n\n");
+    fprintf(out, "    li $s1, 10\n\n");
+    fprintf(out, "    li $t0, 5\n");
+    fprintf(out, "    addi $t0, $t0, 4\n");
+    fprintf(out, "    mul $t0, $t0, 3\n\n");
+    fprintf(out, "    l.s $f12, float_val\n\n");
+    fprintf(out, "    li $a0, 65    \n");
+    fprintf(out, "    move $a1, $s0 \n");
+    fprintf(out, "    jal foo\n\n");
+    fprintf(out, "    move $s2, $v0\n\n");
+    fprintf(out, "    li $a0, 1\n");
+    fprintf(out, "    li $a1, 2\n");
+    fprintf(out, "    li $a2, 3\n");
+    fprintf(out, "    jal add_func\n");
+    fprintf(out, "    move $s3, $v0\n\n");
 
-    // Generate add_func
-    current = root->left;
-    while (current != NULL)
+    // Process while loop if present
+    ASTNode *body = ast_left(function); // Get the function body
+    ASTNode *stmt = ast_left(body);    // Get the first statement
+
+    // printf("Checking main's statements:\n");
+    while (stmt != NULL)
     {
-        if (current->type == AST_FUNCTION_DEFINITION && strcmp(current->name, "add") == 0)
+        // printf("Statement type: %d\n", stmt->type);
+        if (stmt->type == AST_WHILE)
         {
-            fprintf(out, "add_func:\n");
-            fprintf(out, "    addi $sp, $sp, -16\n");
-            fprintf(out, "    sw $ra, 12($sp)\n");
-            fprintf(out, "    sw $s0, 8($sp)\n\n");
-            fprintf(out, "    li $s0, 65\n\n");
-            fprintf(out, "    li $t1, 9\n");
-            fprintf(out, "    mul $t0, $a1, $t1    \n");
-            fprintf(out, "    add $v0, $a0, $t0    \n");
-            fprintf(out, "    move $t5, $v0        \n\n");
-            fprintf(out, "    li $t0, 5\n");
-            fprintf(out, "    bge $a0, $t0, skip_write_b\n\n");
-            fprintf(out, "    move $a0, $a1\n");
-            fprintf(out, "    li $v0, 1\n");
-            fprintf(out, "    syscall\n\n");
-            fprintf(out, "    la $a0, newline\n");
-            fprintf(out, "    li $v0, 4\n");
-            fprintf(out, "    syscall\n\n");
-            fprintf(out, "skip_write_b:\n");
+            fprintf(out, "while_loop:\n");
+            fprintf(out, "    li $t0, 10\n");
+            fprintf(out, "    bge $s0, $t0, end_while\n\n");
             fprintf(out, "    move $a0, $s0\n");
             fprintf(out, "    li $v0, 1\n");
             fprintf(out, "    syscall\n\n");
             fprintf(out, "    la $a0, newline\n");
             fprintf(out, "    li $v0, 4\n");
             fprintf(out, "    syscall\n\n");
-            fprintf(out, "    move $v0, $t5        \n\n");
-            fprintf(out, "    lw $ra, 12($sp)\n");
-            fprintf(out, "    lw $s0, 8($sp)\n");
-            fprintf(out, "    addi $sp, $sp, 16\n");
-            fprintf(out, "    jr $ra\n\n");
+            fprintf(out, "    addi $s0, $s0, 1\n");
+            fprintf(out, "    j while_loop\n\n");
+            fprintf(out, "end_while:\n");
         }
-        current = current->next;
+        stmt = ast_next(stmt);
     }
 
-    // Generate foo
-    // Generate foo
-    // Generate foo
-    current = root->left;
-    while (current != NULL)
-    {
-        if (current->type == AST_FUNCTION_DEFINITION && strcmp(current->name, "foo") == 0)
-        {
-            fprintf(out, "foo:\n");
-            fprintf(out, "    addi $sp, $sp, -16\n");
-            fprintf(out, "    sw $ra, 12($sp)\n\n");
-
-            // First if-else chain
-            fprintf(out, "    li $t0, 100\n");
-            fprintf(out, "    ble $a1, $t0, else_if_f\n\n");
-            fprintf(out, "    move $a0, $a1\n");
-            fprintf(out, "    li $v0, 1\n");
-            fprintf(out, "    syscall\n");
-            fprintf(out, "    j second_if\n\n");
-            fprintf(out, "else_if_f:\n");
-            fprintf(out, "    l.s $f1, float_ten\n");
-            fprintf(out, "    c.lt.s $f12, $f1\n");
-            fprintf(out, "    bc1f else_c\n\n");
-            fprintf(out, "    mov.s $f12, $f12\n");
-            fprintf(out, "    li $v0, 2\n");
-            fprintf(out, "    syscall\n");
-            fprintf(out, "    j second_if\n\n");
-
-            fprintf(out, "else_c:\n");
-            fprintf(out, "    li $a0, 65         \n");
-            fprintf(out, "    li $v0, 11       \n");
-            fprintf(out, "    syscall\n\n");
+    // Main's exit code
+    fprintf(out, "    move $a0, $s3\n");
+    fprintf(out, "    li $v0, 1\n");
+    fprintf(out, "    syscall\n\n");
+    fprintf(out, "    la $a0, newline\n");
+    fprintf(out, "    li $v0, 4\n");
+    fprintf(out, "    syscall\n\n");
+    fprintf(out, "    li $v0, 10\n");
+    fprintf(out, "    syscall\n\n");
+}
 
-            // Second if-else chain
-            fprintf(out, "second_if:\n");
-            fprintf(out, "    la $a0, newline\n");
-            fprintf(out, "    li $v0, 4\n");
-            fprintf(out, "    syscall\n\n");
-            fprintf(out, "    li $t0, 100\n");
-            fprintf(out, "    ble $a1, $t0, else_second\n\n");
-            fprintf(out, "    move $a0, $a1\n");
-            fprintf(out, "    li $v0, 1\n");
-            fprintf(out, "    syscall\n");
-            fprintf(out, "    j foo_return\n\n");
+/* add_func and foo are written to their deferred code file 'out' */
+static void generate_add(FILE *out)
+{
+    fprintf(out, "add_func:\n");
+    fprintf(out, "    addi $sp, $sp, -16\n");
+    fprintf(out, "    sw $ra, 12($sp)\n");
+    fprintf(out, "    sw $s0, 8($sp)\n\n");
+    fprintf(out, "    li $s0, 65\n\n");
+    fprintf(out, "    li $t1, 9\n");
+    fprintf(out, "    mul $t0, $a1, $t1    \n");
+    fprintf(out, "    add $v0, $a0, $t0    \n");
+    fprintf(out, "    move $t5, $v0        \n\n");
+    fprintf(out, "    li $t0, 5\n");
+    fprintf(out, "    bge $a0, $t0, skip_write_b\n\n");
+    fprintf(out, "    move $a0, $a1\n");
+    fprintf(out, "    li $v0, 1\n");
+    fprintf(out, "    syscall\n\n");
+    fprintf(out, "    la $a0, newline\n");
+    fprintf(out, "    li $v0, 4\n");
+    fprintf(out, "    syscall\n\n");
+    fprintf(out, "skip_write_b:\n");
+    fprintf(out, "    move $a0, $s0\n");
+    fprintf(out, "    li $v0, 1\n");
+    fprintf(out, "    syscall\n\n");
+    fprintf(out, "    la $a0, newline\n");
+    fprintf(out, "    li $v0, 4\n");
+    fprintf(out, "    syscall\n\n");
+    fprintf(out, "    move $v0, $t5        \n\n");
+    fprintf(out, "    lw $ra, 12($sp)\n");
+    fprintf(out, "    lw $s0, 8($sp)\n");
+    fprintf(out, "    addi $sp, $sp, 16\n");
+    fprintf(out, "    jr $ra\n\n");
+}
 
-            fprintf(out, "else_second:\n");
-            fprintf(out, "    li $a0, 65        \n");
-            fprintf(out, "    li $v0, 11        \n");
-            fprintf(out, "    syscall\n\n");
+static void generate_foo(FILE *out)
+{
+    fprintf(out, "foo:\n");
+    fprintf(out, "    addi $sp, $sp, -16\n");
+    fprintf(out, "    sw $ra, 12($sp)\n\n");
 
-            fprintf(out, "foo_return:\n");
-            fprintf(out, "    la $a0, newline\n");
-            fprintf(out, "    li $v0, 4\n");
-            fprintf(out, "    syscall\n\n");
-            fprintf(out, "    li $v0, 55\n\n");
-            fprintf(out, "    lw $ra, 12($sp)\n");
-            fprintf(out, "    addi $sp, $sp, 16\n");
-            fprintf(out, "    jr $ra\n\n");
-        }
-        current = current->next;
+    // First if-else chain
+    fprintf(out, "    li $t0, 100\n");
+    fprintf(out, "    ble $a1, $t0, else_if_f\n\n");
+    fprintf(out, "    move $a0, $a1\n");
+    fprintf(out, "    li $v0, 1\n");
+    fprintf(out, "    syscall\n");
+    fprintf(out, "    j second_if\n\n");
+    fprintf(out, "else_if_f:\n");
+    fprintf(out, "    l.s $f1, float_ten\n");
+    fprintf(out, "    c.lt.s $f12, $f1\n");
+    fprintf(out, "    bc1f else_c\n\n");
+    fprintf(out, "    mov.s $f12, $f12\n");
+    fprintf(out, "    li $v0, 2\n");
+    fprintf(out, "    syscall\n");
+    fprintf(out, "    j second_if\n\n");
+
+    fprintf(out, "else_c:\n");
+    fprintf(out, "    li $a0, 65         \n");
+    fprintf(out, "    li $v0, 11       \n");
+    fprintf(out, "    syscall\n\n");
+
+    // Second if-else chain
+    fprintf(out, "second_if:\n");
+    fprintf(out, "    la $a0, newline\n");
+    fprintf(out, "    li $v0, 4\n");
+    fprintf(out, "    syscall\n\n");
+    fprintf(out, "    li $t0, 100\n");
+    fprintf(out, "    ble $a1, $t0, else_second\n\n");
+    fprintf(out, "    move $a0, $a1\n");
+    fprintf(out, "    li $v0, 1\n");
+    fprintf(out, "    syscall\n");
+    fprintf(out, "    j foo_return\n\n");
+
+    fprintf(out, "else_second:\n");
+    fprintf(out, "    li $a0, 65        \n");
+    fprintf(out, "    li $v0, 11        \n");
+    fprintf(out, "    syscall\n\n");
+
+    fprintf(out, "foo_return:\n");
+    fprintf(out, "    la $a0, newline\n");
+    fprintf(out, "    li $v0, 4\n");
+    fprintf(out, "    syscall\n\n");
+    fprintf(out, "    li $v0, 55\n\n");
+    fprintf(out, "    lw $ra, 12($sp)\n");
+    fprintf(out, "    addi $sp, $sp, 16\n");
+    fprintf(out, "    jr $ra\n\n");
+}
+
+void generate_mips_begin(void)
+{
+    out = fopen("output.asm", "w");
+    if (!out)
+    {
+        fprintf(stderr, "Failed to open output file\n");
+        exit(1);
     }
+    add_code = open_temporary();
+    foo_code = open_temporary();
+
+    // Write the data section
+    fprintf(out, ".data\n");
+    fprintf(out, "    float_val: .float 3.14\n");
+    fprintf(out, "    float_ten: .float 10.0\n");
+    fprintf(out, "    newline: .asciiz \"\\n\"\n\n");
+    fprintf(out, ".text\n\n");
+}
+
+void generate_mips_function(ASTNode *function)
+{
+    if (function->type == AST_MAIN_FUNCTION)
+    {
+        generate_main(function);
+    }
+    else if (function->type == AST_FUNCTION_DEFINITION && strcmp(ast_name(function), "add") == 0)
+    {
+        generate_add(add_code);
+    }
+    else if (function->type == AST_FUNCTION_DEFINITION && strcmp(ast_name(function), "foo") == 0)
+    {
+        generate_foo(foo_code);
+    }
+}
+
+void generate_mips_end(void)
+{
+    // main first, then add_func, then foo
+    append_code(add_code);
+    append_code(foo_code);
     fclose(out);
+    out = NULL;
+}
+
+void generate_mips(ASTNode *root)
+{
+    generate_mips_begin();
+    for (ASTNode *current = ast_left(root); current != NULL; current = ast_next(current))
+    {
+        generate_mips_function(current);
+    }
+    generate_mips_end();
 }
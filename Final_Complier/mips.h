@@ -4,6 +4,12 @@
 #include "ast.h"
 
 void generate_mips(ASTNode* root);
+
+/* generate_mips() one function at a time, for streaming compilation:
+   begin, then each function in source order, then end */
+void generate_mips_begin(void);
+void generate_mips_function(ASTNode* function);
+void generate_mips_end(void);
 void generate_write(ASTNode* node);
 void generate_function_call(ASTNode* node);
 void generate_function_parameters(ASTNode* params);
@@ -0,0 +1,45 @@
+/* parse_context.h */
+
+#ifndef PARSE_CONTEXT_H
+#define PARSE_CONTEXT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ast.h"
+#include "lexer.h"
+#include "tokens.h"
+
+/*
+ * Everything one parse needs, passed to yyparse() and yylex() (the
+ * parser is pure). The symbol table, the atom table (intern.h) and the
+ * node array (ast.h) are not in it: they are per-thread globals. Several
+ * translation units can be parsed at once on different threads, but a
+ * thread compiles one at a time, from init_symbol_table() to
+ * ast_free_all() and intern_free_all().
+ */
+typedef struct ParseContext {
+    Lexer* lexer;                 /* Scanner over the input */
+    const TokenBuffer* replay;    /* Pre-lexed tokens fed instead of the scanner, or NULL */
+    size_t replay_pos;            /* Next token to replay */
+    int current_kind;             /* Last replayed token and its value, */
+    uint32_t current_value;       /* for error messages */
+    ASTNode* ast_root;            /* Root of the tree built by the parse */
+    int errors;                   /* Errors reported through yyerror_at() */
+
+    /* Streaming compilation: when set, each function (main included) is
+       handed to on_function as soon as it has been parsed, instead of
+       being added under ast_root. The callback owns the subtree. */
+    void (*on_function)(ASTNode* function, void* data);
+    void* on_function_data;
+} ParseContext;
+
+/* Set up 'ctx' to parse with 'lexer' */
+void parse_context_init(ParseContext* ctx, Lexer* lexer);
+
+/* Add a parsed function to 'functions', or pass it to ctx->on_function */
+void parse_context_add_function(ParseContext* ctx, ASTList* functions, ASTNode* function);
+
+/* Report a parse error located at byte 'offset' of the source (parser.y) */
+void yyerror_at(ParseContext* ctx, uint32_t offset, const char* s);
+
+#endif /* PARSE_CONTEXT_H */
@@ -4,34 +4,41 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
-#include <time.h>
 
 #include "symbol_table.h"
 #include "ast.h"
-#include "semantic.h"  // Uncomment when 'traverse_ast' is implemented
-#include "codegen.h"
-#include "mips.h"
-
-void compile(const char *filename);
+#include "resolve.h"
+#include "lexer.h"
+#include "source.h"
+#include "intern.h"
+#include "tokens.h"
+#include "parse_context.h"
 
-extern int yylex();
-extern int line_num;
-extern char* yytext;
+void yyerror(uint32_t* location, ParseContext* ctx, const char *s);
 
-void yyerror(const char *s);
+/* The actions build nodes in this thread's node array and declare into
+   its symbol table, not through 'ctx', so only one parse may run on a
+   thread at a time (see parse_context.h) */
 
-ASTNode* ast_root = NULL;
-SymbolTable* sym_table;
+/* Locations are byte offsets (see source.h); a rule is located at its
+   first symbol, or just after the previous one when it is empty */
+#define YYLLOC_DEFAULT(Current, Rhs, N) \
+    ((Current) = (N) ? YYRHSLOC(Rhs, 1) : YYRHSLOC(Rhs, 0))
 
 %}
 
 %define parse.error verbose
 %defines
+%locations
+%define api.location.type {uint32_t}
+%define api.pure full
+%param {ParseContext* ctx}
 
 %code requires {
+    #include <stdint.h>
     #include "ast.h"
     #include "symbol_table.h"
+    #include "parse_context.h"
 }
 
 %code top {
@@ -41,8 +48,9 @@ SymbolTable* sym_table;
 %union {
     int number;
     float float_number;
-    char* string;
+    const char* string;          /* Interned identifier */
     ASTNode* ast;
+    ASTList list;                 /* Sibling list being built (see ast.h) */
     Symbol* symbol;               
     ArraySizeNode* arr_sizes;
 }
@@ -63,12 +71,12 @@ SymbolTable* sym_table;
 %token LPAREN RPAREN LBRACE RBRACE LBRACKET RBRACKET COMMA
 %token WHILE 
 
-%type <ast> program function_definitions function_definition main_function function_body main_body declarations declaration statements statement 
-%type <ast> parameters
+%type <ast> program function_definition main_function function_body main_body declaration statement 
 %type <ast> parameter
-%type <ast> write_stmt assignment expression array_init initializer_list return_statement main_return_statement
-%type <ast> argument_list arguments
+%type <ast> write_stmt assignment expression array_init return_statement main_return_statement
 %type <ast> if_stmt else_part while_stmt
+%type <list> function_definitions parameters declarations statements initializer_list
+%type <list> argument_list arguments
 %type <arr_sizes> array_sizes
 
 %left OR
@@ -88,28 +96,33 @@ SymbolTable* sym_table;
 program
     : function_definitions main_function
         {
-            /* Create the root AST node */
+            /* Create the root AST node after main has been streamed out,
+               since that releases everything allocated since main began */
+            ASTList functions = $1;       /* function_definitions */
+            parse_context_add_function(ctx, &functions, $2);    /* main_function */
             $$ = create_ast_node(AST_PROGRAM);
-            if ($1) add_child($$, $1);    /* function_definitions */
-            if ($2) add_child($$, $2);    /* main_function */
-            ast_root = $$;
+            add_children($$, functions);
+            ctx->ast_root = $$;
         }
     ;
 
 main_function
-    : TYPE_INT MAIN LPAREN RPAREN LBRACE main_body RBRACE
+    : TYPE_INT MAIN
         {
-            /* Create the main function AST node */
-            $$ = create_ast_node(AST_MAIN_FUNCTION);
-
             /* Add 'main' to the symbol table */
-            add_symbol("main", DT_INT, SYMBOL_FUNCTION, DT_INT, NULL, NULL, 0);
+            add_symbol(intern_cstr("main"), DT_INT, SYMBOL_FUNCTION, DT_INT, NULL, NULL, 0);
 
             /* Enter new scope for main function body */
             enter_scope();
+        }
+      LPAREN RPAREN LBRACE main_body RBRACE
+        {
+            /* Create the main function AST node */
+            $$ = create_ast_node(AST_MAIN_FUNCTION);
+            $$->offset = @2;
 
             /* Attach main body */
-            if ($6) add_child($$, $6);    /* main_body */
+            if ($7) add_child($$, $7);    /* main_body */
 
             /* Exit scope after main function body */
             exit_scope();
@@ -120,42 +133,37 @@ main_function
 function_definitions
     : function_definitions function_definition
         {
-            /* Link the function_definition to the list */
-            if ($1) {
-                ASTNode* temp = $1;
-                while (temp->next) {
-                    temp = temp->next;
-                }
-                temp->next = $2;
-                $$ = $1;
-            } else {
-                $$ = $2;
-            }
+            /* Link the function_definition to the list (or compile it now) */
+            $$ = $1;
+            parse_context_add_function(ctx, &$$, $2);
         }
     | /* empty */
         {
-            $$ = NULL;
+            $$ = ast_list(NULL);
         }
     ;
 
 
 function_definition
-    : TYPE_INT ID LPAREN parameters RPAREN LBRACE function_body RBRACE
+    : TYPE_INT ID
         {
-            /* Create a function definition AST node */
-            $$ = create_ast_node(AST_FUNCTION_DEFINITION);
-            $$->name = strdup($2);
-            $$->data_type = DT_INT;
-
-            /* Add function to symbol table */
+            /* Add function to symbol table, so its body can call it */
             add_symbol($2, DT_INT, SYMBOL_FUNCTION, DT_INT, NULL, NULL, 0);
 
-            /* Enter new scope for function body */
+            /* Enter new scope for its parameters and body */
             enter_scope();
+        }
+      LPAREN parameters RPAREN LBRACE function_body RBRACE
+        {
+            /* Create a function definition AST node */
+            $$ = create_ast_node(AST_FUNCTION_DEFINITION);
+            ast_set_name($$, $2);
+            $$->offset = @2;
+            $$->data_type = DT_INT;
 
             /* Attach parameters and body */
-            if ($4) add_child($$, $4);    /* parameters */
-            if ($7) add_child($$, $7);    /* function_body */
+            add_children($$, $5);         /* parameters */
+            if ($8) add_child($$, $8);    /* function_body */
 
             /* Exit scope after function body */
             exit_scope();
@@ -168,25 +176,17 @@ parameters
     : parameters COMMA parameter
         {
             /* Link parameters */
-            if ($1) {
-                ASTNode* temp = $1;
-                while (temp->next) {
-                    temp = temp->next;
-                }
-                temp->next = $3;
-                $$ = $1;
-            } else {
-                $$ = $3;
-            }
+            $$ = $1;
+            add_sibling(&$$, $3);
         }
     | parameter
         {
             /* Single parameter */
-            $$ = $1;
+            $$ = ast_list($1);
         }
     | /* empty */
         {
-            $$ = NULL;
+            $$ = ast_list(NULL);
         }
     ;
 
@@ -196,12 +196,14 @@ parameter
         {
             /* Create a parameter declaration AST node */
             ASTNode* param_node = create_ast_node(AST_DECLARATION);
-            param_node->name = strdup($2);
+            ast_set_name(param_node, $2);
+            param_node->offset = @2;
             param_node->data_type = DT_INT;
             param_node->category = SYMBOL_VARIABLE;
 
             /* Add to symbol table */
             add_symbol($2, DT_INT, SYMBOL_VARIABLE, DT_VOID, NULL, NULL, 0);
+            resolve_name(param_node);
 
             $$ = param_node;
         }
@@ -209,12 +211,14 @@ parameter
         {
             /* Create a parameter declaration AST node */
             ASTNode* param_node = create_ast_node(AST_DECLARATION);
-            param_node->name = strdup($2);
+            ast_set_name(param_node, $2);
+            param_node->offset = @2;
             param_node->data_type = DT_FLOAT;
             param_node->category = SYMBOL_VARIABLE;
 
             /* Add to symbol table */
             add_symbol($2, DT_FLOAT, SYMBOL_VARIABLE, DT_VOID, NULL, NULL, 0);
+            resolve_name(param_node);
 
             $$ = param_node;
         }
@@ -222,12 +226,14 @@ parameter
         {
             /* Create a parameter declaration AST node */
             ASTNode* param_node = create_ast_node(AST_DECLARATION);
-            param_node->name = strdup($2);
+            ast_set_name(param_node, $2);
+            param_node->offset = @2;
             param_node->data_type = DT_CHAR;
             param_node->category = SYMBOL_VARIABLE;
 
             /* Add to symbol table */
             add_symbol($2, DT_CHAR, SYMBOL_VARIABLE, DT_VOID, NULL, NULL, 0);
+            resolve_name(param_node);
 
             $$ = param_node;
         }
@@ -239,8 +245,8 @@ function_body
         {
             /* Create a block AST node */
             $$ = create_ast_node(AST_BLOCK);
-            if ($1) add_child($$, $1);    /* declarations */
-            if ($2) add_child($$, $2);    /* statements */
+            add_children($$, $1);         /* declarations */
+            add_children($$, $2);         /* statements */
             if ($3) add_child($$, $3);    /* return_statement */
         }
     ;
@@ -251,8 +257,8 @@ main_body
         {
             /* Create a block AST node */
             $$ = create_ast_node(AST_BLOCK);
-            if ($1) add_child($$, $1);    /* declarations */
-            if ($2) add_child($$, $2);    /* statements */
+            add_children($$, $1);         /* declarations */
+            add_children($$, $2);         /* statements */
             if ($3) add_child($$, $3);    /* main_return_statement */
         }
     ;
@@ -263,6 +269,7 @@ return_statement
         {
             /* Create a return statement AST node */
             $$ = create_ast_node(AST_RETURN);
+            $$->offset = @1;
             if ($2) add_child($$, $2);    /* expression */
         }
     ;
@@ -273,9 +280,9 @@ main_return_statement
         {
             /* Create a return statement AST node with integer literal */
             $$ = create_ast_node(AST_RETURN);
-            ASTNode* num_node = create_ast_node(AST_EXPRESSION);
-            num_node->operator = strdup("NUMBER");
-            num_node->value = $2;
+            $$->offset = @1;
+            ASTNode* num_node = create_number_node($2);
+            num_node->offset = @2;
             add_child($$, num_node);
         }
     ;
@@ -285,20 +292,12 @@ declarations
     : declarations declaration
         {
             /* Link declarations */
-            if ($1) {
-                ASTNode* temp = $1;
-                while (temp->next) {
-                    temp = temp->next;
-                }
-                temp->next = $2;
-                $$ = $1;
-            } else {
-                $$ = $2;
-            }
+            $$ = $1;
+            add_sibling(&$$, $2);
         }
     | /* empty */
         {
-            $$ = NULL;
+            $$ = ast_list(NULL);
         }
     ;
 
@@ -308,23 +307,27 @@ declaration
         {
             /* Create a declaration node for array */
             $$ = create_ast_node(AST_DECLARATION);
-            $$->name = strdup($3);
+            ast_set_name($$, $3);
+            $$->offset = @3;
             $$->data_type = DT_INT;
             $$->category = SYMBOL_ARRAY;
-            $$->array_sizes = $4->sizes;
-            $$->dimensions = $4->dimensions;
+            ast_set_array_sizes($$, $4->sizes, $4->dimensions);
 
             /* Add array to symbol table */
             add_symbol($3, DT_ARRAY, SYMBOL_ARRAY, DT_VOID, NULL, $4->sizes, $4->dimensions);
 
             /* Attach array initialization */
             if ($6) add_child($$, $6);
+
+            /* Bind it, once its children are attached (see resolve.h) */
+            resolve_name($$);
         }
     | TYPE_INT ID ASSIGNOP expression SEMICOLON
         {
             /* Create a declaration node for int */
             $$ = create_ast_node(AST_DECLARATION);
-            $$->name = strdup($2);
+            ast_set_name($$, $2);
+            $$->offset = @2;
             $$->data_type = DT_INT;
             $$->category = SYMBOL_VARIABLE;
 
@@ -333,12 +336,16 @@ declaration
 
             /* Attach initialization expression */
             if ($4) add_child($$, $4);
+
+            /* Bind it, once its children are attached (see resolve.h) */
+            resolve_name($$);
         }
     | TYPE_FLOAT ID ASSIGNOP expression SEMICOLON
         {
             /* Create a declaration node for float */
             $$ = create_ast_node(AST_DECLARATION);
-            $$->name = strdup($2);
+            ast_set_name($$, $2);
+            $$->offset = @2;
             $$->data_type = DT_FLOAT;
             $$->category = SYMBOL_VARIABLE;
 
@@ -347,12 +354,16 @@ declaration
 
             /* Attach initialization expression */
             if ($4) add_child($$, $4);
+
+            /* Bind it, once its children are attached (see resolve.h) */
+            resolve_name($$);
         }
     | TYPE_CHAR ID ASSIGNOP expression SEMICOLON
         {
             /* Create a declaration node for char */
             $$ = create_ast_node(AST_DECLARATION);
-            $$->name = strdup($2);
+            ast_set_name($$, $2);
+            $$->offset = @2;
             $$->data_type = DT_CHAR;
             $$->category = SYMBOL_VARIABLE;
 
@@ -361,6 +372,9 @@ declaration
 
             /* Attach initialization expression */
             if ($4) add_child($$, $4);
+
+            /* Bind it, once its children are attached (see resolve.h) */
+            resolve_name($$);
         }
     ;
 
@@ -369,8 +383,8 @@ array_sizes
     : LBRACKET NUMBER RBRACKET
         {
             /* Initialize array sizes */
-            ArraySizeNode* node = (ArraySizeNode*)malloc(sizeof(ArraySizeNode));
-            node->sizes = (int*)malloc(sizeof(int));
+            ArraySizeNode* node = (ArraySizeNode*)ast_alloc(sizeof(ArraySizeNode));
+            node->sizes = (int*)ast_alloc(sizeof(int));
             node->sizes[0] = $2;
             node->dimensions = 1;
             $$ = node;
@@ -379,7 +393,8 @@ array_sizes
         {
             /* Extend array sizes */
             ArraySizeNode* node = $1;
-            node->sizes = (int*)realloc(node->sizes, sizeof(int) * (node->dimensions + 1));
+            node->sizes = (int*)ast_realloc(node->sizes, sizeof(int) * node->dimensions,
+                                            sizeof(int) * (node->dimensions + 1));
             node->sizes[node->dimensions] = $3;
             node->dimensions += 1;
             $$ = node;
@@ -392,7 +407,8 @@ array_init
         {
             /* Create an array initialization AST node */
             $$ = create_ast_node(AST_ARRAY_INIT);
-            if ($2) add_child($$, $2);
+            $$->offset = @1;
+            add_children($$, $2);
         }
     ;
 
@@ -401,21 +417,13 @@ initializer_list
     : initializer_list COMMA expression
         {
             /* Link initializers */
-            if ($1) {
-                ASTNode* temp = $1;
-                while (temp->next) {
-                    temp = temp->next;
-                }
-                temp->next = $3;
-                $$ = $1;
-            } else {
-                $$ = $3;
-            }
+            $$ = $1;
+            add_sibling(&$$, $3);
         }
     | expression
         {
             /* Single initializer */
-            $$ = $1;
+            $$ = ast_list($1);
         }
     ;
 
@@ -424,20 +432,12 @@ statements
     : statements statement
         {
             /* Link statements */
-            if ($1) {
-                ASTNode* temp = $1;
-                while (temp->next) {
-                    temp = temp->next;
-                }
-                temp->next = $2;
-                $$ = $1;
-            } else {
-                $$ = $2;
-            }
+            $$ = $1;
+            add_sibling(&$$, $2);
         }
     | /* empty */
         {
-            $$ = NULL;
+            $$ = ast_list(NULL);
         }
     ;
 
@@ -481,10 +481,11 @@ if_stmt
         {
             /* Create an if statement AST node */
             $$ = create_ast_node(AST_IF);
+            $$->offset = @1;
 
             /* Attach condition and then body */
-            if ($3) $$->condition = $3;
-            if ($6) $$->body = $6;
+            $$->u.condition = ast_index($3);
+            $$->right = ast_index($6.head);
 
             /* Attach else part */
             if ($8) {
@@ -499,12 +500,13 @@ else_part
         {
             /* Create an else part AST node */
             ASTNode* else_node = create_ast_node(AST_IF);    /* Reusing AST_IF type for else */
+            else_node->offset = @1;
 
             /* Enter new scope for else block */
             enter_scope();
 
             /* Attach else body */
-            if ($3) else_node->body = $3;
+            else_node->right = ast_index($3.head);
 
             /* Exit scope after else block */
             exit_scope();
@@ -528,10 +530,11 @@ while_stmt
         {
             /* Create a while statement AST node */
             $$ = create_ast_node(AST_WHILE);
+            $$->offset = @1;
 
             /* Attach condition and body */
-            if ($3) $$->condition = $3;
-            if ($6) $$->body = $6;
+            $$->u.condition = ast_index($3);
+            $$->right = ast_index($6.head);
         }
     ;
 
@@ -541,23 +544,29 @@ assignment
         {
             /* Create an assignment AST node */
             $$ = create_ast_node(AST_ASSIGNMENT);
-            $$->name = strdup($1);
+            ast_set_name($$, $1);
+            $$->offset = @1;
             if ($3) add_child($$, $3);    /* expression */
+            resolve_name($$);
         }
     | ID LBRACKET expression RBRACKET ASSIGNOP expression SEMICOLON
         {
             /* Create an array assignment AST node */
             $$ = create_ast_node(AST_ASSIGNMENT);
-            $$->name = strdup($1);
+            ast_set_name($$, $1);
+            $$->offset = @1;
 
             /* Create an array access node */
             ASTNode* array_access = create_ast_node(AST_ARRAY_ACCESS);
-            array_access->string = strdup($1);
+            ast_set_name(array_access, $1);
+            array_access->offset = @1;
             if ($3) add_child(array_access, $3);  /* index expression */
+            resolve_name(array_access);
 
             /* Attach array access and value expression */
             if ($6) add_child($$, $6);         /* value expression */
             add_child($$, array_access);       /* Attach array access */
+            resolve_name($$);
         }
     ;
 
@@ -568,11 +577,13 @@ write_stmt
             /* Create a write statement AST node */
             Symbol* sym = lookup_symbol($2);
             if (!sym) {
-                yyerror("Undeclared variable in write statement.");
+                yyerror_at(ctx, @2, "Undeclared variable in write statement.");
                 $$ = NULL;
             } else {
                 $$ = create_ast_node(AST_WRITE);
-                $$->name = strdup($2);
+                ast_set_name($$, $2);
+                $$->offset = @2;
+                $$->symbol = sym->id;
             }
         }
     | WRITE ID LBRACKET expression RBRACKET SEMICOLON
@@ -580,18 +591,22 @@ write_stmt
             /* Handle writing array element */
             Symbol* sym = lookup_symbol($2);
             if (!sym || sym->category != SYMBOL_ARRAY) {
-                yyerror("Undeclared array or wrong category in write statement.");
+                yyerror_at(ctx, @2, "Undeclared array or wrong category in write statement.");
                 $$ = NULL;
             } else {
                 $$ = create_ast_node(AST_WRITE);
-                $$->name = strdup($2);
+                ast_set_name($$, $2);
+                $$->offset = @2;
 
                 /* Create an array access node */
                 ASTNode* array_access = create_ast_node(AST_ARRAY_ACCESS);
-                array_access->string = strdup($2);
+                ast_set_name(array_access, $2);
+                array_access->offset = @2;
                 if ($4) add_child(array_access, $4); /* index expression */
+                array_access->symbol = sym->id;
 
                 add_child($$, array_access);
+                $$->symbol = sym->id;
             }
         }
     ;
@@ -601,79 +616,94 @@ expression
     : expression OP_ADD expression
         {
             /* Create an addition expression node */
-            $$ = create_expression_node("+", $1, $3);
+            $$ = create_binary_node(BINOP_ADD, $1, $3);
+            $$->offset = @2;
         }
     | expression OP_SUB expression
         {
             /* Create a subtraction expression node */
-            $$ = create_expression_node("-", $1, $3);
+            $$ = create_binary_node(BINOP_SUB, $1, $3);
+            $$->offset = @2;
         }
     | expression OP_MUL expression
         {
             /* Create a multiplication expression node */
-            $$ = create_expression_node("*", $1, $3);
+            $$ = create_binary_node(BINOP_MUL, $1, $3);
+            $$->offset = @2;
         }
     | expression OP_DIV expression
         {
             /* Create a division expression node */
-            $$ = create_expression_node("/", $1, $3);
+            $$ = create_binary_node(BINOP_DIV, $1, $3);
+            $$->offset = @2;
         }
     | expression OR expression
         {
             /* Create a logical OR expression node */
-            $$ = create_expression_node("||", $1, $3);
+            $$ = create_binary_node(BINOP_OR, $1, $3);
+            $$->offset = @2;
         }
     | expression AND expression
         {
             /* Create a logical AND expression node */
-            $$ = create_expression_node("&&", $1, $3);
+            $$ = create_binary_node(BINOP_AND, $1, $3);
+            $$->offset = @2;
         }
     | expression EQ expression
         {
             /* Create an equality expression node */
-            $$ = create_expression_node("==", $1, $3);
+            $$ = create_binary_node(BINOP_EQ, $1, $3);
+            $$->offset = @2;
         }
     | expression NE expression
         {
             /* Create an inequality expression node */
-            $$ = create_expression_node("!=", $1, $3);
+            $$ = create_binary_node(BINOP_NE, $1, $3);
+            $$->offset = @2;
         }
     | expression GE expression
         {
             /* Create a greater or equal expression node */
-            $$ = create_expression_node(">=", $1, $3);
+            $$ = create_binary_node(BINOP_GE, $1, $3);
+            $$->offset = @2;
         }
     | expression LE expression
         {
             /* Create a less or equal expression node */
-            $$ = create_expression_node("<=", $1, $3);
+            $$ = create_binary_node(BINOP_LE, $1, $3);
+            $$->offset = @2;
         }
     | expression GT expression
         {
             /* Create a greater than expression node */
-            $$ = create_expression_node(">", $1, $3);
+            $$ = create_binary_node(BINOP_GT, $1, $3);
+            $$->offset = @2;
         }
     | expression LT expression
         {
             /* Create a less than expression node */
-            $$ = create_expression_node("<", $1, $3);
+            $$ = create_binary_node(BINOP_LT, $1, $3);
+            $$->offset = @2;
         }
     | NOT expression
         {
             /* Create a logical NOT expression node */
-            $$ = create_expression_node("!", $2, NULL);
+            $$ = create_not_node($2);
+            $$->offset = @1;
         }
     | ID LPAREN argument_list RPAREN
         {
             /* Handle function call */
             Symbol* sym = lookup_symbol($1);
             if (!sym || sym->category != SYMBOL_FUNCTION) {
-                yyerror("Undeclared function.");
+                yyerror_at(ctx, @1, "Undeclared function.");
                 $$ = NULL;
             } else {
                 $$ = create_ast_node(AST_FUNCTION_CALL);
-                $$->string = strdup($1);    /* Function name */
-                if ($3) $$->arguments = $3; /* Arguments */
+                $$->offset = @1;
+                ast_set_name($$, $1);    /* Function name */
+                $$->symbol = sym->id;
+                $$->right = ast_index($3.head);    /* Arguments */
             }
         }
     | ID LBRACKET expression RBRACKET
@@ -681,12 +711,14 @@ expression
             /* Handle array access */
             Symbol* sym = lookup_symbol($1);
             if (!sym || sym->category != SYMBOL_ARRAY) {
-                yyerror("Undeclared array or wrong category in expression.");
+                yyerror_at(ctx, @1, "Undeclared array or wrong category in expression.");
                 $$ = NULL;
             } else {
                 $$ = create_ast_node(AST_ARRAY_ACCESS);
-                $$->string = strdup($1);    /* Array name */
+                $$->offset = @1;
+                ast_set_name($$, $1);    /* Array name */
                 if ($3) add_child($$, $3);   /* Index expression */
+                $$->symbol = sym->id;
             }
         }
     | ID
@@ -694,27 +726,25 @@ expression
             /* Handle variable */
             Symbol* sym = lookup_symbol($1);
             if (!sym) {
-                yyerror("Undeclared variable in expression.");
+                yyerror_at(ctx, @1, "Undeclared variable in expression.");
                 $$ = NULL;
             } else {
-                $$ = create_ast_node(AST_EXPRESSION);
-                $$->operator = strdup("ID");
-                $$->string = strdup($1);
+                $$ = create_id_node($1);
+                $$->offset = @1;
+                $$->symbol = sym->id;
             }
         }
     | NUMBER
         {
             /* Handle integer literal */
-            $$ = create_ast_node(AST_EXPRESSION);
-            $$->operator = strdup("NUMBER");
-            $$->value = $1;
+            $$ = create_number_node($1);
+            $$->offset = @1;
         }
     | FLOAT_NUMBER
         {
             /* Handle float literal */
-            $$ = create_ast_node(AST_EXPRESSION);
-            $$->operator = strdup("FLOAT_NUMBER");
-            $$->float_value = $1;
+            $$ = create_float_node($1);
+            $$->offset = @1;
         }
     | LPAREN expression RPAREN
         {
@@ -731,7 +761,7 @@ argument_list
         }
     | /* empty */
         {
-            $$ = NULL;
+            $$ = ast_list(NULL);
         }
     ;
 
@@ -740,21 +770,13 @@ arguments
     : arguments COMMA expression
         {
             /* Link arguments */
-            if ($1) {
-                ASTNode* temp = $1;
-                while (temp->next) {
-                    temp = temp->next;
-                }
-                temp->next = $3;
-                $$ = $1;
-            } else {
-                $$ = $3;
-            }
+            $$ = $1;
+            add_sibling(&$$, $3);
         }
     | expression
         {
             /* Single argument */
-            $$ = $1;
+            $$ = ast_list($1);
         }
     ;
 
@@ -762,91 +784,16 @@ arguments
 
 /* C Code Section */
 
-void yyerror(const char *s) {
-    fprintf(stderr, "Parse error at line %d: %s. Token: '%s'\n", line_num, s, yytext);
-}
-
-void compile(const char *filename) {
-    printf("Compiling file: %s\n", filename);
-    
-    /* Initialize the symbol table */
-    init_symbol_table();
-
-    /* Start parsing */
-    if (yyparse() == 0) {
-        printf("Parsing completed successfully.\n");
-
-        /* Perform semantic analysis */
-        traverse_ast(ast_root);
-        printf("Semantic analysis completed successfully.\n");
-
-        /* Printing the Symbol Table */
-        print_symbol_table();
-
-        /* Print the AST for debugging */
-        print_ast(ast_root, 0);
-
-        /* Generate TAC */
-        printf("Generating TAC...\n");
-        generate_tac(ast_root);
-        printf("TAC generation completed.\n");
-
-        /* Generate MIPS assembly directly from AST */
-        printf("Generating MIPS assembly...\n");
-        generate_mips(ast_root);
-        printf("MIPS assembly generation completed.\n");
-
-        /* Free resources */
-        free_all_symbol_tables();
-        free_ast(ast_root);
-    } else {
-        fprintf(stderr, "Parsing failed. Please check your input.\n");
-    }
+void yyerror(uint32_t* location, ParseContext* ctx, const char *s) {
+    yyerror_at(ctx, *location, s);
 }
-int main(int argc, char** argv) {
-    /* Record start time */
-    clock_t start_time = clock();
-
-    /* Initialize the symbol table */
-    init_symbol_table();
-
-    /* Start parsing */
-    if (yyparse() == 0) {
-        printf("Parsing completed successfully.\n");
-
-        printf("About to print symbol table...\n");
-        print_symbol_table();
-        printf("Symbol table printing completed.\n");
-
-        /* Perform semantic analysis */
-        traverse_ast(ast_root);
-        printf("Semantic analysis completed successfully.\n");
-
-
-        /* Print the AST for debugging */
-        print_ast(ast_root, 0);
-
-        /* Generate TAC */
-        printf("Generating TAC...\n");
-        generate_tac(ast_root);
-        printf("TAC generation completed.\n");
-
-        /* Generate MIPS assembly directly from AST */
-        printf("Generating MIPS assembly...\n");
-        generate_mips(ast_root);
-        printf("MIPS assembly generation completed.\n");
-
-        /* Free resources */
-        free_all_symbol_tables();
-        free_ast(ast_root);
-    } else {
-        fprintf(stderr, "Parsing failed. Please check your input.\n");
-    }
-
-    /* Record end time */
-    clock_t end_time = clock();
-    double elapsed_time = (double)(end_time - start_time) / CLOCKS_PER_SEC;
-    printf("Compilation time: %.4f seconds\n", elapsed_time);
 
-    return 0;
+/* Report a parse error located at byte 'offset' of the source */
+void yyerror_at(ParseContext* ctx, uint32_t offset, const char *s) {
+    int line, column, length;
+    source_locate(offset, &line, &column);
+    const char* text = tokens_current_text(ctx, &length);
+    fprintf(stderr, "Parse error at line %d, column %d: %s. Token: '%.*s'\n",
+            line, column, s, length, text);
+    ctx->errors++;
 }
@@ -0,0 +1,725 @@
+/* rd_parser.c - recursive-descent parser, precedence climbing for expressions
+ *
+ * Each parse_* function below corresponds to a nonterminal of parser.y
+ * and runs that rule's action once the whole rule has been read, so
+ * symbol table side effects happen in the same order as with bison.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rd_parser.h"
+#include "parser.tab.h"
+#include "symbol_table.h"
+#include "ast.h"
+#include "resolve.h"
+#include "intern.h"
+#include "tokens.h"
+
+typedef struct Parser {
+    ParseContext* ctx;
+    int token;               /* Lookahead token (0 at end of input), once read */
+    YYSTYPE value;           /* Its semantic value */
+    uint32_t offset;         /* Its location */
+    int pending;             /* The lookahead has not been read yet */
+    int errors;              /* Syntax errors reported so far */
+    int recovering;          /* Set after a syntax error until the parser resynchronizes */
+} Parser;
+
+/* What peek() returns while recovering from an error. It matches no
+   rule, so nothing more is consumed until synchronize(). */
+#define NO_TOKEN (-1)
+
+/* Binding power of the binary operators, from the %left lines of
+   parser.y; 0 means the token is not a binary operator */
+static int binary_precedence(int token) {
+    switch (token) {
+        case OR: return 1;
+        case AND: return 2;
+        case EQ: case NE: return 3;
+        case GE: case LE: case GT: case LT: return 4;
+        case OP_ADD: case OP_SUB: return 5;
+        case OP_MUL: case OP_DIV: return 6;
+        default: return 0;
+    }
+}
+
+/* Operator stored in the expression node */
+static BinOp binary_operator(int token) {
+    switch (token) {
+        case OR: return BINOP_OR;
+        case AND: return BINOP_AND;
+        case EQ: return BINOP_EQ;
+        case NE: return BINOP_NE;
+        case GE: return BINOP_GE;
+        case LE: return BINOP_LE;
+        case GT: return BINOP_GT;
+        case LT: return BINOP_LT;
+        case OP_ADD: return BINOP_ADD;
+        case OP_SUB: return BINOP_SUB;
+        case OP_MUL: return BINOP_MUL;
+        default: return BINOP_DIV;
+    }
+}
+
+/* The lookahead token. It is read only when first needed, so a rule's
+   action runs before the token after the rule is scanned, as with
+   bison's default reductions. */
+static int peek(Parser* p) {
+    if (p->pending) {
+        p->token = yylex(&p->value, &p->offset, p->ctx);
+        p->pending = 0;
+    }
+    return p->recovering ? NO_TOKEN : p->token;
+}
+
+/* Consume the lookahead token (which must have been peeked at) */
+static void advance(Parser* p) {
+    p->pending = 1;
+}
+
+/* Report a syntax error at the lookahead, unless one is already being
+   recovered from. 'expecting' may be NULL when there are many choices. */
+static void syntax_error(Parser* p, const char* expecting) {
+    if (p->recovering) return;
+    peek(p);
+    char message[160];
+    if (expecting) {
+        snprintf(message, sizeof(message), "syntax error, unexpected %s, expecting %s",
+                 token_kind_name(p->token), expecting);
+    } else {
+        snprintf(message, sizeof(message), "syntax error, unexpected %s", token_kind_name(p->token));
+    }
+    yyerror_at(p->ctx, p->offset, message);
+    p->errors++;
+    p->recovering = 1;
+}
+
+/* Consume the lookahead if it is 'token', otherwise report an error */
+static int expect(Parser* p, int token) {
+    if (peek(p) == token) {
+        advance(p);
+        return 1;
+    }
+    syntax_error(p, token_kind_name(token));
+    return 0;
+}
+
+/* Consume an identifier, returning its name and location; NULL on error */
+static const char* expect_id(Parser* p, uint32_t* offset) {
+    if (peek(p) != ID) {
+        syntax_error(p, "ID");
+        *offset = p->offset;
+        return NULL;
+    }
+    const char* name = p->value.string;
+    *offset = p->offset;
+    advance(p);
+    return name;
+}
+
+/* Consume an integer literal, returning its value; 0 on error */
+static int expect_number(Parser* p) {
+    if (peek(p) != NUMBER) {
+        syntax_error(p, "NUMBER");
+        return 0;
+    }
+    int value = p->value.number;
+    advance(p);
+    return value;
+}
+
+/* Skip the rest of a bad statement: up to and including its ';' or the
+   '}' of a block it opened, or up to the '}' closing the enclosing block */
+static void synchronize(Parser* p) {
+    p->recovering = 0;
+    int depth = 0;
+    for (;;) {
+        int token = peek(p);
+        if (token == 0) break;
+        if (token == RBRACE) {
+            if (depth == 0) break;
+            advance(p);
+            if (--depth == 0) break;
+            continue;
+        }
+        advance(p);
+        if (token == LBRACE) depth++;
+        if (token == SEMICOLON && depth == 0) break;
+    }
+}
+
+/* Data type named by a type keyword, or DT_VOID for any other token */
+static DataType type_keyword(int token) {
+    switch (token) {
+        case TYPE_INT: return DT_INT;
+        case TYPE_FLOAT: return DT_FLOAT;
+        case TYPE_CHAR: return DT_CHAR;
+        default: return DT_VOID;
+    }
+}
+
+static int starts_declaration(int token) {
+    return token == ARRAY || type_keyword(token) != DT_VOID;
+}
+
+static int starts_statement(int token) {
+    switch (token) {
+        case ID: case WRITE: case IF: case WHILE:
+        case NUMBER: case FLOAT_NUMBER: case LPAREN: case NOT:
+            return 1;
+        default:
+            return starts_declaration(token);
+    }
+}
+
+static ASTNode* parse_expression(Parser* p, int min_precedence);
+static ASTList parse_statements(Parser* p);
+
+/* Expressions */
+
+/* name '(' argument_list ')' or a plain variable, after 'name' */
+static ASTNode* parse_identifier(Parser* p, const char* name, uint32_t offset) {
+    if (peek(p) == LPAREN) {
+        advance(p);
+        ASTList arguments = ast_list(NULL);
+        if (peek(p) != RPAREN) {
+            add_sibling(&arguments, parse_expression(p, 1));
+            while (peek(p) == COMMA) {
+                advance(p);
+                add_sibling(&arguments, parse_expression(p, 1));
+            }
+        }
+        expect(p, RPAREN);
+
+        /* Handle function call */
+        Symbol* sym = lookup_symbol(name);
+        if (!sym || sym->category != SYMBOL_FUNCTION) {
+            yyerror_at(p->ctx, offset, "Undeclared function.");
+            return NULL;
+        }
+        ASTNode* node = create_ast_node(AST_FUNCTION_CALL);
+        node->offset = offset;
+        ast_set_name(node, name);
+        node->symbol = sym->id;
+        node->right = ast_index(arguments.head);
+        return node;
+    }
+
+    /* Handle variable */
+    Symbol* sym = lookup_symbol(name);
+    if (!sym) {
+        yyerror_at(p->ctx, offset, "Undeclared variable in expression.");
+        return NULL;
+    }
+    ASTNode* node = create_id_node(name);
+    node->offset = offset;
+    node->symbol = sym->id;
+    return node;
+}
+
+/* '[' expression ']' after an array name */
+static ASTNode* parse_index(Parser* p) {
+    advance(p);
+    ASTNode* index = parse_expression(p, 1);
+    expect(p, RBRACKET);
+    return index;
+}
+
+/* name '[' index ']' used as a value */
+static ASTNode* array_access(Parser* p, const char* name, uint32_t offset, ASTNode* index) {
+    Symbol* sym = lookup_symbol(name);
+    if (!sym || sym->category != SYMBOL_ARRAY) {
+        yyerror_at(p->ctx, offset, "Undeclared array or wrong category in expression.");
+        return NULL;
+    }
+    ASTNode* node = create_ast_node(AST_ARRAY_ACCESS);
+    node->offset = offset;
+    ast_set_name(node, name);
+    if (index) add_child(node, index);
+    node->symbol = sym->id;
+    return node;
+}
+
+/* Operand of a binary operator: a primary expression or NOT applied to one.
+   NOT binds tighter than every binary operator (%right NOT). */
+static ASTNode* parse_unary(Parser* p) {
+    int token = peek(p);
+    uint32_t offset = p->offset;
+    switch (token) {
+        case NOT: {
+            advance(p);
+            ASTNode* node = create_not_node(parse_unary(p));
+            node->offset = offset;
+            return node;
+        }
+        case ID: {
+            const char* name = p->value.string;
+            advance(p);
+            if (peek(p) == LBRACKET) {
+                return array_access(p, name, offset, parse_index(p));
+            }
+            return parse_identifier(p, name, offset);
+        }
+        case NUMBER: {
+            ASTNode* node = create_number_node(p->value.number);
+            node->offset = offset;
+            advance(p);
+            return node;
+        }
+        case FLOAT_NUMBER: {
+            ASTNode* node = create_float_node(p->value.float_number);
+            node->offset = offset;
+            advance(p);
+            return node;
+        }
+        case LPAREN: {
+            advance(p);
+            ASTNode* node = parse_expression(p, 1);
+            expect(p, RPAREN);
+            return node;
+        }
+        default:
+            syntax_error(p, NULL);
+            return NULL;
+    }
+}
+
+/* Extend 'left' with binary operators binding at least 'min_precedence'.
+   All of them are left-associative, so the right operand only takes
+   operators that bind strictly tighter. */
+static ASTNode* parse_binary(Parser* p, ASTNode* left, int min_precedence) {
+    int op;
+    while (binary_precedence(op = peek(p)) >= min_precedence && binary_precedence(op) > 0) {
+        uint32_t offset = p->offset;
+        advance(p);
+        ASTNode* right = parse_expression(p, binary_precedence(op) + 1);
+        left = create_binary_node(binary_operator(op), left, right);
+        left->offset = offset;
+    }
+    return left;
+}
+
+static ASTNode* parse_expression(Parser* p, int min_precedence) {
+    return parse_binary(p, parse_unary(p), min_precedence);
+}
+
+/* Declarations */
+
+/* ARRAY TYPE_INT ID array_sizes ASSIGNOP array_init SEMICOLON */
+static ASTNode* parse_array_declaration(Parser* p) {
+    advance(p);
+    expect(p, TYPE_INT);
+    uint32_t offset;
+    const char* name = expect_id(p, &offset);
+
+    int* sizes = NULL;
+    int dimensions = 0;
+    do {
+        expect(p, LBRACKET);
+        int size = expect_number(p);
+        expect(p, RBRACKET);
+        sizes = (int*)ast_realloc(sizes, sizeof(int) * dimensions, sizeof(int) * (dimensions + 1));
+        sizes[dimensions++] = size;
+    } while (peek(p) == LBRACKET);
+    expect(p, ASSIGNOP);
+
+    /* array_init: LBRACE initializer_list RBRACE */
+    peek(p);
+    uint32_t init_offset = p->offset;
+    expect(p, LBRACE);
+    ASTList initializers = ast_list(parse_expression(p, 1));
+    while (peek(p) == COMMA) {
+        advance(p);
+        add_sibling(&initializers, parse_expression(p, 1));
+    }
+    expect(p, RBRACE);
+    ASTNode* init = create_ast_node(AST_ARRAY_INIT);
+    init->offset = init_offset;
+    add_children(init, initializers);
+    expect(p, SEMICOLON);
+
+    ASTNode* node = create_ast_node(AST_DECLARATION);
+    ast_set_name(node, name);
+    node->offset = offset;
+    node->data_type = DT_INT;
+    node->category = SYMBOL_ARRAY;
+    ast_set_array_sizes(node, sizes, dimensions);
+    add_symbol(name, DT_ARRAY, SYMBOL_ARRAY, DT_VOID, NULL, sizes, dimensions);
+    add_child(node, init);
+    resolve_name(node);
+    return node;
+}
+
+static ASTNode* parse_declaration(Parser* p) {
+    if (peek(p) == ARRAY) return parse_array_declaration(p);
+
+    /* TYPE_INT | TYPE_FLOAT | TYPE_CHAR  ID ASSIGNOP expression SEMICOLON */
+    DataType type = type_keyword(peek(p));
+    advance(p);
+    uint32_t offset;
+    const char* name = expect_id(p, &offset);
+    expect(p, ASSIGNOP);
+    ASTNode* init = parse_expression(p, 1);
+    expect(p, SEMICOLON);
+
+    ASTNode* node = create_ast_node(AST_DECLARATION);
+    ast_set_name(node, name);
+    node->offset = offset;
+    node->data_type = type;
+    node->category = SYMBOL_VARIABLE;
+    add_symbol(name, type, SYMBOL_VARIABLE, DT_VOID, NULL, NULL, 0);
+    if (init) add_child(node, init);
+    resolve_name(node);
+    return node;
+}
+
+static ASTList parse_declarations(Parser* p) {
+    ASTList declarations = ast_list(NULL);
+    while (starts_declaration(peek(p))) {
+        add_sibling(&declarations, parse_declaration(p));
+        if (p->recovering) synchronize(p);
+    }
+    return declarations;
+}
+
+/* Statements */
+
+/* Statement starting with an identifier: an assignment, an array element
+   assignment or an expression statement */
+static ASTNode* parse_identifier_statement(Parser* p) {
+    const char* name = p->value.string;
+    uint32_t offset = p->offset;
+    advance(p);
+
+    ASTNode* left;
+    if (peek(p) == ASSIGNOP) {
+        advance(p);
+        ASTNode* value = parse_expression(p, 1);
+        expect(p, SEMICOLON);
+        ASTNode* node = create_ast_node(AST_ASSIGNMENT);
+        ast_set_name(node, name);
+        node->offset = offset;
+        if (value) add_child(node, value);
+        resolve_name(node);
+        return node;
+    } else if (peek(p) == LBRACKET) {
+        ASTNode* index = parse_index(p);
+        if (peek(p) != ASSIGNOP) {
+            left = array_access(p, name, offset, index);
+        } else {
+            advance(p);
+            ASTNode* value = parse_expression(p, 1);
+            expect(p, SEMICOLON);
+            ASTNode* node = create_ast_node(AST_ASSIGNMENT);
+            ast_set_name(node, name);
+            node->offset = offset;
+            ASTNode* access = create_ast_node(AST_ARRAY_ACCESS);
+            ast_set_name(access, name);
+            access->offset = offset;
+            if (index) add_child(access, index);
+            if (value) add_child(node, value);
+            add_child(node, access);
+            resolve_name(access);
+            resolve_name(node);
+            return node;
+        }
+    } else {
+        left = parse_identifier(p, name, offset);
+    }
+
+    /* Expression as a statement */
+    left = parse_binary(p, left, 1);
+    expect(p, SEMICOLON);
+    return left;
+}
+
+/* WRITE ID SEMICOLON | WRITE ID LBRACKET expression RBRACKET SEMICOLON */
+static ASTNode* parse_write(Parser* p) {
+    advance(p);
+    uint32_t offset;
+    const char* name = expect_id(p, &offset);
+
+    if (peek(p) != LBRACKET) {
+        expect(p, SEMICOLON);
+        Symbol* sym = lookup_symbol(name);
+        if (!sym) {
+            yyerror_at(p->ctx, offset, "Undeclared variable in write statement.");
+            return NULL;
+        }
+        ASTNode* node = create_ast_node(AST_WRITE);
+        ast_set_name(node, name);
+        node->offset = offset;
+        node->symbol = sym->id;
+        return node;
+    }
+
+    ASTNode* index = parse_index(p);
+    expect(p, SEMICOLON);
+    Symbol* sym = lookup_symbol(name);
+    if (!sym || sym->category != SYMBOL_ARRAY) {
+        yyerror_at(p->ctx, offset, "Undeclared array or wrong category in write statement.");
+        return NULL;
+    }
+    ASTNode* node = create_ast_node(AST_WRITE);
+    ast_set_name(node, name);
+    node->offset = offset;
+    ASTNode* access = create_ast_node(AST_ARRAY_ACCESS);
+    ast_set_name(access, name);
+    access->offset = offset;
+    if (index) add_child(access, index);
+    add_child(node, access);
+    access->symbol = node->symbol = sym->id;
+    return node;
+}
+
+/* '(' expression ')' of if and while */
+static ASTNode* parse_condition(Parser* p) {
+    expect(p, LPAREN);
+    ASTNode* condition = parse_expression(p, 1);
+    expect(p, RPAREN);
+    return condition;
+}
+
+/* '{' statements '}' of if, else and while */
+static ASTList parse_block_statements(Parser* p) {
+    expect(p, LBRACE);
+    ASTList statements = parse_statements(p);
+    expect(p, RBRACE);
+    return statements;
+}
+
+/* IF LPAREN expression RPAREN LBRACE statements RBRACE else_part */
+static ASTNode* parse_if(Parser* p) {
+    uint32_t offset = p->offset;
+    advance(p);
+    ASTNode* condition = parse_condition(p);
+    ASTList body = parse_block_statements(p);
+
+    ASTNode* else_part = NULL;
+    if (peek(p) == ELSE) {
+        uint32_t else_offset = p->offset;
+        advance(p);
+        if (peek(p) == IF) {
+            /* Handle 'else if' by linking to another if statement */
+            else_part = parse_if(p);
+        } else {
+            ASTList else_body = parse_block_statements(p);
+            else_part = create_ast_node(AST_IF);    /* Reusing AST_IF type for else */
+            else_part->offset = else_offset;
+            enter_scope();
+            else_part->right = ast_index(else_body.head);
+            exit_scope();
+        }
+    }
+
+    ASTNode* node = create_ast_node(AST_IF);
+    node->offset = offset;
+    node->u.condition = ast_index(condition);
+    node->right = ast_index(body.head);
+    if (else_part) add_child(node, else_part);
+    return node;
+}
+
+/* WHILE LPAREN expression RPAREN LBRACE statements RBRACE */
+static ASTNode* parse_while(Parser* p) {
+    uint32_t offset = p->offset;
+    advance(p);
+    ASTNode* condition = parse_condition(p);
+    ASTList body = parse_block_statements(p);
+
+    ASTNode* node = create_ast_node(AST_WHILE);
+    node->offset = offset;
+    node->u.condition = ast_index(condition);
+    node->right = ast_index(body.head);
+    return node;
+}
+
+static ASTNode* parse_statement(Parser* p) {
+    switch (peek(p)) {
+        case ID: return parse_identifier_statement(p);
+        case WRITE: return parse_write(p);
+        case IF: return parse_if(p);
+        case WHILE: return parse_while(p);
+        default:
+            break;
+    }
+    if (starts_declaration(peek(p))) return parse_declaration(p);
+
+    /* Expression as a statement */
+    ASTNode* node = parse_expression(p, 1);
+    expect(p, SEMICOLON);
+    return node;
+}
+
+static ASTList parse_statements(Parser* p) {
+    ASTList statements = ast_list(NULL);
+    while (starts_statement(peek(p))) {
+        add_sibling(&statements, parse_statement(p));
+        if (p->recovering) synchronize(p);
+    }
+    return statements;
+}
+
+/* Functions */
+
+/* Body of a function or of main, ending in its return statement */
+static ASTNode* parse_body(Parser* p, int is_main) {
+    ASTList declarations = parse_declarations(p);
+    ASTList statements = parse_statements(p);
+
+    int token = peek(p);
+    uint32_t return_offset = p->offset;
+    if (token != RETURN) {
+        syntax_error(p, NULL);
+    } else {
+        advance(p);
+    }
+    ASTNode* value;
+    if (is_main) {
+        /* main_return_statement: RETURN NUMBER SEMICOLON */
+        peek(p);
+        uint32_t value_offset = p->offset;
+        value = create_number_node(expect_number(p));
+        value->offset = value_offset;
+    } else {
+        value = parse_expression(p, 1);
+    }
+    expect(p, SEMICOLON);
+    ASTNode* ret = create_ast_node(AST_RETURN);
+    ret->offset = return_offset;
+    if (value) add_child(ret, value);
+
+    ASTNode* block = create_ast_node(AST_BLOCK);
+    add_children(block, declarations);
+    add_children(block, statements);
+    add_child(block, ret);
+    return block;
+}
+
+/* TYPE_INT ID | TYPE_FLOAT ID | TYPE_CHAR ID */
+static ASTNode* parse_parameter(Parser* p) {
+    DataType type = type_keyword(peek(p));
+    if (type == DT_VOID) {
+        syntax_error(p, "TYPE_INT or TYPE_FLOAT or TYPE_CHAR");
+        return NULL;
+    }
+    advance(p);
+    uint32_t offset;
+    const char* name = expect_id(p, &offset);
+    if (!name) return NULL;
+
+    ASTNode* param_node = create_ast_node(AST_DECLARATION);
+    ast_set_name(param_node, name);
+    param_node->offset = offset;
+    param_node->data_type = type;
+    param_node->category = SYMBOL_VARIABLE;
+    add_symbol(name, type, SYMBOL_VARIABLE, DT_VOID, NULL, NULL, 0);
+    resolve_name(param_node);
+    return param_node;
+}
+
+/* ID LPAREN parameters RPAREN LBRACE function_body RBRACE, after TYPE_INT */
+static ASTNode* parse_function_definition(Parser* p) {
+    const char* name = p->value.string;
+    uint32_t offset = p->offset;
+    advance(p);
+
+    /* Declared before its parameters and body, which are in a scope of
+       their own, so the body can call it */
+    add_symbol(name, DT_INT, SYMBOL_FUNCTION, DT_INT, NULL, NULL, 0);
+    enter_scope();
+    expect(p, LPAREN);
+    ASTList parameters = ast_list(NULL);
+    if (peek(p) != RPAREN) {
+        if (type_keyword(peek(p)) == DT_VOID) {
+            syntax_error(p, "TYPE_INT or TYPE_FLOAT or TYPE_CHAR or RPAREN");
+        }
+        add_sibling(&parameters, parse_parameter(p));
+        while (peek(p) == COMMA) {
+            advance(p);
+            add_sibling(&parameters, parse_parameter(p));
+        }
+    }
+    expect(p, RPAREN);
+    expect(p, LBRACE);
+    ASTNode* body = parse_body(p, 0);
+    expect(p, RBRACE);
+
+    ASTNode* node = create_ast_node(AST_FUNCTION_DEFINITION);
+    ast_set_name(node, name);
+    node->offset = offset;
+    node->data_type = DT_INT;
+    add_children(node, parameters);
+    add_child(node, body);
+    exit_scope();
+    return node;
+}
+
+/* MAIN LPAREN RPAREN LBRACE main_body RBRACE, after TYPE_INT */
+static ASTNode* parse_main_function(Parser* p) {
+    uint32_t offset = p->offset;
+    advance(p);
+    add_symbol(intern_cstr("main"), DT_INT, SYMBOL_FUNCTION, DT_INT, NULL, NULL, 0);
+    enter_scope();
+    expect(p, LPAREN);
+    expect(p, RPAREN);
+    expect(p, LBRACE);
+    ASTNode* body = parse_body(p, 1);
+    expect(p, RBRACE);
+
+    ASTNode* node = create_ast_node(AST_MAIN_FUNCTION);
+    node->offset = offset;
+    add_child(node, body);
+    exit_scope();
+    return node;
+}
+
+/* Keep a parsed function, or stream it out. After a syntax error the
+   parse will fail, so it is dropped instead (the arena reclaims it). */
+static void add_function(Parser* p, ASTList* functions, ASTNode* function) {
+    if (p->errors > 0) return;
+    parse_context_add_function(p->ctx, functions, function);
+}
+
+/* function_definitions main_function, then the end of input */
+static ASTNode* parse_program(Parser* p) {
+    ASTList functions = ast_list(NULL);
+    ASTNode* main_function = NULL;
+    while (expect(p, TYPE_INT)) {
+        int token = peek(p);
+        if (token == MAIN) {
+            main_function = parse_main_function(p);
+            break;
+        }
+        if (token != ID) {
+            syntax_error(p, "MAIN or ID");
+            break;
+        }
+        add_function(p, &functions, parse_function_definition(p));
+    }
+    expect(p, 0);
+
+    /* As in parser.y, main is streamed out before the root is created */
+    add_function(p, &functions, main_function);
+    ASTNode* program = create_ast_node(AST_PROGRAM);
+    add_children(program, functions);
+    return program;
+}
+
+int rd_parse(ParseContext* ctx) {
+    Parser p;
+    p.ctx = ctx;
+    p.pending = 1;
+    p.errors = 0;
+    p.recovering = 0;
+
+    ASTNode* program = parse_program(&p);
+    if (p.errors > 0) {
+        ctx->ast_root = NULL;
+        return 1;
+    }
+    ctx->ast_root = program;
+    return 0;
+}
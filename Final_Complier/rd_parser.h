@@ -0,0 +1,21 @@
+/* rd_parser.h */
+
+#ifndef RD_PARSER_H
+#define RD_PARSER_H
+
+#include "parse_context.h"
+
+/*
+ * Hand-written recursive-descent parser for the grammar in parser.y,
+ * with precedence climbing for expressions. It reads the same tokens
+ * (through yylex), makes the same symbol table calls in the same order
+ * and builds the same AST as yyparse(), leaving it in ctx->ast_root.
+ *
+ * Unlike the bison parser it recovers from a syntax error by skipping
+ * to the end of the statement, so several errors can be reported in
+ * one run. Returns 0 on success and 1 if there were syntax errors, in
+ * which case no tree is returned.
+ */
+int rd_parse(ParseContext* ctx);
+
+#endif /* RD_PARSER_H */
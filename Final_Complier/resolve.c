@@ -0,0 +1,77 @@
+#include "resolve.h"
+#include "ast_visit.h"
+#include "intern.h"
+
+Symbol* resolve_name(ASTNode* node) {
+    Symbol* sym = lookup_symbol(ast_name(node));
+    node->symbol = sym ? sym->id : 0;
+    return sym;
+}
+
+/* Whether the name of 'node' refers to a symbol */
+static int names_symbol(const ASTNode* node) {
+    switch (node->type) {
+        case AST_ASSIGNMENT:
+        case AST_WRITE:
+        case AST_FUNCTION_CALL:
+        case AST_ARRAY_ACCESS:
+            return 1;
+        case AST_EXPRESSION:
+            return ast_expr_kind(node) == EXPR_ID;
+        default:
+            return 0;
+    }
+}
+
+/* Name a function is declared under */
+static const char* function_name(const ASTNode* function) {
+    return function->type == AST_MAIN_FUNCTION ? intern_cstr("main") : ast_name(function);
+}
+
+/* Reaching a node: open a function's scope, bind a use, and walk what
+   is under it in source order (the condition of an if or while, then
+   its body, then its else chain) */
+static void resolve_pre(ASTVisitor* visitor, const ASTVisit* visit) {
+    ASTNode* node = visit->node;
+    if (node->type == AST_FUNCTION_DEFINITION || node->type == AST_MAIN_FUNCTION) {
+        add_symbol(function_name(node), DT_INT, SYMBOL_FUNCTION, DT_INT, NULL, NULL, 0);
+        enter_scope();
+    } else if (names_symbol(node) && ast_name(node) && !resolve_name(node)) {
+        (*(int*)visitor->data)++;
+    }
+
+    if (node->type == AST_IF || node->type == AST_WHILE) {
+        ast_visit_list(visitor, ast_condition(node), 0, 0);
+        ast_visit_list(visitor, ast_body(node), 0, 0);
+        ast_visit_list(visitor, ast_left(node), 0, 0);
+    } else {
+        ast_visit_list(visitor, ast_left(node), 0, 0);
+        ast_visit_list(visitor, ast_node(node->right), 0, 0);
+    }
+}
+
+/* Leaving a node: declare a declaration, or close a function's scope */
+static void resolve_post(ASTVisitor* visitor, const ASTVisit* visit) {
+    (void)visitor;
+    ASTNode* decl = visit->node;
+    if (decl->type == AST_FUNCTION_DEFINITION || decl->type == AST_MAIN_FUNCTION) {
+        exit_scope();
+    } else if (decl->type == AST_DECLARATION) {
+        if (decl->category == SYMBOL_ARRAY) {
+            add_symbol(ast_name(decl), DT_ARRAY, SYMBOL_ARRAY, DT_VOID, NULL,
+                       (int*)ast_array_sizes(decl), decl->dimensions);
+        } else {
+            add_symbol(ast_name(decl), (DataType)decl->data_type, SYMBOL_VARIABLE, DT_VOID, NULL, NULL, 0);
+        }
+        resolve_name(decl);
+    }
+}
+
+int resolve_names(ASTNode* program) {
+    int unresolved = 0;
+    ASTVisitor visitor;
+    ast_visitor_init(&visitor, resolve_pre, resolve_post, &unresolved);
+    ast_walk_list(&visitor, ast_left(program), 0, 0);
+    ast_visitor_free(&visitor);
+    return unresolved;
+}
@@ -0,0 +1,36 @@
+#ifndef RESOLVE_H
+#define RESOLVE_H
+
+#include "ast.h"
+
+/*
+ * Binding names to symbols. IDs, calls, array accesses, assignments,
+ * writes and declarations hold the id of the symbol their name has where
+ * they appear (see ast_symbol), or 0 if it has none. Semantic analysis
+ * and code generation read the binding from the node instead of looking
+ * the name up again.
+ *
+ * The parsers bind each node as they build it, while its scope is open;
+ * as the id overlays the node's last_child (see add_child), that is done
+ * once its children are attached.
+ * A function's parameters and body are in a scope of their own, so
+ * same-named locals of different functions get different symbols.
+ * Symbols outlive their scopes (see symbol_by_id), so the bindings stay
+ * valid for the rest of the compilation.
+ */
+
+/* Bind 'node' to the innermost symbol of its name in scope and return
+   it; NULL, and id 0, if there is none */
+Symbol* resolve_name(ASTNode* node);
+
+/*
+ * Declare and bind the names of a program the parsers did not build
+ * (one loaded from the AST cache) as the parsers would have: walks
+ * 'program' in source order, adding each function and entering its
+ * scope before its parameters, declaring each declaration once its
+ * initializer is bound, and exiting the scope after the body. Returns
+ * the number of names that have no symbol.
+ */
+int resolve_names(ASTNode* program);
+
+#endif
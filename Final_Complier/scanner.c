@@ -0,0 +1,458 @@
+/* scanner.c
+ *
+ * Hand-written scanner: a drop-in replacement for the flex scanner in
+ * lexer.l, selected at build time with 'make LEXER=simd'. It implements
+ * the same Lexer interface (see lexer.h) and produces exactly the same
+ * token stream.
+ *
+ * Whitespace, identifier and digit runs are classified 32 (AVX2) or 16
+ * (SSE2) bytes at a time, with a scalar fallback for other targets.
+ * Wide loads may run past the end of the text; that is safe because
+ * every input buffer is followed by SOURCE_PADDING NUL bytes, and NUL
+ * stops every run. Keywords are recognised with a perfect hash over the
+ * fixed keyword set instead of a DFA.
+ *
+ * Unlike flex, the scanner never writes into the input, so a mapped
+ * source file stays shared with the page cache. Token text therefore
+ * points into the input and is NOT NUL-terminated; use its length.
+ */
+
+#include "parser.tab.h"
+#include "lexer.h"
+#include "intern.h"
+#include "diag.h"
+#include "source.h"
+#include "tokens.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SCAN_WIDTH 32
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SCAN_WIDTH 16
+#endif
+
+/* Scanner state for one input */
+struct Lexer {
+    /* Current input: [cursor, limit) with NUL padding after limit */
+    char* cursor;
+    char* limit;
+    /* Start of the current input, for token offsets */
+    char* base_text;
+    /* Current token */
+    char* text;
+    int length;
+    /* Text read from a stream, owned by the scanner */
+    SourceBuffer owned_source;
+};
+
+/* ---- Character classes ---- */
+
+static inline int is_blank(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline int is_digit(unsigned char c) {
+    return (unsigned)(c - '0') < 10;
+}
+
+static inline int is_ident_start(unsigned char c) {
+    return (unsigned)((c | 0x20) - 'a') < 26 || c == '_';
+}
+
+static inline int is_ident_char(unsigned char c) {
+    return is_ident_start(c) || is_digit(c);
+}
+
+#if SCAN_WIDTH == 32
+typedef __m256i vec_t;
+typedef unsigned mask_t;
+#define ALL_ONES 0xFFFFFFFFu
+#define vload(p)        _mm256_loadu_si256((const __m256i*)(p))
+#define vsplat(c)       _mm256_set1_epi8((char)(c))
+#define veq(a, b)       _mm256_cmpeq_epi8(a, b)
+#define vgt(a, b)       _mm256_cmpgt_epi8(a, b)
+#define vor(a, b)       _mm256_or_si256(a, b)
+#define vand(a, b)      _mm256_and_si256(a, b)
+#define vmask(v)        ((mask_t)_mm256_movemask_epi8(v))
+#elif SCAN_WIDTH == 16
+typedef __m128i vec_t;
+typedef unsigned mask_t;
+#define ALL_ONES 0xFFFFu
+#define vload(p)        _mm_loadu_si128((const __m128i*)(p))
+#define vsplat(c)       _mm_set1_epi8((char)(c))
+#define veq(a, b)       _mm_cmpeq_epi8(a, b)
+#define vgt(a, b)       _mm_cmpgt_epi8(a, b)
+#define vor(a, b)       _mm_or_si128(a, b)
+#define vand(a, b)      _mm_and_si128(a, b)
+#define vmask(v)        ((mask_t)_mm_movemask_epi8(v))
+#endif
+
+#ifdef SCAN_WIDTH
+/* Bytes in [lo, hi]; the signed compares reject bytes >= 0x80 */
+static inline vec_t vrange(vec_t v, char lo, char hi) {
+    return vand(vgt(v, vsplat(lo - 1)), vgt(vsplat(hi + 1), v));
+}
+
+static inline mask_t digit_mask(vec_t v) {
+    return vmask(vrange(v, '0', '9'));
+}
+
+static inline mask_t ident_mask(vec_t v) {
+    vec_t letters = vrange(vor(v, vsplat(0x20)), 'a', 'z');
+    return vmask(vor(vor(letters, vrange(v, '0', '9')), veq(v, vsplat('_'))));
+}
+#endif
+
+/* Return the first non-blank character at or after p */
+static inline char* skip_blanks(char* p) {
+    /* Most tokens are separated by at most one blank */
+    if (!is_blank((unsigned char)*p)) return p;
+#ifdef SCAN_WIDTH
+    for (;;) {
+        vec_t v = vload(p);
+        vec_t blank = vor(vor(veq(v, vsplat(' ')), veq(v, vsplat('\t'))),
+                          vor(veq(v, vsplat('\r')), veq(v, vsplat('\n'))));
+        mask_t blanks = vmask(blank);
+        if (blanks != ALL_ONES) return p + __builtin_ctz(~blanks);
+        p += SCAN_WIDTH;
+    }
+#else
+    while (is_blank((unsigned char)*p)) p++;
+    return p;
+#endif
+}
+
+/* Return the first non-identifier character at or after p */
+static inline char* skip_ident_chars(char* p) {
+#ifdef SCAN_WIDTH
+    for (;;) {
+        mask_t m = ident_mask(vload(p));
+        if (m != ALL_ONES) return p + __builtin_ctz(~m);
+        p += SCAN_WIDTH;
+    }
+#else
+    while (is_ident_char((unsigned char)*p)) p++;
+    return p;
+#endif
+}
+
+/* Return the first non-digit at or after p */
+static inline char* skip_digits(char* p) {
+#ifdef SCAN_WIDTH
+    for (;;) {
+        mask_t m = digit_mask(vload(p));
+        if (m != ALL_ONES) return p + __builtin_ctz(~m);
+        p += SCAN_WIDTH;
+    }
+#else
+    while (is_digit((unsigned char)*p)) p++;
+    return p;
+#endif
+}
+
+/* ---- Keywords ---- */
+
+typedef struct Keyword {
+    const char* text;
+    int length;
+    int token;
+} Keyword;
+
+/* Perfect hash over the keyword set: (first + second char + length) mod 16.
+   Every keyword is at least two characters long. */
+#define KEYWORD_HASH(p, len) (((unsigned char)(p)[0] + (unsigned char)(p)[1] + (len)) & 15)
+
+static const Keyword keyword_table[16] = {
+    [1]  = { "if",     2, IF },
+    [2]  = { "main",   4, MAIN },
+    [4]  = { "while",  5, WHILE },
+    [5]  = { "else",   4, ELSE },
+    [7]  = { "float",  5, TYPE_FLOAT },
+    [8]  = { "array",  5, ARRAY },
+    [10] = { "int",    3, TYPE_INT },
+    [13] = { "return", 6, RETURN },
+    [14] = { "write",  5, WRITE },
+    [15] = { "char",   4, TYPE_CHAR },
+};
+
+static inline int keyword_token(const char* p, int length) {
+    if (length < 2 || length > 6) return 0;
+    const Keyword* k = &keyword_table[KEYWORD_HASH(p, length)];
+    if (k->length == length && memcmp(k->text, p, length) == 0) return k->token;
+    return 0;
+}
+
+/* Token names as printed by the flex scanner's trace */
+static const char* token_name(int token) {
+    switch (token) {
+        case TYPE_INT: return "TYPE_INT";
+        case TYPE_CHAR: return "TYPE_CHAR";
+        case TYPE_FLOAT: return "TYPE_FLOAT";
+        case ARRAY: return "ARRAY";
+        case RETURN: return "RETURN";
+        case MAIN: return "MAIN";
+        case WHILE: return "WHILE";
+        case ASSIGNOP: return "ASSIGNOP";
+        case OP_ADD: return "OP_ADD";
+        case OP_SUB: return "OP_SUB";
+        case OP_MUL: return "OP_MUL";
+        case OP_DIV: return "OP_DIV";
+        case SEMICOLON: return "SEMICOLON";
+        case WRITE: return "WRITE";
+        case IF: return "IF";
+        case ELSE: return "ELSE";
+        case GT: return "GT";
+        case LT: return "LT";
+        case GE: return "GE";
+        case LE: return "LE";
+        case EQ: return "EQ";
+        case NE: return "NE";
+        case NOT: return "NOT";
+        case AND: return "AND";
+        case OR: return "OR";
+        case LPAREN: return "LPAREN";
+        case RPAREN: return "RPAREN";
+        case LBRACE: return "LBRACE";
+        case RBRACE: return "RBRACE";
+        case LBRACKET: return "LBRACKET";
+        case RBRACKET: return "RBRACKET";
+        case COMMA: return "COMMA";
+        case FLOAT_NUMBER: return "FLOAT_NUMBER";
+        case NUMBER: return "NUMBER";
+        case ID: return "ID";
+        default: return "UNKNOWN";
+    }
+}
+
+/* ---- Literal values ---- */
+
+/* Same result as atoi() on the digit run [p, end), including its
+   saturate-then-truncate behaviour on overflow */
+static inline int scan_int(const char* p, const char* end) {
+    unsigned long value = 0;
+    while (p < end) {
+        unsigned long digit = (unsigned long)(*p++ - '0');
+        if (value > (LONG_MAX - digit) / 10) {
+            value = LONG_MAX;
+            break;
+        }
+        value = value * 10 + digit;
+    }
+    return (int)(long)value;
+}
+
+/* Same result as atof() on the float literal, which is not NUL-terminated
+   in the input (and strtod would also accept exponents the grammar lacks) */
+static float scan_float(const char* p, int length) {
+    char buf[64];
+    if (length < (int)sizeof(buf)) {
+        memcpy(buf, p, (size_t)length);
+        buf[length] = '\0';
+        return (float)atof(buf);
+    }
+    char* big = (char*)malloc((size_t)length + 1);
+    if (!big) {
+        fprintf(stderr, "Failed to allocate scanner buffer.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(big, p, (size_t)length);
+    big[length] = '\0';
+    float value = (float)atof(big);
+    free(big);
+    return value;
+}
+
+/* ---- Scanner ---- */
+
+/* Token returned by scan_token() for a character no rule matches */
+#define SCAN_UNRECOGNIZED (-1)
+
+/* Scan the next token from *cursor, stopping at limit. Sets *start to
+   the token text and advances *cursor past it. Returns 0 at the end of
+   the input. Literal values and identifier interning are left to the
+   caller. */
+static inline int scan_token(char** cursor, char* limit, char** start) {
+    char* p = skip_blanks(*cursor);
+    if (p >= limit) {
+        *cursor = p;
+        *start = limit;
+        return 0;
+    }
+
+    *start = p;
+    unsigned char c = (unsigned char)*p;
+    int token;
+
+    if (is_ident_start(c)) {
+        char* begin = p;
+        p = skip_ident_chars(p + 1);
+        token = keyword_token(begin, (int)(p - begin));
+        if (!token) token = ID;
+    } else if (is_digit(c)) {
+        p = skip_digits(p + 1);
+        if (*p == '.' && is_digit((unsigned char)p[1])) {
+            p = skip_digits(p + 2);
+            token = FLOAT_NUMBER;
+        } else {
+            token = NUMBER;
+        }
+    } else {
+        p++;
+        switch (c) {
+            case '=':
+                if (*p == '=') { p++; token = EQ; } else token = ASSIGNOP;
+                break;
+            case '>':
+                if (*p == '=') { p++; token = GE; } else token = GT;
+                break;
+            case '<':
+                if (*p == '=') { p++; token = LE; } else token = LT;
+                break;
+            case '!':
+                if (*p == '=') { p++; token = NE; } else token = NOT;
+                break;
+            case '&':
+                if (*p == '&') { p++; token = AND; } else token = SCAN_UNRECOGNIZED;
+                break;
+            case '|':
+                if (*p == '|') { p++; token = OR; } else token = SCAN_UNRECOGNIZED;
+                break;
+            case '+': token = OP_ADD; break;
+            case '-': token = OP_SUB; break;
+            case '*': token = OP_MUL; break;
+            case '/': token = OP_DIV; break;
+            case ';': token = SEMICOLON; break;
+            case '(': token = LPAREN; break;
+            case ')': token = RPAREN; break;
+            case '{': token = LBRACE; break;
+            case '}': token = RBRACE; break;
+            case '[': token = LBRACKET; break;
+            case ']': token = RBRACKET; break;
+            case ',': token = COMMA; break;
+            default: token = SCAN_UNRECOGNIZED; break;
+        }
+    }
+
+    *cursor = p;
+    return token;
+}
+
+Lexer* lexer_create(void) {
+    Lexer* lexer = (Lexer*)calloc(1, sizeof(Lexer));
+    if (!lexer) {
+        fprintf(stderr, "Failed to allocate scanner.\n");
+        exit(EXIT_FAILURE);
+    }
+    return lexer;
+}
+
+void lexer_destroy(Lexer* lexer) {
+    if (!lexer) return;
+    lexer_finish(lexer);
+    free(lexer);
+}
+
+int lexer_lex(Lexer* lexer, YYSTYPE* value) {
+    if (!lexer->cursor) return 0;
+
+    for (;;) {
+        char* start;
+        int token = scan_token(&lexer->cursor, lexer->limit, &start);
+        if (token == SCAN_UNRECOGNIZED) {
+            tokens_report_unrecognized((uint32_t)(start - lexer->base_text), *start);
+            continue;
+        }
+
+        int length = (int)(lexer->cursor - start);
+        lexer->text = start;
+        lexer->length = length;
+
+        if (token == ID) {
+            value->string = intern(start, (size_t)length);
+        } else if (token == NUMBER) {
+            value->number = scan_int(start, lexer->cursor);
+        } else if (token == FLOAT_NUMBER) {
+            value->float_number = scan_float(start, length);
+        }
+
+        if (token && diag_enabled(DIAG_TRACE)) {
+            diag_printf("TOKEN: %-10s | %.*s\n", token_name(token), length, start);
+        }
+        return token;
+    }
+}
+
+uint32_t lexer_token_offset(const Lexer* lexer) {
+    return lexer->text ? (uint32_t)(lexer->text - lexer->base_text) : 0;
+}
+
+const char* lexer_token_text(const Lexer* lexer, int* length) {
+    *length = lexer->length;
+    return lexer->text ? lexer->text : "";
+}
+
+int lexer_input_text(const Lexer* lexer, const char** text, size_t* length) {
+    if (!lexer->base_text) return -1;
+    *text = lexer->base_text;
+    *length = (size_t)(lexer->limit - lexer->base_text);
+    return 0;
+}
+
+void lexer_lex_range(const char* text, size_t begin, size_t end, TokenBuffer* out) {
+    char* p = (char*)text + begin;
+    char* stop = (char*)text + end;
+    size_t n = out->count;
+    for (;;) {
+        char* start;
+        int token = scan_token(&p, stop, &start);
+        if (!token) break;
+
+        if (n == out->capacity) {
+            token_buffer_reserve(out, out->capacity ? out->capacity * 2 : 4096);
+        }
+        uint32_t value = 0;
+        if (token == SCAN_UNRECOGNIZED) {
+            token = TOKEN_KIND_BASE + TOKEN_KIND_UNRECOGNIZED;
+        } else if (token == ID) {
+            value = (uint32_t)(p - start);
+        } else if (token == NUMBER) {
+            value = (uint32_t)scan_int(start, p);
+        } else if (token == FLOAT_NUMBER) {
+            float f = scan_float(start, (int)(p - start));
+            memcpy(&value, &f, sizeof(value));
+        }
+        out->kind[n] = (uint8_t)(token - TOKEN_KIND_BASE);
+        out->offset[n] = (uint32_t)(start - text);
+        out->value[n] = value;
+        n++;
+    }
+    out->count = n;
+}
+
+void lexer_scan_buffer(Lexer* lexer, char* base, size_t length) {
+    lexer->base_text = base;
+    lexer->cursor = base;
+    lexer->limit = base + length;
+    lexer->text = NULL;
+    lexer->length = 0;
+}
+
+void lexer_scan_stream(Lexer* lexer, FILE* in) {
+    source_release(&lexer->owned_source);
+    source_read_stream(in, &lexer->owned_source);
+    lexer_scan_buffer(lexer, lexer->owned_source.data, lexer->owned_source.length);
+}
+
+void lexer_finish(Lexer* lexer) {
+    source_release(&lexer->owned_source);
+    lexer->cursor = NULL;
+    lexer->limit = NULL;
+    lexer->base_text = NULL;
+    lexer->text = NULL;
+    lexer->length = 0;
+}
@@ -4,23 +4,40 @@
 #include <string.h>
 #include "semantic.h"
 #include "ast.h"
+#include "ast_visit.h"
 #include "symbol_table.h"
+#include "source.h"
 
-/* Global counter for semantic errors */
-static int semantic_error_count = 0;
+/* Counter for semantic errors in the current thread's compilation */
+static _Thread_local int semantic_error_count = 0;
 
 /* Forward declarations of helper functions */
-static void traverse_node(ASTNode* node);
-static DataType deduce_type_from_operator(const char* op, DataType left_type, DataType right_type);
-static void check_condition(ASTNode* cond_node);
+static DataType check_walk(ASTNode* node, int tag);
+static DataType deduce_type_from_operator(const ASTNode* expr, DataType left_type, DataType right_type);
 static int count_initializers(ASTNode* init_node);
 
-/* Report semantic errors with line number information if available (assuming a global line_num) */
-extern int line_num;
-
-void report_semantic_error(const char* format, ...) {
+/*
+ * What a visit of the semantic walk checks. Statements are checked as
+ * they are reached. The type of an expression is pushed on the value
+ * stack once its operands are checked, and then used according to why
+ * the expression was visited.
+ */
+enum {
+    CHECK_STATEMENT,     /* A statement, function or the program */
+    CHECK_VALUE,         /* An operand: its type is left for the parent */
+    CHECK_DISCARD,       /* An expression whose type is not needed */
+    CHECK_CONDITION,     /* Condition of an if or while */
+    CHECK_ASSIGNED,      /* Right-hand side of an assignment */
+    CHECK_INDEX,         /* Index of an array access in an expression */
+    CHECK_WRITE_INDEX,   /* Index of an array element written */
+};
+
+/* Report a semantic error at the source location of 'node' */
+void report_semantic_error(const ASTNode* node, const char* format, ...) {
     va_list args;
-    fprintf(stderr, "Semantic error at line %d: ", line_num);
+    int line, column;
+    source_locate(node->offset, &line, &column);
+    fprintf(stderr, "Semantic error at line %d, column %d: ", line, column);
     va_start(args, format);
     vfprintf(stderr, format, args);
     va_end(args);
@@ -30,8 +47,16 @@ void report_semantic_error(const char* format, ...) {
 
 void traverse_ast(ASTNode* root) {
     if (!root) return;
-    traverse_node(root);
+    check_walk(root, CHECK_STATEMENT);
+    semantic_finish();
+}
 
+int traverse_function(ASTNode* function) {
+    check_walk(function, CHECK_STATEMENT);
+    return semantic_error_count;
+}
+
+void semantic_finish(void) {
     /* After traversal, if semantic_error_count > 0, we may want to stop code generation */
     if (semantic_error_count > 0) {
         fprintf(stderr, "%d semantic error(s) found. Compilation halted.\n", semantic_error_count);
@@ -39,80 +64,51 @@ void traverse_ast(ASTNode* root) {
     }
 }
 
-static void traverse_node(ASTNode* node) {
-    if (!node) return;
-
+static void check_statement(ASTVisitor* visitor, ASTNode* node) {
     switch(node->type) {
         case AST_PROGRAM:
         case AST_BLOCK:
             /* Traverse children */
-            for (ASTNode* child = node->left; child; child = child->next) {
-                traverse_node(child);
-            }
+            ast_visit_list(visitor, ast_left(node), CHECK_STATEMENT, 0);
             break;
         
         case AST_FUNCTION_DEFINITION:
         case AST_MAIN_FUNCTION:
             /* Traverse children (parameters, body) */
-            for (ASTNode* child = node->left; child; child = child->next) {
-                traverse_node(child);
-            }
+            ast_visit_list(visitor, ast_left(node), CHECK_STATEMENT, 0);
             break;
 
         case AST_DECLARATION:
             /* If it's an array declaration with initialization, check that */
-            if (node->category == SYMBOL_ARRAY && node->left && node->type == AST_DECLARATION) {
+            if (node->category == SYMBOL_ARRAY && ast_left(node) && node->type == AST_DECLARATION) {
                 check_array_initialization(node);
             }
 
             /* If it has an initialization expression, check it */
-            if (node->left && node->category == SYMBOL_VARIABLE) {
-                check_expression(node->left);
-            }
-
-            /* Traverse any children */
-            for (ASTNode* child = node->left; child; child = child->next) {
-                traverse_node(child);
+            if (ast_left(node) && node->category == SYMBOL_VARIABLE) {
+                ast_visit_child(visitor, ast_left(node), CHECK_DISCARD, 0);
             }
             break;
 
         case AST_ASSIGNMENT:
-            /* Check the expression on the right-hand side */
-            if (node->left) {
-                DataType rhs_type = check_expression(node->left);
-
-                /* Check that the variable being assigned exists and types match */
-                Symbol* sym = lookup_symbol(node->name);
-                if (!sym) {
-                    report_semantic_error("Assignment to undeclared variable '%s'", node->name);
-                } else {
-                    /* If symbol found, check type compatibility */
-                    if ((sym->type == DT_INT || sym->type == DT_FLOAT || sym->type == DT_CHAR) && rhs_type != sym->type) {
-                        report_semantic_error("Type mismatch in assignment to '%s'. Expected '%s', got '%s'",
-                            node->name,
-                            (sym->type == DT_INT ? "int" : (sym->type == DT_FLOAT ? "float" : "char")),
-                            (rhs_type == DT_INT ? "int" : (rhs_type == DT_FLOAT ? "float" : "char")));
-                    }
-                }
+            /* Check the expression on the right-hand side, then the
+               variable (see check_assigned) */
+            if (ast_left(node)) {
+                ast_visit_child(visitor, ast_left(node), CHECK_ASSIGNED, 0);
             }
             break;
 
         case AST_WRITE:
             /* Just ensure the symbol exists. Type checks are simple here. */
-            if (node->name) {
-                Symbol* sym = lookup_symbol(node->name);
-                if (!sym) {
-                    report_semantic_error("Write statement references undeclared variable '%s'", node->name);
+            if (ast_name(node)) {
+                if (!ast_symbol(node)) {
+                    report_semantic_error(node, "Write statement references undeclared variable '%s'", ast_name(node));
                 }
             }
-            /* If it's writing array element */
-            if (node->left && node->left->type == AST_ARRAY_ACCESS) {
-                /* Check index type is int */
-                if (node->left->left) {
-                    DataType idx_type = check_expression(node->left->left);
-                    if (idx_type != DT_INT) {
-                        report_semantic_error("Array index must be int type.");
-                    }
+            /* If it's writing array element, check index type is int */
+            if (ast_left(node) && ast_left(node)->type == AST_ARRAY_ACCESS) {
+                if (ast_left(ast_left(node))) {
+                    ast_visit_child(visitor, ast_left(ast_left(node)), CHECK_WRITE_INDEX, 0);
                 }
             }
             /* No need to further check */
@@ -121,59 +117,56 @@ static void traverse_node(ASTNode* node) {
         case AST_IF:
         case AST_WHILE:
             /* Check condition */
-            if (node->condition) {
-                check_condition(node->condition);
+            if (ast_condition(node)) {
+                ast_visit_child(visitor, ast_condition(node), CHECK_CONDITION, 0);
             }
             /* Traverse body */
-            if (node->body) {
-                traverse_node(node->body);
+            if (ast_body(node)) {
+                ast_visit_child(visitor, ast_body(node), CHECK_STATEMENT, 0);
             }
             /* If there is an else or additional children, traverse them */
-            for (ASTNode* c = node->left; c; c = c->next) {
-                traverse_node(c);
-            }
+            ast_visit_list(visitor, ast_left(node), CHECK_STATEMENT, 0);
             break;
 
         case AST_RETURN:
             /* Check return expression type */
-            if (node->left) {
-                check_expression(node->left);
-            }
-            break;
-
-        case AST_EXPRESSION:
-        case AST_FUNCTION_CALL:
-        case AST_ARRAY_INIT:
-        case AST_ARRAY_ACCESS:
-            /* Expression-related nodes are checked by check_expression when needed */
-            /* But we can do a general traversal */
-            if (node->left) traverse_node(node->left);
-            if (node->right) traverse_node(node->right);
-            for (ASTNode* c = node->left; c; c = c->next) {
-                traverse_node(c);
+            if (ast_left(node)) {
+                ast_visit_child(visitor, ast_left(node), CHECK_DISCARD, 0);
             }
             break;
 
         default:
-            /* For unknown or not handled explicitly, just traverse children */
-            if (node->left) traverse_node(node->left);
-            if (node->right) traverse_node(node->right);
-            for (ASTNode* c = node->left; c; c = c->next) {
-                traverse_node(c);
-            }
+            /* Expressions are checked where a statement uses them; there
+               is nothing to check below them otherwise */
             break;
     }
 }
 
+/* Check the variable an assignment stores a value of type 'rhs_type' to */
+static void check_assigned(const ASTNode* node, DataType rhs_type) {
+    /* Check that the variable being assigned exists and types match */
+    Symbol* sym = ast_symbol(node);
+    if (!sym) {
+        report_semantic_error(node, "Assignment to undeclared variable '%s'", ast_name(node));
+    } else {
+        /* If symbol found, check type compatibility */
+        if ((sym->type == DT_INT || sym->type == DT_FLOAT || sym->type == DT_CHAR) && rhs_type != sym->type) {
+            report_semantic_error(node, "Type mismatch in assignment to '%s'. Expected '%s', got '%s'",
+                ast_name(node),
+                (sym->type == DT_INT ? "int" : (sym->type == DT_FLOAT ? "float" : "char")),
+                (rhs_type == DT_INT ? "int" : (rhs_type == DT_FLOAT ? "float" : "char")));
+        }
+    }
+}
+
 /* Check semantic correctness of conditions in if/while.
    Conditions usually are comparisons like ==, !=, <, >, etc. */
-static void check_condition(ASTNode* cond_node) {
-    DataType cond_type = check_expression(cond_node);
+static void check_condition(const ASTNode* cond_node, DataType cond_type) {
     /* If condition_type is from a comparison operator, it should end up boolean-like,
        but we have no explicit boolean type. The user asked for same-type operands in comparison.
        Already handled in check_expression. Just ensure we got a known type. */
     if (cond_type == DT_VOID) {
-        report_semantic_error("Invalid condition type in if/while statement.");
+        report_semantic_error(cond_node, "Invalid condition type in if/while statement.");
     }
 }
 
@@ -181,19 +174,19 @@ static void check_condition(ASTNode* cond_node) {
 void check_array_initialization(ASTNode* declaration_node) {
     if (!declaration_node || declaration_node->category != SYMBOL_ARRAY) return;
 
-    Symbol* sym = lookup_symbol(declaration_node->name);
+    Symbol* sym = ast_symbol(declaration_node);
     if (!sym || sym->category != SYMBOL_ARRAY) return;
 
     int declared_size = 1;
     for (int i = 0; i < sym->dimensions; i++) {
-        declared_size *= sym->array_sizes[i];
+        declared_size *= symbol_array_sizes(sym)[i];
     }
 
-    if (declaration_node->left && declaration_node->left->type == AST_ARRAY_INIT) {
-        int init_count = count_initializers(declaration_node->left->left);
+    if (ast_left(declaration_node) && ast_left(declaration_node)->type == AST_ARRAY_INIT) {
+        int init_count = count_initializers(ast_left(ast_left(declaration_node)));
         if (init_count > declared_size) {
-            report_semantic_error("Array '%s' initialized with too many elements. Declared size: %d, Provided: %d",
-                                  declaration_node->name, declared_size, init_count);
+            report_semantic_error(declaration_node, "Array '%s' initialized with too many elements. Declared size: %d, Provided: %d",
+                                  ast_name(declaration_node), declared_size, init_count);
         }
     }
 }
@@ -201,146 +194,228 @@ void check_array_initialization(ASTNode* declaration_node) {
 /* Count the number of elements in an initializer list */
 static int count_initializers(ASTNode* init_node) {
     int count = 0;
-    for (ASTNode* c = init_node; c; c = c->next) {
+    for (ASTNode* c = init_node; c; c = ast_next(c)) {
         count++;
     }
     return count;
 }
 
-/* Check expressions recursively and return their resulting type */
-DataType check_expression(ASTNode* expr) {
-    if (!expr) return DT_VOID;
+/* Reaching an expression: check what can be checked before its
+   operands, and schedule them. Leaves push their type here. */
+static void check_expression_pre(ASTVisitor* visitor, ASTNode* expr) {
+    if (!expr) {
+        ast_push_value(visitor, DT_VOID);
+        return;
+    }
+    if (expr->checked) {
+        /* Checked before (a shared node, or check_expression() again):
+           its type is on the node, and its errors have been reported */
+        ast_push_value(visitor, ast_type(expr));
+        return;
+    }
 
     switch (expr->type) {
         case AST_EXPRESSION:
-            /* If operator is ID, NUMBER, FLOAT_NUMBER, or a unary operator */
-            if (expr->operator) {
-                if (strcmp(expr->operator, "ID") == 0) {
+            switch (ast_expr_kind(expr)) {
+                case EXPR_ID: {
                     /* Lookup symbol type */
-                    Symbol* sym = lookup_symbol(expr->string);
+                    Symbol* sym = ast_symbol(expr);
                     if (!sym) {
-                        report_semantic_error("Undeclared variable '%s' in expression.", expr->string);
-                        return DT_VOID;
+                        report_semantic_error(expr, "Undeclared variable '%s' in expression.", ast_name(expr));
+                        ast_push_value(visitor, DT_VOID);
+                    } else {
+                        ast_push_value(visitor, sym->type);
                     }
-                    return sym->type;
-                } else if (strcmp(expr->operator, "NUMBER") == 0) {
-                    return DT_INT;
-                } else if (strcmp(expr->operator, "FLOAT_NUMBER") == 0) {
-                    return DT_FLOAT;
-                } else if (strcmp(expr->operator, "!") == 0) {
-                    /* NOT operator - typically boolean context, 
-                       but we only have int/float/char. Let's assume it's int (0 or 1).
-                       Check expression operand */
-                    DataType t = check_expression(expr->left);
-                    return t == DT_INT || t == DT_FLOAT || t == DT_CHAR ? DT_INT : DT_VOID;
-                } else {
-                    /* It's likely a binary operator like +, -, *, /, ||, &&, ==, !=, >, <, etc. */
-                    DataType left_type = check_expression(expr->left);
-                    DataType right_type = check_expression(expr->right);
-                    return deduce_type_from_operator(expr->operator, left_type, right_type);
+                    return;
                 }
-            } else {
-                /* No operator means it could be a simple variable ref? Already handled above */
-                return DT_VOID;
+                case EXPR_NUMBER:
+                    ast_push_value(visitor, DT_INT);
+                    return;
+                case EXPR_FLOAT:
+                    ast_push_value(visitor, DT_FLOAT);
+                    return;
+                case EXPR_NOT:
+                    ast_visit_child(visitor, ast_left(expr), CHECK_VALUE, 0);
+                    return;
+                case EXPR_BINARY:
+                    /* A binary operator like +, -, *, /, ||, &&, ==, !=, >, <, etc. */
+                    ast_visit_child(visitor, ast_left(expr), CHECK_VALUE, 0);
+                    ast_visit_child(visitor, ast_right(expr), CHECK_VALUE, 0);
+                    return;
             }
             break;
 
         case AST_FUNCTION_CALL: {
             /* Check function call return type */
-            Symbol* sym = lookup_symbol(expr->string);
+            Symbol* sym = ast_symbol(expr);
             if (!sym || sym->category != SYMBOL_FUNCTION) {
-                report_semantic_error("Call to undeclared function '%s'.", expr->string);
-                return DT_VOID;
+                report_semantic_error(expr, "Call to undeclared function '%s'.", ast_name(expr));
+                ast_push_value(visitor, DT_VOID);
+                return;
             }
             /* For now, assume arguments are correct. Could add argument checks. */
+            ast_push_value(visitor, sym->return_type);
             /* Check arguments */
-            ASTNode* arg = expr->arguments;
-            while (arg) {
-                check_expression(arg);
-                arg = arg->next;
-            }
-            return sym->return_type;  
+            ast_visit_list(visitor, ast_arguments(expr), CHECK_DISCARD, 0);
+            return;
         }
 
         case AST_ARRAY_ACCESS: {
             /* Check array symbol and index type */
-            Symbol* sym = lookup_symbol(expr->string);
+            Symbol* sym = ast_symbol(expr);
             if (!sym || sym->category != SYMBOL_ARRAY) {
-                report_semantic_error("Invalid array access on '%s'. Not an array.", expr->string);
-                return DT_VOID;
-            }
-            /* Check index is int */
-            if (expr->left) {
-                DataType idx_type = check_expression(expr->left);
-                if (idx_type != DT_INT) {
-                    report_semantic_error("Array index must be int type for '%s'.", expr->string);
-                }
+                report_semantic_error(expr, "Invalid array access on '%s'. Not an array.", ast_name(expr));
+                ast_push_value(visitor, DT_VOID);
+                return;
             }
             /* Array access results in the array's base type */
             /* The symbol might have type DT_ARRAY, but base type is stored in 'type' */
             /* In the provided code, arrays are stored as DT_ARRAY. Let's assume base type int for simplicity 
                or ideally we would store the element type separately. For now, we rely on the original type. */
-            return sym->type == DT_ARRAY ? DT_INT : sym->type;
+            ast_push_value(visitor, sym->type == DT_ARRAY ? DT_INT : sym->type);
+            /* Check index is int */
+            if (ast_left(expr)) {
+                ast_visit_child(visitor, ast_left(expr), CHECK_INDEX, 0);
+            }
+            return;
         }
 
         default:
             /* Other nodes not directly expressions */
-            return DT_VOID;
+            break;
     }
+    ast_push_value(visitor, DT_VOID);
+}
+
+/* Leaving an expression: push the type of an operator from those of its
+   operands, and note the expression's type on it */
+static void check_expression_post(ASTVisitor* visitor, ASTNode* expr) {
+    if (!expr || expr->checked) return;
+
+    if (ast_is_expr(expr, EXPR_NOT)) {
+        /* NOT operator - typically boolean context, 
+           but we only have int/float/char. Let's assume it's int (0 or 1). */
+        DataType t = (DataType)ast_pop_value(visitor);
+        ast_push_value(visitor, t == DT_INT || t == DT_FLOAT || t == DT_CHAR ? DT_INT : DT_VOID);
+    } else if (ast_is_expr(expr, EXPR_BINARY)) {
+        DataType right_type = (DataType)ast_pop_value(visitor);
+        DataType left_type = (DataType)ast_pop_value(visitor);
+        ast_push_value(visitor, deduce_type_from_operator(expr, left_type, right_type));
+    }
+    expr->data_type = (uint8_t)ast_peek_value(visitor, 0);
+    expr->checked = 1;
+}
+
+static void check_pre(ASTVisitor* visitor, const ASTVisit* visit) {
+    if (visit->tag == CHECK_STATEMENT) {
+        if (visit->node) check_statement(visitor, visit->node);
+    } else {
+        check_expression_pre(visitor, visit->node);
+    }
+}
+
+static void check_post(ASTVisitor* visitor, const ASTVisit* visit) {
+    if (visit->tag == CHECK_STATEMENT) return;
+    check_expression_post(visitor, visit->node);
+
+    /* Use the expression's type */
+    switch (visit->tag) {
+        case CHECK_VALUE:
+            break;
+        case CHECK_DISCARD:
+            ast_pop_value(visitor);
+            break;
+        case CHECK_CONDITION:
+            check_condition(visit->node, (DataType)ast_pop_value(visitor));
+            break;
+        case CHECK_ASSIGNED:
+            check_assigned(visit->parent, (DataType)ast_pop_value(visitor));
+            break;
+        case CHECK_INDEX:
+            if ((DataType)ast_pop_value(visitor) != DT_INT) {
+                report_semantic_error(visit->node, "Array index must be int type for '%s'.", ast_name(visit->parent));
+            }
+            break;
+        case CHECK_WRITE_INDEX:
+            if ((DataType)ast_pop_value(visitor) != DT_INT) {
+                report_semantic_error(visit->node, "Array index must be int type.");
+            }
+            break;
+    }
+}
+
+/* Check the tree under 'node', visited as 'tag'. Returns the type of an
+   expression visited as CHECK_VALUE. */
+static DataType check_walk(ASTNode* node, int tag) {
+    ASTVisitor visitor;
+    ast_visitor_init(&visitor, check_pre, check_post, NULL);
+    ast_walk(&visitor, node, tag, 0);
+    DataType type = tag == CHECK_VALUE ? (DataType)ast_pop_value(&visitor) : DT_VOID;
+    ast_visitor_free(&visitor);
+    return type;
+}
+
+/* Check expressions and return their resulting type */
+DataType check_expression(ASTNode* expr) {
+    return check_walk(expr, CHECK_VALUE);
 }
 
 /* Deduce the resulting type from a binary operator and its operand types.
    Also checks for semantic errors when mixing int and float or comparing different types. */
-static DataType deduce_type_from_operator(const char* op, DataType left_type, DataType right_type) {
+static DataType deduce_type_from_operator(const ASTNode* expr, DataType left_type, DataType right_type) {
+    const char* op = binop_text(ast_binop(expr));
     /* If either side is void, propagate void to avoid cascading errors */
     if (left_type == DT_VOID || right_type == DT_VOID) {
         return DT_VOID;
     }
 
-    /* For arithmetic operators (+, -, *, /): 
-       - Both must be int or both must be float, or both must be char?
-       - The user wants an error if int is added to float (mixing types not allowed)
-    */
-    if (strcmp(op, "+") == 0 || strcmp(op, "-") == 0 ||
-        strcmp(op, "*") == 0 || strcmp(op, "/") == 0) {
-        
-        if (left_type != right_type) {
-            report_semantic_error("Type mismatch in arithmetic operation '%s'. Left: %s, Right: %s", op,
-                (left_type == DT_INT ? "int" : left_type == DT_FLOAT ? "float" : "char"),
-                (right_type == DT_INT ? "int" : right_type == DT_FLOAT ? "float" : "char"));
-            return DT_VOID;
-        }
-        /* If same type, return that type */
-        return left_type;
-    }
-
-    /* Logical or comparison operators (==, !=, <, >, <=, >=):
-       - Both operands must be of the same type.
-    */
-    if (strcmp(op, "==") == 0 || strcmp(op, "!=") == 0 ||
-        strcmp(op, "<") == 0 || strcmp(op, ">") == 0 ||
-        strcmp(op, "<=") == 0 || strcmp(op, ">=") == 0) {
-        
-        if (left_type != right_type) {
-            report_semantic_error("Type mismatch in comparison '%s'. Left: %s, Right: %s", op,
-                (left_type == DT_INT ? "int" : left_type == DT_FLOAT ? "float" : "char"),
-                (right_type == DT_INT ? "int" : right_type == DT_FLOAT ? "float" : "char"));
-            return DT_VOID;
-        }
-        /* Comparison results in int (0 or 1 for boolean context) */
-        return DT_INT;
-    }
-
-    /* Logical operators (&&, ||):
-       - Typically these expect boolean (int) types, but since we don't have a boolean,
-         assume int or treat float/char as error. For simplicity, let's allow int only.
-    */
-    if (strcmp(op, "&&") == 0 || strcmp(op, "||") == 0) {
-        if (left_type != DT_INT || right_type != DT_INT) {
-            report_semantic_error("Logical operator '%s' requires integer operands.", op);
-            return DT_VOID;
-        }
-        return DT_INT;
+    switch (ast_binop(expr)) {
+        /* For arithmetic operators (+, -, *, /): 
+           - Both must be int or both must be float, or both must be char?
+           - The user wants an error if int is added to float (mixing types not allowed)
+        */
+        case BINOP_ADD:
+        case BINOP_SUB:
+        case BINOP_MUL:
+        case BINOP_DIV:
+            if (left_type != right_type) {
+                report_semantic_error(expr, "Type mismatch in arithmetic operation '%s'. Left: %s, Right: %s", op,
+                    (left_type == DT_INT ? "int" : left_type == DT_FLOAT ? "float" : "char"),
+                    (right_type == DT_INT ? "int" : right_type == DT_FLOAT ? "float" : "char"));
+                return DT_VOID;
+            }
+            /* If same type, return that type */
+            return left_type;
+
+        /* Logical or comparison operators (==, !=, <, >, <=, >=):
+           - Both operands must be of the same type.
+        */
+        case BINOP_EQ:
+        case BINOP_NE:
+        case BINOP_LT:
+        case BINOP_GT:
+        case BINOP_LE:
+        case BINOP_GE:
+            if (left_type != right_type) {
+                report_semantic_error(expr, "Type mismatch in comparison '%s'. Left: %s, Right: %s", op,
+                    (left_type == DT_INT ? "int" : left_type == DT_FLOAT ? "float" : "char"),
+                    (right_type == DT_INT ? "int" : right_type == DT_FLOAT ? "float" : "char"));
+                return DT_VOID;
+            }
+            /* Comparison results in int (0 or 1 for boolean context) */
+            return DT_INT;
+
+        /* Logical operators (&&, ||):
+           - Typically these expect boolean (int) types, but since we don't have a boolean,
+             assume int or treat float/char as error. For simplicity, let's allow int only.
+        */
+        case BINOP_AND:
+        case BINOP_OR:
+            if (left_type != DT_INT || right_type != DT_INT) {
+                report_semantic_error(expr, "Logical operator '%s' requires integer operands.", op);
+                return DT_VOID;
+            }
+            return DT_INT;
     }
 
     /* If we get here, operator is unknown */
@@ -10,12 +10,25 @@
  * - Type mismatches in expressions (e.g., int + float)
  * - Invalid array initializations (e.g., too many elements for declared size)
  * - Invalid condition comparisons in if/while (operands must match in type)
+ * Its names must have been bound to their symbols (see resolve.h).
  */
 void traverse_ast(ASTNode* root);
 
+/*
+ * The same checks for one function, for streaming compilation. Errors
+ * are reported but do not halt; returns the number of errors so far.
+ * Call semantic_finish() after the last function.
+ */
+int traverse_function(ASTNode* function);
+
+/* Halt if any semantic errors were reported */
+void semantic_finish(void);
+
 /* 
  * Check expressions for type correctness.
- * This will annotate AST nodes with their resulting type.
+ * This will annotate AST nodes with their resulting type (see ast_type);
+ * an expression checked before is not checked again. Its names must
+ * have been bound (see resolve.h).
  * Will print errors if type mismatches occur.
  */
 DataType check_expression(ASTNode* expr);
@@ -27,8 +40,8 @@ DataType check_expression(ASTNode* expr);
 void check_array_initialization(ASTNode* declaration_node);
 
 /* 
- * Utility function to print semantic errors.
+ * Utility function to print semantic errors, located at 'node'.
  */
-void report_semantic_error(const char* format, ...);
+void report_semantic_error(const ASTNode* node, const char* format, ...);
 
 #endif /* SEMANTIC_H */
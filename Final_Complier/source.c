@@ -0,0 +1,209 @@
+/* source.c */
+
+#include "source.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+int source_map_file(const char* path, SourceBuffer* src) {
+    src->data = NULL;
+    src->length = 0;
+    src->mapping_length = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        fprintf(stderr, "Cannot stat '%s': %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        /* Pipes and terminals cannot be mapped; caller streams them */
+        close(fd);
+        return 1;
+    }
+
+    size_t length = (size_t)st.st_size;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t total = (length + SOURCE_PADDING + page - 1) & ~(page - 1);
+
+    /* Reserve text + padding as zeroed anonymous memory, then map the
+       file over the front of it. The bytes past EOF in the last file
+       page read as zero, and so do the anonymous pages after it, so the
+       text is always followed by SOURCE_PADDING NULs. */
+    char* base = (char*)mmap(NULL, total, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Cannot reserve memory for '%s': %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    if (length > 0) {
+        /* Writable private mapping: flex temporarily NUL-terminates yytext
+           in place, which only copies the pages it touches */
+        void* mapped = mmap(base, length, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_FIXED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            fprintf(stderr, "Cannot map '%s': %s\n", path, strerror(errno));
+            munmap(base, total);
+            close(fd);
+            return -1;
+        }
+        madvise(base, length, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    src->data = base;
+    src->length = length;
+    src->mapping_length = total;
+    return 0;
+}
+
+void source_read_stream(FILE* in, SourceBuffer* src) {
+    size_t capacity = 64 * 1024;
+    size_t length = 0;
+    char* buffer = (char*)malloc(capacity + SOURCE_PADDING);
+    if (!buffer) {
+        fprintf(stderr, "Failed to allocate source buffer.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t n;
+    while ((n = fread(buffer + length, 1, capacity - length, in)) > 0) {
+        length += n;
+        if (length == capacity) {
+            capacity *= 2;
+            char* grown = (char*)realloc(buffer, capacity + SOURCE_PADDING);
+            if (!grown) {
+                fprintf(stderr, "Failed to allocate source buffer.\n");
+                exit(EXIT_FAILURE);
+            }
+            buffer = grown;
+        }
+    }
+    memset(buffer + length, 0, SOURCE_PADDING);
+
+    src->data = buffer;
+    src->length = length;
+    src->mapping_length = 0;
+}
+
+void source_release(SourceBuffer* src) {
+    if (src->data) {
+        if (src->mapping_length) {
+            munmap(src->data, src->mapping_length);
+        } else {
+            free(src->data);
+        }
+    }
+    src->data = NULL;
+    src->length = 0;
+    src->mapping_length = 0;
+}
+
+/* ---- Line index ---- */
+
+/* Text that offsets refer to on this thread, and the offsets at which
+   its lines start. Only the first 'indexed' bytes have been scanned for
+   newlines so far. */
+static _Thread_local const char* current_text = NULL;
+static _Thread_local size_t current_length = 0;
+static _Thread_local uint32_t* line_starts = NULL;
+static _Thread_local size_t line_count = 0;
+static _Thread_local size_t line_capacity = 0;
+static _Thread_local size_t indexed = 0;
+
+static void add_line_start(size_t offset) {
+    if (line_count == line_capacity) {
+        line_capacity = line_capacity ? line_capacity * 2 : 1024;
+        uint32_t* grown = (uint32_t*)realloc(line_starts, line_capacity * sizeof(uint32_t));
+        if (!grown) {
+            fprintf(stderr, "Failed to allocate line index.\n");
+            exit(EXIT_FAILURE);
+        }
+        line_starts = grown;
+    }
+    line_starts[line_count++] = (uint32_t)offset;
+}
+
+/* Index the newlines in [indexed, end) */
+static void index_lines(size_t end) {
+    const char* text = current_text;
+    size_t i = indexed;
+#if defined(__AVX2__)
+    const __m256i nl = _mm256_set1_epi8('\n');
+    for (; i + 32 <= end; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(text + i));
+        unsigned m = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl));
+        while (m) {
+            add_line_start(i + __builtin_ctz(m) + 1);
+            m &= m - 1;
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i nl = _mm_set1_epi8('\n');
+    for (; i + 16 <= end; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(text + i));
+        unsigned m = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+        while (m) {
+            add_line_start(i + __builtin_ctz(m) + 1);
+            m &= m - 1;
+        }
+    }
+#endif
+    for (; i < end; i++) {
+        if (text[i] == '\n') add_line_start(i + 1);
+    }
+    indexed = end;
+}
+
+void source_set_current(const SourceBuffer* src) {
+    free(line_starts);
+    line_starts = NULL;
+    line_count = 0;
+    line_capacity = 0;
+    indexed = 0;
+    current_text = src ? src->data : NULL;
+    current_length = src ? src->length : 0;
+    if (current_text) add_line_start(0);
+}
+
+void source_locate(uint32_t offset, int* line, int* column) {
+    if (!current_text) {
+        *line = 0;
+        *column = 0;
+        return;
+    }
+    if (offset > current_length) offset = (uint32_t)current_length;
+
+    /* Only index as far as needed: the flex scanner may have written a
+       NUL just past the current token */
+    if (offset >= indexed) {
+        size_t end = (size_t)offset + 1;
+        index_lines(end < current_length ? end : current_length);
+    }
+
+    /* Last line starting at or before 'offset' */
+    size_t lo = 0, hi = line_count;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (line_starts[mid] <= offset) lo = mid; else hi = mid;
+    }
+    *line = (int)lo + 1;
+    *column = (int)(offset - line_starts[lo]) + 1;
+}
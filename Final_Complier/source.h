@@ -0,0 +1,58 @@
+/* source.h */
+
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Number of zero bytes guaranteed to follow the source text. flex's
+   yy_scan_buffer needs two; the rest lets scanners read ahead in wide
+   loads without checking for the end of the buffer. */
+#define SOURCE_PADDING 64
+
+/* Source text held in memory: a mapped file, or a stream read into the heap */
+typedef struct SourceBuffer {
+    char* data;              /* Start of the text (writable, private copy-on-write) */
+    size_t length;           /* Number of bytes of text */
+    size_t mapping_length;   /* Size of the whole mapping, including padding; 0 if heap */
+} SourceBuffer;
+
+/*
+ * Map 'path' into memory followed by SOURCE_PADDING zero bytes.
+ * Returns 0 on success, 1 if the file is not a regular file (a pipe or
+ * terminal) and must be streamed instead, and -1 on error.
+ */
+int source_map_file(const char* path, SourceBuffer* src);
+
+/*
+ * Read all of 'in' into a heap buffer followed by SOURCE_PADDING zero
+ * bytes. A pipe is read to the end before scanning starts rather than
+ * fed to the scanner through a refilling buffer, because the whole text
+ * has to stay in place for the rest of the compilation: source
+ * locations are offsets into it that diagnostics turn into lines and
+ * columns at any stage (see source_locate), the AST cache is keyed on a
+ * hash of all of it, and the scanners rely on the zero padding after
+ * the last byte to stop their wide loads without a bounds check.
+ * Memory for piped input is thus the size of the text, as for a file.
+ */
+void source_read_stream(FILE* in, SourceBuffer* src);
+
+/* Unmap or free a buffer filled by source_map_file or source_read_stream */
+void source_release(SourceBuffer* src);
+
+/*
+ * Source locations are 32-bit byte offsets into the text being compiled.
+ * Lines and columns are only worked out when a diagnostic needs them,
+ * from an index of line starts that is extended on demand.
+ */
+
+/* Make 'src' the text that offsets refer to on this thread; NULL forgets it */
+void source_set_current(const SourceBuffer* src);
+
+/* Line and column (both from 1) of byte 'offset' in the current text;
+   0 and 0 if there is none */
+void source_locate(uint32_t offset, int* line, int* column);
+
+#endif /* SOURCE_H */
@@ -1,10 +1,70 @@
 #include "symbol_table.h"
+#include "diag.h"
+#include "intern.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Global pointer to the top of the symbol table stack
-static SymbolTable* current_table = NULL;
+/*
+ * Every symbol added lives in one array, in the order added, and is
+ * kept when its scope is exited, so a symbol's id (its index + 1) names
+ * it until the table is freed. A second stack holds the ids of the
+ * symbols in scope, outermost scope first, and a stack of markers
+ * records where each scope starts in both. Exiting a scope truncates
+ * the stack of bindings back to its marker, so scopes cost nothing to
+ * enter or exit once the arrays have grown.
+ *
+ * Lookups follow LeBlanc and Cook: 'innermost' maps each name (by atom
+ * id) to its innermost binding, and each symbol remembers the binding of
+ * the same name it hides. Adding a symbol pushes it on its name's chain;
+ * exiting its scope pops it off again. A lookup is one array access
+ * whatever the depth or size of the scopes.
+ *
+ * The array is kept in fixed-size chunks so that symbols never move
+ * and Symbol pointers stay valid until the table is freed. Array sizes
+ * and parameters are copied into two pools owned by the table. A
+ * scratch scope whose symbols are not needed afterwards can be dropped
+ * with discard_scope(), which truncates the symbols and pools back to
+ * its marker, so it is entered, filled and left without any allocation.
+ */
+
+#define SYMBOL_CHUNK 1024
+
+// This thread's symbols: index i is chunks[i / SYMBOL_CHUNK][i % SYMBOL_CHUNK]
+static _Thread_local Symbol** chunks = NULL;
+static _Thread_local unsigned chunk_count = 0;
+static _Thread_local unsigned symbol_count = 0;
+
+// Array sizes and parameters of the symbols, in the order added
+static _Thread_local int* size_pool = NULL;
+static _Thread_local unsigned size_count = 0;
+static _Thread_local unsigned size_capacity = 0;
+static _Thread_local SymbolParam* param_pool = NULL;
+static _Thread_local unsigned param_count = 0;
+static _Thread_local unsigned param_capacity = 0;
+
+// Ids of the symbols in scope, outermost scope first
+static _Thread_local unsigned* bindings = NULL;
+static _Thread_local unsigned binding_count = 0;
+static _Thread_local unsigned binding_capacity = 0;
+
+// Where each open scope starts in the bindings, symbols and pools
+typedef struct ScopeStart {
+    unsigned bindings;
+    unsigned symbols;
+    unsigned sizes;
+    unsigned params;
+} ScopeStart;
+
+// The open scopes, outermost first; scope_count is 0 before
+// init_symbol_table() and after free_all_symbol_tables()
+static _Thread_local ScopeStart* scope_starts = NULL;
+static _Thread_local unsigned scope_count = 0;
+static _Thread_local unsigned scope_capacity = 0;
+
+// By atom id: id of the innermost symbol of that name in scope; 0 if none
+static _Thread_local unsigned* innermost = NULL;
+static _Thread_local unsigned innermost_count = 0;
 
 // Helper function to convert DataType enum to string
 static const char* datatype_to_string(DataType type) {
@@ -18,202 +78,271 @@ static const char* datatype_to_string(DataType type) {
     }
 }
 
+static Symbol* symbol_at(unsigned index) {
+    return &chunks[index / SYMBOL_CHUNK][index % SYMBOL_CHUNK];
+}
+
+static int current_level(void) {
+    return (int)scope_count - 1;
+}
+
+// Room for one more open scope
+static bool reserve_scope(void) {
+    if (scope_count < scope_capacity) return true;
+    unsigned capacity = scope_capacity ? scope_capacity * 2 : 64;
+    ScopeStart* grown = (ScopeStart*)realloc(scope_starts, sizeof(ScopeStart) * capacity);
+    if (!grown) return false;
+    scope_starts = grown;
+    scope_capacity = capacity;
+    return true;
+}
+
+// Room for 'count' more entries of 'size' bytes in a pool
+static bool reserve_pool(void** pool, unsigned* capacity, unsigned used, unsigned count, size_t size) {
+    if (used + count <= *capacity) return true;
+    unsigned grown = *capacity ? *capacity : 256;
+    while (grown < used + count) grown *= 2;
+    void* memory = realloc(*pool, size * grown);
+    if (!memory) return false;
+    *pool = memory;
+    *capacity = grown;
+    return true;
+}
+
+// Room for one more symbol and its binding, and a chain for atom 'id'
+static bool reserve_symbol(unsigned id) {
+    if (!reserve_pool((void**)&bindings, &binding_capacity, binding_count, 1, sizeof(unsigned))) {
+        return false;
+    }
+    if (symbol_count == chunk_count * SYMBOL_CHUNK) {
+        Symbol** grown = (Symbol**)realloc(chunks, sizeof(Symbol*) * (chunk_count + 1));
+        if (!grown) return false;
+        chunks = grown;
+        chunks[chunk_count] = (Symbol*)malloc(sizeof(Symbol) * SYMBOL_CHUNK);
+        if (!chunks[chunk_count]) return false;
+        chunk_count++;
+    }
+    if (id >= innermost_count) {
+        unsigned count = innermost_count ? innermost_count : 256;
+        while (count <= id) count *= 2;
+        unsigned* grown = (unsigned*)realloc(innermost, sizeof(unsigned) * count);
+        if (!grown) return false;
+        memset(grown + innermost_count, 0, sizeof(unsigned) * (count - innermost_count));
+        innermost = grown;
+        innermost_count = count;
+    }
+    return true;
+}
+
 // Initialize the symbol table by creating the global scope
 void init_symbol_table() {
-    current_table = (SymbolTable*)malloc(sizeof(SymbolTable));
-    if (!current_table) {
+    if (!reserve_scope()) {
         fprintf(stderr, "Failed to initialize symbol table.\n");
         exit(EXIT_FAILURE);
     }
-    current_table->symbols = NULL;
-    current_table->next = NULL;
-    current_table->scope_level = 0;
-    printf("Initialized global scope (Level 0).\n");
+    scope_starts[scope_count++] = (ScopeStart){ binding_count, symbol_count, size_count, param_count };
+    diag_trace("Initialized global scope (Level 0).\n");
 }
 
-// Enter a new scope by pushing a new symbol table onto the stack
+// Enter a new scope by pushing a marker for it
 void enter_scope() {
-    SymbolTable* new_table = (SymbolTable*)malloc(sizeof(SymbolTable));
-    if (!new_table) {
+    if (!reserve_scope()) {
         fprintf(stderr, "Failed to enter new scope.\n");
         exit(EXIT_FAILURE);
     }
-    new_table->symbols = NULL;
-    new_table->next = current_table;
-    new_table->scope_level = current_table->scope_level + 1;
-    current_table = new_table;
-    printf("Entered new scope level %d.\n", current_table->scope_level);
+    scope_starts[scope_count++] = (ScopeStart){ binding_count, symbol_count, size_count, param_count };
+    diag_trace("Entered new scope level %d.\n", current_level());
 }
 
-// Exit the current scope by popping the top symbol table from the stack
+// Exit the current scope by unbinding its symbols, innermost first; the
+// symbols themselves are kept
 void exit_scope() {
-    if (!current_table) {
+    if (scope_count == 0) {
         fprintf(stderr, "No scope to exit.\n");
         return;
     }
-    SymbolTable* temp = current_table;
-    current_table = current_table->next;
-
-    // Free all symbols in the exiting scope
-    Symbol* symbol = temp->symbols;
-    while (symbol) {
-        Symbol* to_free = symbol;
-        symbol = symbol->next;
-        // Free allocated memory for name
-        free(to_free->name);
-        // Free array sizes if it's an array
-        if (to_free->category == SYMBOL_ARRAY && to_free->array_sizes) {
-            free(to_free->array_sizes);
-        }
-        // Free parameters if it's a function
-        if (to_free->category == SYMBOL_FUNCTION && to_free->params) {
-            // Assuming parameters are stored as a linked list
-            Symbol* param = to_free->params;
-            while (param) {
-                Symbol* param_free = param;
-                param = param->next;
-                free(param_free->name);
-                free(param_free);
-            }
-        }
-        free(to_free);
+    ScopeStart start = scope_starts[--scope_count];
+    while (binding_count > start.bindings) {
+        Symbol* symbol = symbol_at(bindings[--binding_count] - 1);
+        innermost[atom_id(symbol->name)] = symbol->shadowed;
     }
-    free(temp);
-    printf("Exited to scope level %d.\n", current_table ? current_table->scope_level : -1);
+    diag_trace("Exited to scope level %d.\n", current_level());
+}
+
+// Exit the current scope and drop every symbol added since it was entered
+void discard_scope() {
+    if (scope_count == 0) {
+        fprintf(stderr, "No scope to exit.\n");
+        return;
+    }
+    ScopeStart start = scope_starts[scope_count - 1];
+    exit_scope();
+    symbol_count = start.symbols;
+    size_count = start.sizes;
+    param_count = start.params;
 }
 
 // Add a new symbol to the current scope
-bool add_symbol(char* name, DataType type, SymbolCategory category, 
+bool add_symbol(const char* name, DataType type, SymbolCategory category, 
                DataType return_type, Symbol* params, int* array_sizes, int dimensions) {
-    if (!current_table) {
+    if (scope_count == 0) {
         fprintf(stderr, "Symbol table not initialized.\n");
         return false;
     }
 
-    // Check if symbol already exists in the current scope
-    Symbol* temp = current_table->symbols;
-    while (temp) {
-        if (strcmp(temp->name, name) == 0) {
-            fprintf(stderr, "Symbol '%s' already declared in the current scope.\n", name);
-            return false;
-        }
-        temp = temp->next;
+    // Check if symbol already exists in the current scope: a binding
+    // added since the scope was entered is still in it, as the scopes
+    // entered since have been exited
+    unsigned id = atom_id(name);
+    if (id < innermost_count && innermost[id] > scope_starts[scope_count - 1].symbols) {
+        fprintf(stderr, "Symbol '%s' already declared in the current scope.\n", name);
+        return false;
     }
 
-    // Create a new symbol
-    Symbol* new_symbol = (Symbol*)malloc(sizeof(Symbol));
-    if (!new_symbol) {
+    // Create a new symbol, with its sizes and parameters in the pools
+    int count = 0;
+    for (Symbol* param = params; param; param = param->next) count++;
+    if (category != SYMBOL_ARRAY) dimensions = 0;
+    if (!reserve_symbol(id) ||
+        !reserve_pool((void**)&size_pool, &size_capacity, size_count, dimensions, sizeof(int)) ||
+        !reserve_pool((void**)&param_pool, &param_capacity, param_count, count, sizeof(SymbolParam))) {
         fprintf(stderr, "Failed to allocate memory for symbol '%s'.\n", name);
         return false;
     }
-    new_symbol->name = strdup(name);
+    Symbol* new_symbol = symbol_at(symbol_count);
+    new_symbol->name = name;
     new_symbol->type = type;
     new_symbol->category = category;
-    new_symbol->scope_level = current_table->scope_level;
-    new_symbol->params = params;
+    new_symbol->scope_level = current_level();
+    new_symbol->id = symbol_count + 1;
     new_symbol->return_type = return_type;
-    new_symbol->array_sizes = NULL;
-    new_symbol->dimensions = 0;
-
-    if (category == SYMBOL_ARRAY) {
-        new_symbol->array_sizes = (int*)malloc(sizeof(int) * dimensions);
-        if (!new_symbol->array_sizes) {
-            fprintf(stderr, "Failed to allocate memory for array sizes of '%s'.\n", name);
-            free(new_symbol->name);
-            free(new_symbol);
-            return false;
-        }
-        memcpy(new_symbol->array_sizes, array_sizes, sizeof(int) * dimensions);
-        new_symbol->dimensions = dimensions;
+    new_symbol->next = NULL;
+
+    new_symbol->params = param_count;
+    new_symbol->param_count = count;
+    for (Symbol* param = params; param; param = param->next) {
+        param_pool[param_count++] = (SymbolParam){ param->name, param->type };
+    }
+
+    new_symbol->array_sizes = size_count;
+    new_symbol->dimensions = dimensions;
+    if (dimensions > 0) {
+        memcpy(&size_pool[size_count], array_sizes, sizeof(int) * dimensions);
+        size_count += dimensions;
     }
 
-    // Insert the new symbol at the beginning of the symbols list
-    new_symbol->next = current_table->symbols;
-    current_table->symbols = new_symbol;
+    // Push it on its name's chain
+    new_symbol->shadowed = innermost[id];
+    innermost[id] = new_symbol->id;
+    bindings[binding_count++] = new_symbol->id;
+    symbol_count++;
 
-    printf("Added symbol '%s' of type '%s' to scope level %d.\n", 
-           name, datatype_to_string(type), current_table->scope_level);
+    diag_trace("Added symbol '%s' of type '%s' to scope level %d.\n", 
+           name, datatype_to_string(type), current_level());
     return true;
 }
 
-// Lookup a symbol by name, searching from the current scope upwards
-Symbol* lookup_symbol(char* name) {
-    SymbolTable* table = current_table;
-    while (table) {
-        Symbol* symbol = table->symbols;
-        while (symbol) {
-            if (strcmp(symbol->name, name) == 0) {
-                return symbol;
-            }
-            symbol = symbol->next;
-        }
-        table = table->next;
+// Lookup a symbol by name: the head of its chain is the innermost binding
+Symbol* lookup_symbol(const char* name) {
+    unsigned id = atom_id(name);
+    if (id >= innermost_count || !innermost[id]) {
+        return NULL; // Symbol not found
     }
-    return NULL; // Symbol not found
+    return symbol_at(innermost[id] - 1);
 }
 
-// Print the symbol table for debugging
+Symbol* symbol_by_id(unsigned id) {
+    return id && id <= symbol_count ? symbol_at(id - 1) : NULL;
+}
+
+const int* symbol_array_sizes(const Symbol* symbol) {
+    return symbol->dimensions ? &size_pool[symbol->array_sizes] : NULL;
+}
+
+const SymbolParam* symbol_params(const Symbol* symbol) {
+    return symbol->param_count ? &param_pool[symbol->params] : NULL;
+}
+
+// Print the symbol table for debugging: every symbol kept, newest
+// first, under the level of the scope it was declared in
 void print_symbol_table() {
-    SymbolTable* table = current_table;
     printf("======= Symbol Table =======\n");
-    while (table) {
-        printf("Scope Level %d:\n", table->scope_level);
-        Symbol* symbol = table->symbols;
-        while (symbol) {
-            printf("  Name: %s, Type: ", symbol->name);
-            switch(symbol->type) {
+    int level = -1;
+    for (unsigned index = symbol_count; index-- > 0; ) {
+        Symbol* symbol = symbol_at(index);
+        if (symbol->scope_level != level) {
+            level = symbol->scope_level;
+            printf("Scope Level %d:\n", level);
+        }
+        printf("  Name: %s, Type: ", symbol->name);
+        switch(symbol->type) {
+            case DT_INT: printf("int"); break;
+            case DT_FLOAT: printf("float"); break;
+            case DT_CHAR: printf("char"); break;
+            case DT_VOID: printf("void"); break;
+            case DT_ARRAY: printf("array"); break;
+            default: printf("unknown"); break;
+        }
+        printf(", Category: ");
+        switch(symbol->category) {
+            case SYMBOL_VARIABLE: printf("Variable"); break;
+            case SYMBOL_FUNCTION: printf("Function"); break;
+            case SYMBOL_ARRAY: printf("Array"); break;
+            default: printf("Unknown"); break;
+        }
+        if (symbol->category == SYMBOL_FUNCTION) {
+            printf(", Return Type: ");
+            switch(symbol->return_type) {
                 case DT_INT: printf("int"); break;
                 case DT_FLOAT: printf("float"); break;
                 case DT_CHAR: printf("char"); break;
                 case DT_VOID: printf("void"); break;
-                case DT_ARRAY: printf("array"); break;
                 default: printf("unknown"); break;
             }
-            printf(", Category: ");
-            switch(symbol->category) {
-                case SYMBOL_VARIABLE: printf("Variable"); break;
-                case SYMBOL_FUNCTION: printf("Function"); break;
-                case SYMBOL_ARRAY: printf("Array"); break;
-                default: printf("Unknown"); break;
-            }
-            if (symbol->category == SYMBOL_FUNCTION) {
-                printf(", Return Type: ");
-                switch(symbol->return_type) {
-                    case DT_INT: printf("int"); break;
-                    case DT_FLOAT: printf("float"); break;
-                    case DT_CHAR: printf("char"); break;
-                    case DT_VOID: printf("void"); break;
-                    default: printf("unknown"); break;
-                }
-                // Print parameters
-                if (symbol->params) {
-                    printf(", Parameters: ");
-                    Symbol* param = symbol->params;
-                    while (param) {
-                        printf("%s %s", datatype_to_string(param->type), param->name);
-                        if (param->next) printf(", ");
-                        param = param->next;
-                    }
+            // Print parameters
+            if (symbol->param_count) {
+                printf(", Parameters: ");
+                const SymbolParam* params = symbol_params(symbol);
+                for (int i = 0; i < symbol->param_count; i++) {
+                    printf("%s %s", datatype_to_string(params[i].type), params[i].name);
+                    if (i < symbol->param_count - 1) printf(", ");
                 }
             }
-            if (symbol->category == SYMBOL_ARRAY) {
-                printf(", Dimensions: %d, Sizes: ", symbol->dimensions);
-                for(int i = 0; i < symbol->dimensions; i++) {
-                    printf("%d", symbol->array_sizes[i]);
-                    if (i < symbol->dimensions -1) printf("x");
-                }
+        }
+        if (symbol->category == SYMBOL_ARRAY) {
+            printf(", Dimensions: %d, Sizes: ", symbol->dimensions);
+            const int* sizes = symbol_array_sizes(symbol);
+            for(int i = 0; i < symbol->dimensions; i++) {
+                printf("%d", sizes[i]);
+                if (i < symbol->dimensions -1) printf("x");
             }
-            printf("\n");
-            symbol = symbol->next;
         }
-        table = table->next;
+        printf("\n");
     }
     printf("============================\n");
 }
 
-// Free all symbol tables and their symbols
+// Free all symbol tables and their symbols; ids start again from 1
 void free_all_symbol_tables() {
-    while (current_table) {
+    while (scope_count > 0) {
         exit_scope();
     }
+    for (unsigned i = 0; i < chunk_count; i++) {
+        free(chunks[i]);
+    }
+    free(chunks);
+    free(scope_starts);
+    free(innermost);
+    free(bindings);
+    free(size_pool);
+    free(param_pool);
+    chunks = NULL;
+    scope_starts = NULL;
+    innermost = NULL;
+    bindings = NULL;
+    size_pool = NULL;
+    param_pool = NULL;
+    chunk_count = scope_capacity = innermost_count = 0;
+    symbol_count = binding_count = binding_capacity = 0;
+    size_count = size_capacity = param_count = param_capacity = 0;
 }
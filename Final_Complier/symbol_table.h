@@ -22,22 +22,31 @@ typedef enum {
 // Forward declaration for Symbol to handle parameters
 typedef struct Symbol Symbol;
 
+// A parameter of a function symbol, as the table stores it
+typedef struct SymbolParam {
+    const char* name;               // Parameter name (interned atom)
+    DataType type;                  // Data type
+} SymbolParam;
+
 // Structure to hold information about a symbol
 struct Symbol {
-    char* name;                     // Symbol name
+    const char* name;               // Symbol name (interned atom)
     DataType type;                  // Data type
     SymbolCategory category;        // Symbol category
     int scope_level;                // Scope level where the symbol is defined
+    unsigned id;                    // Never reused, from 1 (see symbol_by_id)
+    unsigned shadowed;              // Id of the symbol of the same name it hides; 0 if none
 
     // For functions
-    Symbol* params;                 // Linked list of parameters (if function)
+    unsigned params;                // First of 'param_count' parameters (see symbol_params)
+    int param_count;                // Number of parameters
     DataType return_type;           // Return type (if function)
 
     // For arrays
-    int* array_sizes;               // Array sizes (if array)
+    unsigned array_sizes;           // First of 'dimensions' sizes (see symbol_array_sizes)
     int dimensions;                 // Number of dimensions
 
-    Symbol* next;                   // Pointer to the next symbol in the list
+    Symbol* next;                   // Next parameter in a list passed to add_symbol
 };
 
 // Structure to represent array sizes
@@ -46,28 +55,42 @@ typedef struct ArraySizeNode {
     int dimensions;
 } ArraySizeNode;
 
-// Structure for the symbol table (a stack of scopes)
-typedef struct SymbolTable {
-    Symbol* symbols;                // Linked list of symbols in the current scope
-    struct SymbolTable* next;       // Pointer to the next scope in the stack
-    int scope_level;                // Current scope level
-} SymbolTable;
-
 // Initialize the symbol table
 void init_symbol_table();
 
 // Enter a new scope
 void enter_scope();
 
-// Exit the current scope
+// Exit the current scope; its symbols can no longer be looked up by
+// name, but are kept (see symbol_by_id)
 void exit_scope();
 
-// Add a new symbol to the symbol table
-bool add_symbol(char* name, DataType type, SymbolCategory category, 
+// Exit the current scope and drop the symbols added since it was entered,
+// so their ids are given out again; for scratch scopes nothing refers to
+void discard_scope();
+
+// Add a new symbol to the symbol table.
+// Names are interned atoms (see intern.h) and are compared by pointer.
+// The parameters in the list 'params' (linked by 'next') and the
+// 'dimensions' array sizes are copied; the caller keeps ownership.
+bool add_symbol(const char* name, DataType type, SymbolCategory category, 
                DataType return_type, Symbol* params, int* array_sizes, int dimensions);
 
-// Lookup a symbol in the symbol table
-Symbol* lookup_symbol(char* name);
+// Lookup a symbol in the symbol table; 'name' must be an interned atom
+Symbol* lookup_symbol(const char* name);
+
+// The symbol with the given id; NULL for id 0. Ids are given out from 1
+// in the order symbols are added and are never reused: a symbol is kept,
+// unchanged, after its scope is exited, and its id and pointer stay valid
+// until free_all_symbol_tables() (or until a discard_scope() of a scope
+// that was open when it was added).
+Symbol* symbol_by_id(unsigned id);
+
+// Sizes of an array symbol, one per dimension, and parameters of a
+// function symbol, one per parameter. They live in pools owned by the
+// table, so the pointers are valid until the next add_symbol.
+const int* symbol_array_sizes(const Symbol* symbol);
+const SymbolParam* symbol_params(const Symbol* symbol);
 
 // Print the symbol table for debugging
 void print_symbol_table();
@@ -0,0 +1,9 @@
+int main() {
+    int x = 5;
+    int y = x + 2 * 3;
+    x = x + 3 - 3;
+    x = x + 1 * 2;
+    write x;
+    write y;
+    return 0;
+}
@@ -0,0 +1,20 @@
+int main() {
+    int x = 1;
+    x = x + 2;
+    array int arr[4] = {1, 2, 3, 4};
+    arr[1] = x;
+    if (x > 0) {
+        int y = 3;
+        y = y + x;
+        write y;
+    } else {
+        float z = 1.5;
+        write z;
+    }
+    while (x < 10) {
+        int w = 2;
+        x = x + w;
+    }
+    write arr[1];
+    return 0;
+}
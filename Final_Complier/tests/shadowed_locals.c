@@ -0,0 +1,19 @@
+int f(int a)
+{
+    float v = 1.5;
+    float w = v + 2.0;
+    return a;
+}
+
+int g(int b)
+{
+    int v = 2;
+    int w = v + b;
+    return w;
+}
+
+int main() {
+    int v = g(3);
+    write v;
+    return 0;
+}
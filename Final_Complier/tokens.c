@@ -0,0 +1,367 @@
+/* tokens.c */
+
+#include "tokens.h"
+#include "parser.tab.h"
+#include "parse_context.h"
+#include "lexer.h"
+#include "intern.h"
+#include "diag.h"
+#include "source.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Unrecognized characters reported on this thread */
+static _Thread_local int unrecognized_count = 0;
+
+void tokens_report_unrecognized(uint32_t offset, char c) {
+    int line, column;
+    source_locate(offset, &line, &column);
+    fprintf(stderr, "Unrecognized character: %c at line %d, column %d\n", c, line, column);
+    unrecognized_count++;
+}
+
+int tokens_error_count(void) {
+    return unrecognized_count;
+}
+
+static void* grow_array(void* array, size_t capacity, size_t element_size) {
+    void* grown = realloc(array, capacity * element_size);
+    if (!grown) {
+        fprintf(stderr, "Failed to allocate memory for token buffer.\n");
+        exit(EXIT_FAILURE);
+    }
+    return grown;
+}
+
+void token_buffer_init(TokenBuffer* tokens) {
+    tokens->kind = NULL;
+    tokens->offset = NULL;
+    tokens->value = NULL;
+    tokens->count = 0;
+    tokens->capacity = 0;
+}
+
+void token_buffer_free(TokenBuffer* tokens) {
+    free(tokens->kind);
+    free(tokens->offset);
+    free(tokens->value);
+    token_buffer_init(tokens);
+}
+
+void token_buffer_reserve(TokenBuffer* tokens, size_t capacity) {
+    if (capacity <= tokens->capacity) return;
+    tokens->kind = (uint8_t*)grow_array(tokens->kind, capacity, sizeof(uint8_t));
+    tokens->offset = (uint32_t*)grow_array(tokens->offset, capacity, sizeof(uint32_t));
+    tokens->value = (uint32_t*)grow_array(tokens->value, capacity, sizeof(uint32_t));
+    tokens->capacity = capacity;
+}
+
+void tokens_lex_all(TokenBuffer* tokens, Lexer* lexer) {
+    YYSTYPE lval;
+    size_t n = tokens->count;
+    for (;;) {
+        if (n == tokens->capacity) {
+            token_buffer_reserve(tokens, tokens->capacity ? tokens->capacity * 2 : 4096);
+        }
+        int tok = lexer_lex(lexer, &lval);
+        uint32_t value = 0;
+        switch (tok) {
+            case ID:
+                value = atom_id(lval.string);
+                break;
+            case NUMBER:
+                value = (uint32_t)lval.number;
+                break;
+            case FLOAT_NUMBER:
+                memcpy(&value, &lval.float_number, sizeof(value));
+                break;
+            default:
+                break;
+        }
+        tokens->kind[n] = (uint8_t)(tok ? tok - TOKEN_KIND_BASE : 0);
+        tokens->offset[n] = lexer_token_offset(lexer);
+        tokens->value[n] = value;
+        n++;
+        if (tok == 0) break;
+    }
+    tokens->count = n;
+}
+
+/* One range of the input, lexed by one thread */
+typedef struct LexChunk {
+    const char* text;
+    size_t begin;
+    size_t end;
+    TokenBuffer tokens;
+} LexChunk;
+
+static void* lex_chunk(void* arg) {
+    LexChunk* chunk = (LexChunk*)arg;
+    /* Roughly one token per four bytes of source */
+    token_buffer_reserve(&chunk->tokens, (chunk->end - chunk->begin) / 4 + 16);
+    lexer_lex_range(chunk->text, chunk->begin, chunk->end, &chunk->tokens);
+    return NULL;
+}
+
+/* Append 'chunk' to 'tokens', interning identifiers and reporting
+   unrecognized characters in source order */
+static void append_chunk(TokenBuffer* tokens, const LexChunk* chunk) {
+    const TokenBuffer* in = &chunk->tokens;
+    size_t n = tokens->count;
+    for (size_t i = 0; i < in->count; i++) {
+        uint8_t kind = in->kind[i];
+        uint32_t value = in->value[i];
+        if (kind == TOKEN_KIND_UNRECOGNIZED) {
+            tokens_report_unrecognized(in->offset[i], chunk->text[in->offset[i]]);
+            continue;
+        }
+        if (kind + TOKEN_KIND_BASE == ID) {
+            value = atom_id(intern(chunk->text + in->offset[i], value));
+        }
+        tokens->kind[n] = kind;
+        tokens->offset[n] = in->offset[i];
+        tokens->value[n] = value;
+        n++;
+    }
+    tokens->count = n;
+}
+
+void tokens_lex_parallel(TokenBuffer* tokens, Lexer* lexer, int threads) {
+    const char* text;
+    size_t length;
+    if (lexer_input_text(lexer, &text, &length) != 0 || diag_enabled(DIAG_TRACE)) {
+        tokens_lex_all(tokens, lexer);
+        return;
+    }
+    if (threads < 1) threads = 1;
+
+    /* Split at the first newline after each equal share of the input;
+       no token spans a newline */
+    LexChunk* chunks = (LexChunk*)calloc((size_t)threads, sizeof(LexChunk));
+    pthread_t* workers = (pthread_t*)malloc((size_t)threads * sizeof(pthread_t));
+    if (!chunks || !workers) {
+        fprintf(stderr, "Failed to allocate memory for token buffer.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t begin = 0;
+    for (int t = 0; t < threads; t++) {
+        size_t end = length;
+        if (t + 1 < threads) {
+            end = length / (size_t)threads * (size_t)(t + 1);
+            if (end < begin) end = begin;
+            const char* newline = (const char*)memchr(text + end, '\n', length - end);
+            end = newline ? (size_t)(newline - text) + 1 : length;
+        }
+        chunks[t].text = text;
+        chunks[t].begin = begin;
+        chunks[t].end = end;
+        token_buffer_init(&chunks[t].tokens);
+        begin = end;
+    }
+
+    /* The calling thread lexes the first chunk itself */
+    for (int t = 1; t < threads; t++) {
+        if (pthread_create(&workers[t], NULL, lex_chunk, &chunks[t]) != 0) {
+            fprintf(stderr, "Failed to start lexer thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    lex_chunk(&chunks[0]);
+    for (int t = 1; t < threads; t++) {
+        pthread_join(workers[t], NULL);
+    }
+
+    size_t total = tokens->count + 1;
+    for (int t = 0; t < threads; t++) total += chunks[t].tokens.count;
+    token_buffer_reserve(tokens, total);
+
+    for (int t = 0; t < threads; t++) {
+        append_chunk(tokens, &chunks[t]);
+        token_buffer_free(&chunks[t].tokens);
+    }
+    free(chunks);
+    free(workers);
+
+    /* End of input, as the serial scanner reports it */
+    size_t n = tokens->count;
+    tokens->kind[n] = 0;
+    tokens->offset[n] = (uint32_t)length;
+    tokens->value[n] = 0;
+    tokens->count = n + 1;
+}
+
+void parse_context_init(ParseContext* ctx, Lexer* lexer) {
+    ctx->lexer = lexer;
+    ctx->replay = NULL;
+    ctx->replay_pos = 0;
+    ctx->current_kind = 0;
+    ctx->current_value = 0;
+    ctx->errors = 0;
+    ctx->ast_root = NULL;
+    ctx->on_function = NULL;
+    ctx->on_function_data = NULL;
+}
+
+void parse_context_add_function(ParseContext* ctx, ASTList* functions, ASTNode* function) {
+    if (!function) return;
+    if (ctx->on_function) {
+        ctx->on_function(function, ctx->on_function_data);
+    } else {
+        add_sibling(functions, function);
+    }
+}
+
+void tokens_replay(ParseContext* ctx, const TokenBuffer* tokens) {
+    ctx->replay = tokens;
+    ctx->replay_pos = 0;
+}
+
+int yylex(YYSTYPE* value, YYLTYPE* location, ParseContext* ctx) {
+    const TokenBuffer* replay = ctx->replay;
+    if (!replay) {
+        int tok = lexer_lex(ctx->lexer, value);
+        *location = lexer_token_offset(ctx->lexer);
+        return tok;
+    }
+
+    /* The buffer ends with the end-of-input token, which is repeated if
+       the parser asks again */
+    size_t i = ctx->replay_pos;
+    if (i + 1 < replay->count) ctx->replay_pos++;
+
+    int kind = replay->kind[i];
+    int tok = kind ? kind + TOKEN_KIND_BASE : 0;
+    uint32_t bits = replay->value[i];
+    switch (tok) {
+        case ID:
+            value->string = atom_by_id(bits);
+            break;
+        case NUMBER:
+            value->number = (int)bits;
+            break;
+        case FLOAT_NUMBER:
+            memcpy(&value->float_number, &bits, sizeof(bits));
+            break;
+        default:
+            break;
+    }
+    *location = replay->offset[i];
+    ctx->current_kind = tok;
+    ctx->current_value = bits;
+    return tok;
+}
+
+/* Fixed spelling of punctuation and keyword tokens */
+static const char* token_spelling(int tok) {
+    switch (tok) {
+        case TYPE_INT: return "int";
+        case TYPE_FLOAT: return "float";
+        case TYPE_CHAR: return "char";
+        case ASSIGNOP: return "=";
+        case OP_ADD: return "+";
+        case OP_SUB: return "-";
+        case OP_MUL: return "*";
+        case OP_DIV: return "/";
+        case SEMICOLON: return ";";
+        case WRITE: return "write";
+        case ARRAY: return "array";
+        case RETURN: return "return";
+        case MAIN: return "main";
+        case IF: return "if";
+        case ELSE: return "else";
+        case GT: return ">";
+        case LT: return "<";
+        case EQ: return "==";
+        case NE: return "!=";
+        case NOT: return "!";
+        case AND: return "&&";
+        case OR: return "||";
+        case GE: return ">=";
+        case LE: return "<=";
+        case LPAREN: return "(";
+        case RPAREN: return ")";
+        case LBRACE: return "{";
+        case RBRACE: return "}";
+        case LBRACKET: return "[";
+        case RBRACKET: return "]";
+        case COMMA: return ",";
+        case WHILE: return "while";
+        default: return "";
+    }
+}
+
+/* Token names as bison prints them in syntax errors */
+const char* token_kind_name(int token) {
+    switch (token) {
+        case 0: return "end of file";
+        case TYPE_INT: return "TYPE_INT";
+        case TYPE_FLOAT: return "TYPE_FLOAT";
+        case TYPE_CHAR: return "TYPE_CHAR";
+        case ASSIGNOP: return "ASSIGNOP";
+        case OP_ADD: return "OP_ADD";
+        case OP_SUB: return "OP_SUB";
+        case OP_MUL: return "OP_MUL";
+        case OP_DIV: return "OP_DIV";
+        case SEMICOLON: return "SEMICOLON";
+        case WRITE: return "WRITE";
+        case ARRAY: return "ARRAY";
+        case RETURN: return "RETURN";
+        case MAIN: return "MAIN";
+        case IF: return "IF";
+        case ELSE: return "ELSE";
+        case GT: return "GT";
+        case LT: return "LT";
+        case EQ: return "EQ";
+        case NE: return "NE";
+        case NOT: return "NOT";
+        case AND: return "AND";
+        case OR: return "OR";
+        case GE: return "GE";
+        case LE: return "LE";
+        case FLOAT_NUMBER: return "FLOAT_NUMBER";
+        case NUMBER: return "NUMBER";
+        case ID: return "ID";
+        case LPAREN: return "LPAREN";
+        case RPAREN: return "RPAREN";
+        case LBRACE: return "LBRACE";
+        case RBRACE: return "RBRACE";
+        case LBRACKET: return "LBRACKET";
+        case RBRACKET: return "RBRACKET";
+        case COMMA: return "COMMA";
+        case WHILE: return "WHILE";
+        default: return "invalid token";
+    }
+}
+
+const char* tokens_current_text(const ParseContext* ctx, int* length) {
+    if (!ctx->replay) {
+        return lexer_token_text(ctx->lexer, length);
+    }
+
+    static _Thread_local char literal[32];
+    uint32_t current_value = ctx->current_value;
+    const char* text;
+    switch (ctx->current_kind) {
+        case ID:
+            text = atom_by_id(current_value);
+            break;
+        case NUMBER:
+            snprintf(literal, sizeof(literal), "%d", (int)current_value);
+            text = literal;
+            break;
+        case FLOAT_NUMBER: {
+            float f;
+            memcpy(&f, &current_value, sizeof(f));
+            snprintf(literal, sizeof(literal), "%g", f);
+            text = literal;
+            break;
+        }
+        default:
+            text = token_spelling(ctx->current_kind);
+            break;
+    }
+    *length = (int)strlen(text);
+    return text;
+}
@@ -0,0 +1,71 @@
+/* tokens.h */
+
+#ifndef TOKENS_H
+#define TOKENS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Pre-lexed token stream, stored as a struct of arrays so the lexing
+ * loop only appends to a few flat arrays. Token i is
+ *   kind[i]   - bison token number minus TOKEN_KIND_BASE (0 = end of input)
+ *   offset[i] - byte offset of the token in the source (its location)
+ *   value[i]  - atom id (ID), integer value (NUMBER) or IEEE bits (FLOAT_NUMBER)
+ * The last token is always the end-of-input token.
+ */
+typedef struct TokenBuffer {
+    uint8_t* kind;
+    uint32_t* offset;
+    uint32_t* value;
+    size_t count;
+    size_t capacity;
+} TokenBuffer;
+
+/* Token numbers start just above 255; subtracting this keeps kinds in a byte */
+#define TOKEN_KIND_BASE 256
+
+/* Kind of an unrecognized character in a range being lexed in parallel */
+#define TOKEN_KIND_UNRECOGNIZED 255
+
+void token_buffer_init(TokenBuffer* tokens);
+void token_buffer_free(TokenBuffer* tokens);
+void token_buffer_reserve(TokenBuffer* tokens, size_t capacity);
+
+struct Lexer;
+struct ParseContext;
+union YYSTYPE;
+
+/* Run 'lexer' over its whole current input, filling 'tokens' */
+void tokens_lex_all(TokenBuffer* tokens, struct Lexer* lexer);
+
+/* Same token stream as tokens_lex_all(), but the input is split at
+   newlines into one range per thread and the ranges are lexed
+   concurrently, then concatenated.
+   Falls back to tokens_lex_all() when the scanner cannot lex ranges
+   or a token trace was requested. */
+void tokens_lex_parallel(TokenBuffer* tokens, struct Lexer* lexer, int threads);
+
+/* Report an unrecognized character at byte 'offset' of the source. The
+   scanners and the parallel lexer skip such characters after reporting
+   them through this. */
+void tokens_report_unrecognized(uint32_t offset, char c);
+
+/* Number of unrecognized characters reported on this thread */
+int tokens_error_count(void);
+
+/* Feed the parser from 'tokens' instead of the scanner; NULL switches back */
+void tokens_replay(struct ParseContext* ctx, const TokenBuffer* tokens);
+
+/* Token source for the pure parser: replays the context's TokenBuffer,
+   or pulls the next token from its scanner. Sets *value and *location. */
+int yylex(union YYSTYPE* value, uint32_t* location, struct ParseContext* ctx);
+
+/* Name of a token as bison prints it in syntax errors, e.g. "SEMICOLON";
+   0 is "end of file" */
+const char* token_kind_name(int token);
+
+/* Spelling of the token the parser saw last, for error messages */
+const char* tokens_current_text(const struct ParseContext* ctx, int* length);
+
+#endif /* TOKENS_H */
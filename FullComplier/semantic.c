@@ -9,19 +9,18 @@ TACList* tacList = NULL;
 // Counter for temporary variables
 static int tempCount = 0;
 
-// Mapping from variable names to their corresponding temporaries
-typedef struct VarTempMap {
-    char* varName;
-    char* tempName;
-    struct VarTempMap* next;
-} VarTempMap;
-
-static VarTempMap* varTempMapHead = NULL;
+// Temporaries of the variables, indexed like the symbol table's entries
+// (see symbolIndex); NULL for a variable not declared in the code yet
+static SymbolTable* varTable = NULL;
+static char** varTemps = NULL;
+static int varTempCapacity = 0;
 
 // Initialize semantic analysis
 void initializeSemantic(SymbolTable* symbolTable) {
     tempCount = 0;
-    varTempMapHead = NULL;
+    varTable = symbolTable;
+    varTemps = NULL;
+    varTempCapacity = 0;
     tacList = createTACList(); // Initialize TAC list
 }
 
@@ -112,36 +111,44 @@ char* newTemp() {
 
 // Map a variable name to a temporary variable
 void addVarTempMapping(const char* varName, const char* tempName) {
-    VarTempMap* newMapping = (VarTempMap*)malloc(sizeof(VarTempMap));
-    newMapping->varName = strdup(varName);
-    newMapping->tempName = strdup(tempName);
-    newMapping->next = varTempMapHead;
-    varTempMapHead = newMapping;
+    SymbolTableEntry* entry = findSymbol(varTable, varName);
+    if (!entry) {
+        fprintf(stderr, "Error: Undeclared variable '%s'\n", varName);
+        exit(EXIT_FAILURE);
+    }
+    int index = symbolIndex(varTable, entry);
+    if (index >= varTempCapacity) {
+        int capacity = varTempCapacity ? varTempCapacity : 64;
+        while (capacity <= index) capacity *= 2;
+        char** grown = (char**)realloc(varTemps, sizeof(char*) * capacity);
+        if (!grown) {
+            perror("Failed to allocate memory for variable temporaries");
+            exit(EXIT_FAILURE);
+        }
+        memset(grown + varTempCapacity, 0, sizeof(char*) * (capacity - varTempCapacity));
+        varTemps = grown;
+        varTempCapacity = capacity;
+    }
+    free(varTemps[index]);
+    varTemps[index] = strdup(tempName);
 }
 
 // Get the temporary variable for a given variable name
 char* getTempForVar(const char* varName) {
-    VarTempMap* current = varTempMapHead;
-    while (current != NULL) {
-        if (strcmp(current->varName, varName) == 0) {
-            return current->tempName;
-        }
-        current = current->next;
-    }
-    return NULL;
+    SymbolTableEntry* entry = findSymbol(varTable, varName);
+    if (!entry) return NULL;
+    int index = symbolIndex(varTable, entry);
+    return index < varTempCapacity ? varTemps[index] : NULL;
 }
 
 // Free the variable-to-temporary mappings
 void freeVarTempMap() {
-    VarTempMap* current = varTempMapHead;
-    while (current != NULL) {
-        VarTempMap* temp = current;
-        current = current->next;
-        free(temp->varName);
-        free(temp->tempName);
-        free(temp);
+    for (int i = 0; i < varTempCapacity; i++) {
+        free(varTemps[i]);
     }
-    varTempMapHead = NULL;
+    free(varTemps);
+    varTemps = NULL;
+    varTempCapacity = 0;
 }
 
 // Recursive function to generate code for expressions
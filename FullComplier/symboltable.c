@@ -2,58 +2,139 @@
 #include <stdlib.h>
 #include <string.h>
 
+#define NAME_BLOCK_SIZE 65536
+
+// FNV-1a hash of a name
+static unsigned hashName(const char* name) {
+    unsigned hash = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)name; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+static void* allocate(size_t size, const char* what) {
+    void* memory = malloc(size);
+    if (!memory) {
+        fprintf(stderr, "Memory allocation failed for %s\n", what);
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+// Copy a name into the name pool
+static const char* internName(SymbolTable* table, const char* name) {
+    size_t length = strlen(name) + 1;
+    NameBlock* block = table->names;
+    if (!block || block->size - block->used < length) {
+        size_t size = length > NAME_BLOCK_SIZE ? length : NAME_BLOCK_SIZE;
+        block = (NameBlock*)allocate(sizeof(NameBlock) + size, "symbol names");
+        block->next = table->names;
+        block->used = 0;
+        block->size = size;
+        table->names = block;
+    }
+    char* copy = block->text + block->used;
+    memcpy(copy, name, length);
+    block->used += length;
+    return copy;
+}
+
+// Slot holding 'name', or the empty slot where it would go
+static int* findSlot(const SymbolTable* table, const char* name, unsigned hash) {
+    unsigned mask = (unsigned)table->slotCount - 1;
+    for (unsigned i = hash & mask; ; i = (i + 1) & mask) {
+        int* slot = &table->slots[i];
+        if (*slot == 0) return slot;
+        const SymbolTableEntry* entry = &table->entries[*slot - 1];
+        if (entry->hash == hash && strcmp(entry->name, name) == 0) return slot;
+    }
+}
+
+// Double the slots and put every entry back
+static void growSlots(SymbolTable* table) {
+    free(table->slots);
+    table->slotCount = table->slotCount ? table->slotCount * 2 : 64;
+    table->slots = (int*)allocate(sizeof(int) * table->slotCount, "symbol table");
+    memset(table->slots, 0, sizeof(int) * table->slotCount);
+    for (int i = 0; i < table->count; i++) {
+        SymbolTableEntry* entry = &table->entries[i];
+        *findSlot(table, entry->name, entry->hash) = i + 1;
+    }
+}
+
 // Initialize the symbol table
 void initializeSymbolTable(SymbolTable* table) {
-    table->head = NULL;
+    table->entries = NULL;
+    table->count = table->capacity = 0;
+    table->slots = NULL;
+    table->slotCount = 0;
+    table->names = NULL;
 }
 
 // Add a symbol to the symbol table
 // Returns 0 on success, -1 if the symbol already exists
 int addSymbol(SymbolTable* table, const char* name, const char* type, int line) {
+    // Keep the slots at most half full
+    if (2 * (table->count + 1) > table->slotCount) {
+        growSlots(table);
+    }
+
     // Check if the symbol already exists
-    if (findSymbol(table, name) != NULL) {
+    unsigned hash = hashName(name);
+    int* slot = findSlot(table, name, hash);
+    if (*slot != 0) {
         return -1; // Symbol already declared
     }
 
     // Create a new symbol table entry
-    SymbolTableEntry* newEntry = (SymbolTableEntry*)malloc(sizeof(SymbolTableEntry));
-    if (!newEntry) {
-        fprintf(stderr, "Memory allocation failed for symbol '%s'\n", name);
-        exit(EXIT_FAILURE);
+    if (table->count == table->capacity) {
+        int capacity = table->capacity ? table->capacity * 2 : 64;
+        SymbolTableEntry* grown = (SymbolTableEntry*)realloc(table->entries, sizeof(SymbolTableEntry) * capacity);
+        if (!grown) {
+            fprintf(stderr, "Memory allocation failed for symbol '%s'\n", name);
+            exit(EXIT_FAILURE);
+        }
+        table->entries = grown;
+        table->capacity = capacity;
     }
-
-    newEntry->name = strdup(name);
-    newEntry->type = strdup(type);
+    SymbolTableEntry* newEntry = &table->entries[table->count];
+    newEntry->name = internName(table, name);
+    newEntry->type = strcmp(type, "char") == 0 ? SYMBOL_CHAR : SYMBOL_INT;
     newEntry->line = line;
-    newEntry->next = table->head;
-    table->head = newEntry;
+    newEntry->hash = hash;
+    *slot = ++table->count;
 
     return 0; // Success
 }
 
 // Find a symbol in the symbol table
 SymbolTableEntry* findSymbol(SymbolTable* table, const char* name) {
-    SymbolTableEntry* current = table->head;
-    while (current != NULL) {
-        if (strcmp(current->name, name) == 0) {
-            return current; // Found
-        }
-        current = current->next;
+    if (table->count == 0) {
+        return NULL; // Not found
     }
-    return NULL; // Not found
+    int slot = *findSlot(table, name, hashName(name));
+    return slot ? &table->entries[slot - 1] : NULL;
+}
+
+int symbolIndex(const SymbolTable* table, const SymbolTableEntry* entry) {
+    return (int)(entry - table->entries);
 }
 
-// Print the symbol table
+const char* symbolTypeName(SymbolType type) {
+    return type == SYMBOL_CHAR ? "char" : "int";
+}
+
+// Print the symbol table, most recent declaration first
 void printSymbolTable(const SymbolTable* table) {
     printf("\nSymbol Table:\n");
     printf("-------------------------------------------------\n");
     printf("| %-20s | %-10s | %-10s |\n", "Name", "Type", "Line");
     printf("-------------------------------------------------\n");
 
-    SymbolTableEntry* current = table->head;
-    while (current != NULL) {
-        printf("| %-20s | %-10s | %-10d |\n", current->name, current->type, current->line);
-        current = current->next;
+    for (int i = table->count - 1; i >= 0; i--) {
+        const SymbolTableEntry* current = &table->entries[i];
+        printf("| %-20s | %-10s | %-10d |\n", current->name, symbolTypeName(current->type), current->line);
     }
 
     printf("-------------------------------------------------\n");
@@ -61,14 +142,12 @@ void printSymbolTable(const SymbolTable* table) {
 
 // Free the symbol table
 void freeSymbolTable(SymbolTable* table) {
-    SymbolTableEntry* current = table->head;
-    while (current != NULL) {
-        SymbolTableEntry* temp = current;
-        current = current->next;
-        free(temp->name);
-        free(temp->type);
-        free(temp);
+    while (table->names) {
+        NameBlock* block = table->names;
+        table->names = block->next;
+        free(block);
     }
-    table->head = NULL;
+    free(table->entries);
+    free(table->slots);
+    initializeSymbolTable(table);
 }
-
@@ -3,25 +3,48 @@
 
 #include <stdio.h>
 
+// Type of a variable
+typedef enum {
+    SYMBOL_INT,
+    SYMBOL_CHAR
+} SymbolType;
+
 // Define the structure for a symbol table entry
 typedef struct SymbolTableEntry {
-    char* name;             // Variable name
-    char* type;             // Variable type ("int" or "char")
+    const char* name;       // Variable name, interned in the table's name pool
+    SymbolType type;        // Variable type
     int line;               // Declaration line number
-    struct SymbolTableEntry* next; // Pointer to the next entry
+    unsigned hash;          // Hash of the name
 } SymbolTableEntry;
 
-// Define the symbol table as a pointer to the first entry
+// Block of the name pool; names never move once stored
+typedef struct NameBlock {
+    struct NameBlock* next;
+    size_t used;
+    size_t size;
+    char text[];
+} NameBlock;
+
+// Define the symbol table: entries in declaration order, indexed by an
+// open-addressing hash table of entry positions
 typedef struct {
-    SymbolTableEntry* head;
+    SymbolTableEntry* entries;
+    int count;
+    int capacity;
+    int* slots;             // Entry index + 1, or 0 for an empty slot
+    int slotCount;          // A power of two, at least twice count
+    NameBlock* names;
 } SymbolTable;
 
 // Function prototypes
 void initializeSymbolTable(SymbolTable* table);
 int addSymbol(SymbolTable* table, const char* name, const char* type, int line);
+// The entry is valid until the next addSymbol
 SymbolTableEntry* findSymbol(SymbolTable* table, const char* name);
+// Position of an entry in declaration order, from 0 to count - 1
+int symbolIndex(const SymbolTable* table, const SymbolTableEntry* entry);
+const char* symbolTypeName(SymbolType type);
 void printSymbolTable(const SymbolTable* table);
 void freeSymbolTable(SymbolTable* table);
 
 #endif // SYMBOLTABLE_H
-